@@ -0,0 +1,440 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Microbenchmarks of the per-frame kernels on synthetic frames at QCIF, VGA, 1080p and 4K. Every case
+ * reports frame pairs (or frames) per second as pixels per second. --json writes the results, one
+ * benchmark per line, and --baseline compares against such a file written earlier.
+ *
+ *   openvq_bench --sizes vga,1080p --json baseline.json
+ *   openvq_bench --baseline baseline.json --tolerance 0.05
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+#include <io/Json.h>
+#include <io/Logger.h>
+#include <io/SyntheticSequence.h>
+#include <io/VideoSequence.h>
+#include <io/Y4mWriter.h>
+#include <metrics/Metrics.h>
+#include <metrics/common/alignment/ColourAlignment.h>
+#include <metrics/common/alignment/SpatialAlignment.h>
+#include <metrics/opvq/OPVQ.h>
+#include <metrics/opvq/analysis/EdginessImage.h>
+
+namespace opts = boost::program_options;
+
+
+namespace {
+    struct Resolution {
+        const char *name;
+        int width;
+        int height;
+    };
+
+    const Resolution resolutions[] = {
+            {"qcif",  176,  144},
+            {"vga",   640,  480},
+            {"1080p", 1920, 1080},
+            {"4k",    3840, 2160}
+    };
+
+    /* Frames cycled through by every case, each pair differing in content and motion */
+    const unsigned FRAME_COUNT = 4;
+
+    struct Frames {
+        Resolution res;
+        std::vector<std::shared_ptr<Frame> > src;
+        std::vector<std::shared_ptr<Frame> > pvs;
+    };
+
+    /* Runs one iteration on frame i % FRAME_COUNT */
+    typedef std::function<void(unsigned i)> Body;
+
+    struct Case {
+        std::string name;
+        std::function<Body(const Frames &frames, const std::string &tmpDir)> setup;
+    };
+
+    struct Result {
+        std::string name;
+        std::uint64_t iterations;
+        double nsPerIteration;
+        double pixelsPerSecond;
+    };
+
+    /*
+     * Frames of the panning texture that opens a synthetic sequence, and PVS frames derived from them by
+     * blurring and adding noise, as a coded sequence would
+     */
+    Frames syntheticFrames(const Resolution &res) {
+        Frames frames;
+        frames.res = res;
+        SyntheticSequence sequence(res.width, res.height, 4 * FRAME_COUNT, 0x6f7671);
+        std::vector<SyntheticSequence::Distortion> distortions = SyntheticSequence::parseDistortions("blur:0.8+noise:3");
+        for (unsigned t = 0; t < FRAME_COUNT; t++) {
+            frames.src.push_back(std::make_shared<Frame>(sequence.source(t)));
+            frames.pvs.push_back(std::make_shared<Frame>(sequence.processed(t, distortions)));
+        }
+        return frames;
+    }
+
+    /* SRC frames as a 4:2:0 YUV4MPEG2 file */
+    std::string writeY4m(const Frames &frames, const std::string &tmpDir) {
+        std::string path = tmpDir + "/openvq_bench_" + frames.res.name + ".y4m";
+        Y4mWriter writer(path, frames.res.width, frames.res.height, 25, true);
+        for (auto &src : frames.src) {
+            writer.write(*src);
+        }
+        writer.close();
+        return path;
+    }
+
+    /* Full reference algorithm set up for frames of the given size, fed through the analysis steps */
+    std::shared_ptr<FullReferenceAlgorithm> attachedAlgorithm(const std::string &command, const Resolution &res,
+                                                              std::vector<std::string> options) {
+        std::unique_ptr<Algorithm> created = Metrics::getAlgorithm(command);
+        std::shared_ptr<FullReferenceAlgorithm> algorithm(dynamic_cast<FullReferenceAlgorithm *>(created.release()));
+
+        std::vector<std::string> args = {"openvq", "-s", "src", "-p", "pvs"};
+        args.insert(args.end(), options.begin(), options.end());
+        std::vector<const char *> argv;
+        for (auto &arg : args) {
+            argv.push_back(arg.c_str());
+        }
+        algorithm->parseOptions(static_cast<int>(argv.size()), argv.data());
+
+        VideoInfo info;
+        info.width = res.width;
+        info.height = res.height;
+        info.duration = 0;
+        info.frame_count = FRAME_COUNT;
+        info.filename = "";
+        info.avg_framerate = 25;
+        algorithm->attach(info);
+        algorithm->initAnalysis();
+        return algorithm;
+    }
+
+    std::vector<std::shared_ptr<Frame> > edginessImages(const std::vector<std::shared_ptr<Frame> > &frames) {
+        std::vector<std::shared_ptr<Frame> > edges;
+        for (auto &frame : frames) {
+            edges.push_back(EdginessImage::createEdginessImage(frame));
+        }
+        return edges;
+    }
+
+    std::vector<Case> cases() {
+        std::vector<Case> all;
+        all.push_back({"edginess_image", [](const Frames &f, const std::string &) -> Body {
+            return [&f](unsigned i) {
+                EdginessImage::createEdginessImage(FullReferenceAlgorithm::view(f.src[i % FRAME_COUNT]));
+            };
+        }});
+        all.push_back({"luminance_indicator", [](const Frames &f, const std::string &) -> Body {
+            auto indicator = std::make_shared<LuminanceIndicator>(FRAME_COUNT, f.res.width, f.res.height);
+            auto srcEdges = edginessImages(f.src);
+            auto pvsEdges = edginessImages(f.pvs);
+            return [&f, indicator, srcEdges, pvsEdges](unsigned i) {
+                unsigned t = i % FRAME_COUNT;
+                indicator->analyzeFrame(f.src[t], f.pvs[t], srcEdges[t], pvsEdges[t], t);
+            };
+        }});
+        all.push_back({"chrominance_indicator", [](const Frames &f, const std::string &) -> Body {
+            auto indicator = std::make_shared<ChrominanceIndicator>(FRAME_COUNT, f.res.width, f.res.height);
+            auto srcEdges = edginessImages(f.src);
+            auto pvsEdges = edginessImages(f.pvs);
+            return [&f, indicator, srcEdges, pvsEdges](unsigned i) {
+                unsigned t = i % FRAME_COUNT;
+                indicator->analyzeFrame(f.src[t], f.pvs[t], srcEdges[t], pvsEdges[t], t);
+            };
+        }});
+        all.push_back({"temporal_indicators", [](const Frames &f, const std::string &) -> Body {
+            auto indicators = std::make_shared<TemporalVariabilityIndicators>(FRAME_COUNT);
+            return [&f, indicators](unsigned i) {
+                unsigned t = 1 + i % (FRAME_COUNT - 1);
+                indicators->analyzeFrame(f.src[t], f.pvs[t], f.src[t - 1], f.pvs[t - 1], t);
+            };
+        }});
+        all.push_back({"spatial_offset", [](const Frames &f, const std::string &) -> Body {
+            auto alignment = std::make_shared<SpatialAlignment>(FRAME_COUNT);
+            VideoInfo info;
+            info.width = f.res.width;
+            info.height = f.res.height;
+            int crop = OPVQ::resolutionData(info).crop;
+            return [&f, alignment, crop](unsigned i) {
+                unsigned t = i % FRAME_COUNT;
+                alignment->spatialOffsetDetermination(FullReferenceAlgorithm::view(f.src[t]),
+                                                      FullReferenceAlgorithm::view(f.pvs[t]), crop);
+            };
+        }});
+        all.push_back({"colour_histograms", [](const Frames &f, const std::string &) -> Body {
+            auto alignment = std::make_shared<ColourAlignment>(FRAME_COUNT);
+            return [&f, alignment](unsigned i) {
+                unsigned t = i % FRAME_COUNT;
+                alignment->analyzeFrame(f.pvs[t], t);
+            };
+        }});
+        all.push_back({"colour_correction", [](const Frames &f, const std::string &) -> Body {
+            ColourAlignment srcColour(FRAME_COUNT), pvsColour(FRAME_COUNT);
+            for (unsigned t = 0; t < FRAME_COUNT; t++) {
+                srcColour.analyzeFrame(f.src[t], t);
+                pvsColour.analyzeFrame(f.pvs[t], t);
+            }
+            srcColour.createCumulative(f.res.width, f.res.height);
+            pvsColour.createCumulative(f.res.width, f.res.height);
+            auto curves = std::make_shared<std::vector<cv::Mat> >(
+                    ColourAlignment::createCorrectionCurves(srcColour, pvsColour));
+            // Corrected in place, the result doesn't change the time taken
+            auto scratch = std::make_shared<std::vector<std::shared_ptr<Frame> > >();
+            for (auto &pvs : f.pvs) {
+                scratch->push_back(std::make_shared<Frame>(pvs->Y.clone(), pvs->U.clone(), pvs->V.clone()));
+            }
+            return [scratch, curves](unsigned i) {
+                ColourAlignment::applyCorrectionCurve((*scratch)[i % FRAME_COUNT], *curves);
+            };
+        }});
+        all.push_back({"ssim_frame", [](const Frames &f, const std::string &) -> Body {
+            auto ssim = attachedAlgorithm("ssim", f.res, {"--disable-spatial-alignment"});
+            return [&f, ssim](unsigned i) {
+                unsigned t = i % FRAME_COUNT;
+                ssim->analysisFrame(FullReferenceAlgorithm::view(f.src[t]), FullReferenceAlgorithm::view(f.pvs[t]),
+                                    nullptr, nullptr, t);
+            };
+        }});
+        all.push_back({"psnr_frame", [](const Frames &f, const std::string &) -> Body {
+            auto psnr = attachedAlgorithm("psnr", f.res, {"--disable-spatial-alignment"});
+            return [&f, psnr](unsigned i) {
+                unsigned t = i % FRAME_COUNT;
+                psnr->analysisFrame(FullReferenceAlgorithm::view(f.src[t]), FullReferenceAlgorithm::view(f.pvs[t]),
+                                    nullptr, nullptr, t);
+            };
+        }});
+        all.push_back({"vif_frame", [](const Frames &f, const std::string &) -> Body {
+            auto vif = attachedAlgorithm("vif", f.res, {"--disable-spatial-alignment"});
+            return [&f, vif](unsigned i) {
+                unsigned t = i % FRAME_COUNT;
+                vif->analysisFrame(FullReferenceAlgorithm::view(f.src[t]), FullReferenceAlgorithm::view(f.pvs[t]),
+                                   nullptr, nullptr, t);
+            };
+        }});
+        all.push_back({"decode_frame", [](const Frames &f, const std::string &tmpDir) -> Body {
+            std::string path = writeY4m(f, tmpDir);
+            auto sequence = std::make_shared<VideoSequence>();
+            sequence->init(path, FRAME_COUNT, AV_PIX_FMT_YUV444P);
+            std::remove(path.c_str());
+            return [sequence](unsigned) {
+                if (!sequence->nextFrame()) {
+                    sequence->rewind();
+                    sequence->nextFrame();
+                }
+            };
+        }});
+        return all;
+    }
+
+    Result measure(const std::string &name, const Body &body, std::size_t pixels, double minSeconds) {
+        typedef std::chrono::steady_clock Clock;
+        body(0);
+
+        std::uint64_t iterations = 0;
+        std::uint64_t batch = 1;
+        double seconds = 0;
+        while (seconds < minSeconds) {
+            Clock::time_point start = Clock::now();
+            for (std::uint64_t i = 0; i < batch; i++) {
+                body(static_cast<unsigned>(iterations + i));
+            }
+            seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            iterations += batch;
+            batch *= 2;
+        }
+        return {name, iterations, seconds * 1e9 / iterations, iterations * static_cast<double>(pixels) / seconds};
+    }
+
+    void writeJson(const std::string &path, const std::vector<Result> &results) {
+        std::ofstream out(path);
+        out << "{\"benchmarks\": [" << std::endl;
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const Result &r = results[i];
+            out << "{\"name\": " << Json::string(r.name) << ", \"iterations\": " << r.iterations
+                << ", \"ns_per_iteration\": " << Json::number(r.nsPerIteration)
+                << ", \"pixels_per_second\": " << Json::number(r.pixelsPerSecond) << "}"
+                << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        out << "]}" << std::endl;
+        if (!out) {
+            throw std::runtime_error("Could not write " + path);
+        }
+    }
+
+    /* Pixels per second by name, from a file written by writeJson() */
+    std::map<std::string, double> readBaseline(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) {
+            throw std::runtime_error("Could not open " + path);
+        }
+        static const std::string nameKey = "\"name\": \"";
+        static const std::string valueKey = "\"pixels_per_second\": ";
+        std::map<std::string, double> baseline;
+        std::string line;
+        while (std::getline(in, line)) {
+            std::size_t name = line.find(nameKey);
+            std::size_t value = line.find(valueKey);
+            if (name == std::string::npos || value == std::string::npos)
+                continue;
+            name += nameKey.size();
+            try {
+                baseline[line.substr(name, line.find('"', name) - name)] = std::stod(line.substr(value + valueKey.size()));
+            } catch (std::exception &) {
+                // null for a case that didn't run
+            }
+        }
+        return baseline;
+    }
+
+    std::set<std::string> split(const std::string &list) {
+        std::vector<std::string> items;
+        boost::algorithm::split(items, list, boost::algorithm::is_any_of(","));
+        return std::set<std::string>(items.begin(), items.end());
+    }
+}
+
+
+int main(int argc, const char *argv[]) {
+    opts::options_description desc("openvq_bench options");
+    desc.add_options()
+            ("help,h", "Print help message")
+            ("filter", opts::value<std::string>()->default_value(""), "Only run cases whose name contains this")
+            ("sizes", opts::value<std::string>()->default_value("qcif,vga,1080p,4k"),
+             "Resolutions to run {qcif,vga,1080p,4k}, comma separated")
+            ("min-time", opts::value<double>()->default_value(0.5), "Seconds to run each case for at least")
+            ("json", opts::value<std::string>(), "Write the results to this file")
+            ("baseline", opts::value<std::string>(), "Compare against results written by --json before")
+            ("tolerance", opts::value<double>()->default_value(0.1),
+             "Fraction of the baseline throughput a case may lose before it counts as a regression")
+            ("tmp-dir", opts::value<std::string>()->default_value("/tmp"),
+             "Directory for the file decode_frame reads");
+
+    opts::variables_map vm;
+    try {
+        opts::store(opts::parse_command_line(argc, argv, desc), vm);
+        opts::notify(vm);
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl << desc;
+        return 1;
+    }
+    if (vm.count("help")) {
+        std::cout << desc;
+        return 0;
+    }
+
+    std::string warn = "warn";
+    Logger::setThreshold(warn);
+    av_register_all();
+
+    std::set<std::string> sizes = split(vm["sizes"].as<std::string>());
+    std::string filter = vm["filter"].as<std::string>();
+    double minSeconds = vm["min-time"].as<double>();
+
+    std::cout << std::left << std::setw(32) << "CASE" << std::right << std::setw(12) << "ITERATIONS"
+              << std::setw(14) << "US/ITERATION" << std::setw(14) << "MPIXELS/S" << std::endl;
+    std::vector<Result> results;
+    for (const Resolution &res : resolutions) {
+        if (!sizes.count(res.name))
+            continue;
+        Frames frames = syntheticFrames(res);
+        for (const Case &c : cases()) {
+            std::string name = c.name + "/" + res.name;
+            if (name.find(filter) == std::string::npos)
+                continue;
+            try {
+                Body body = c.setup(frames, vm["tmp-dir"].as<std::string>());
+                results.push_back(measure(name, body, static_cast<std::size_t>(res.width) * res.height, minSeconds));
+            } catch (std::exception &e) {
+                std::cerr << name << ": " << e.what() << std::endl;
+                continue;
+            }
+            const Result &r = results.back();
+            std::cout << std::left << std::setw(32) << r.name << std::right << std::setw(12) << r.iterations
+                      << std::fixed << std::setprecision(1) << std::setw(14) << r.nsPerIteration / 1e3
+                      << std::setw(14) << r.pixelsPerSecond / 1e6 << std::endl;
+        }
+    }
+
+    /* VIF is meant to stay within 2x of PSNR's per-frame time */
+    for (const Resolution &res : resolutions) {
+        const Result *vif = nullptr, *psnr = nullptr;
+        for (const Result &r : results) {
+            if (r.name == std::string("vif_frame/") + res.name)
+                vif = &r;
+            if (r.name == std::string("psnr_frame/") + res.name)
+                psnr = &r;
+        }
+        if (vif && psnr && psnr->nsPerIteration > 0) {
+            std::cout << "vif_frame/psnr_frame time at " << res.name << ": " << std::fixed << std::setprecision(2)
+                      << vif->nsPerIteration / psnr->nsPerIteration << "x" << std::endl;
+        }
+    }
+
+    if (vm.count("json")) {
+        writeJson(vm["json"].as<std::string>(), results);
+    }
+
+    int regressions = 0;
+    if (vm.count("baseline")) {
+        std::map<std::string, double> baseline = readBaseline(vm["baseline"].as<std::string>());
+        double tolerance = vm["tolerance"].as<double>();
+        std::cout << std::endl << std::left << std::setw(32) << "CASE" << std::right << std::setw(14) << "BASELINE"
+                  << std::setw(14) << "NOW" << std::setw(10) << "CHANGE" << std::endl;
+        for (const Result &r : results) {
+            auto base = baseline.find(r.name);
+            if (base == baseline.end() || base->second <= 0)
+                continue;
+            double change = r.pixelsPerSecond / base->second - 1;
+            bool regressed = change < -tolerance;
+            regressions += regressed;
+            std::cout << std::left << std::setw(32) << r.name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(14) << base->second / 1e6 << std::setw(14) << r.pixelsPerSecond / 1e6
+                      << std::setw(9) << std::showpos << change * 100 << std::noshowpos << "%"
+                      << (regressed ? "  REGRESSION" : "") << std::endl;
+        }
+        if (regressions) {
+            std::cout << regressions << " case(s) slower than the baseline by more than "
+                      << tolerance * 100 << "%" << std::endl;
+        }
+    }
+    return regressions ? 2 : 0;
+}
@@ -56,6 +56,19 @@ if (NOT OpenCV_FOUND)
 endif ()
 message (STATUS "Found OpenCV version ${OpenCV_VERSION}")
 
+#
+# SQLite, optional, for --sqlite result databases
+#
+find_library (LIBSQLITE3 sqlite3)
+find_path (SQLITE3_INCLUDE_DIR sqlite3.h)
+if (LIBSQLITE3 AND SQLITE3_INCLUDE_DIR)
+  add_definitions (-DOPENVQ_SQLITE)
+  include_directories (${SQLITE3_INCLUDE_DIR})
+  message (STATUS "Found SQLite: ${LIBSQLITE3}")
+else ()
+  message (STATUS "SQLite not found, building without --sqlite")
+endif ()
+
 # UNIX specific dependencies
 if (NOT WIN32)
   find_library (LIBZ z)
@@ -0,0 +1,372 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Python module openvq over the C interface of libopenvq. Frames are uint8 arrays in planar YUV 4:4:4
+ * layout, shape (3, height, width), or (n, 3, height, width) for batches, taken through the buffer
+ * protocol without copying; numpy arrays qualify as long as each row is contiguous.
+ *
+ *   stream = openvq.Stream("psnr", width, height, frames)
+ *   stream.push_batch(src, pvs)            # analysed on the thread pool, without holding the GIL
+ *   numpy.asarray(stream.frame_values())   # (frames, len(stream.frame_value_names))
+ *   stream.finish()                        # {"psnr_y": ..., ...}
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <string>
+#include <vector>
+
+#include <api/openvq.h>
+
+
+struct StreamObject {
+    PyObject_HEAD
+    openvq_context *ctx;
+    int width;
+    int height;
+    /* The frames pushed last, which the analysis of the next frame looks back at */
+    Py_buffer lastSrc;
+    Py_buffer lastPvs;
+    bool holding;
+};
+
+static PyObject *raiseLastError() {
+    PyErr_SetString(PyExc_RuntimeError, openvq_last_error());
+    return NULL;
+}
+
+static void releaseLast(StreamObject *self) {
+    if (self->holding) {
+        PyBuffer_Release(&self->lastSrc);
+        PyBuffer_Release(&self->lastPvs);
+        self->holding = false;
+    }
+}
+
+/* Fills frames from obj, which must have ndim dimensions. view must be released by the caller on success */
+static bool getFrames(PyObject *obj, Py_buffer *view, int ndim, int width, int height,
+                      std::vector<openvq_frame> &frames) {
+    if (PyObject_GetBuffer(obj, view, PyBUF_STRIDES | PyBUF_FORMAT) < 0)
+        return false;
+
+    const char *error = NULL;
+    if (view->itemsize != 1 || (view->format && std::string(view->format) != "B")) {
+        error = "frames must be uint8 arrays";
+    } else if (view->ndim != ndim) {
+        error = ndim == 3 ? "a frame must have the shape (3, height, width)"
+                          : "frames must have the shape (n, 3, height, width)";
+    } else if (view->shape[ndim - 3] != 3 || view->shape[ndim - 2] != height || view->shape[ndim - 1] != width) {
+        error = "frame size doesn't match the stream";
+    } else if (view->strides[ndim - 1] != 1 || view->strides[ndim - 2] < width) {
+        error = "frame rows must be contiguous";
+    }
+    if (error) {
+        PyBuffer_Release(view);
+        PyErr_SetString(PyExc_ValueError, error);
+        return false;
+    }
+
+    Py_ssize_t count = ndim == 4 ? view->shape[0] : 1;
+    frames.resize(count);
+    for (Py_ssize_t i = 0; i < count; i++) {
+        const uint8_t *frame = static_cast<const uint8_t *>(view->buf) + (ndim == 4 ? i * view->strides[0] : 0);
+        for (int p = 0; p < 3; p++) {
+            frames[i].data[p] = frame + p * view->strides[ndim - 3];
+            frames[i].stride[p] = static_cast<int>(view->strides[ndim - 2]);
+        }
+    }
+    return true;
+}
+
+/* Writable memoryview of doubles with the given shape, which numpy.asarray() takes without copying */
+static PyObject *doubles(const std::vector<double> &values, Py_ssize_t rows, Py_ssize_t columns) {
+    PyObject *bytes = PyByteArray_FromStringAndSize(reinterpret_cast<const char *>(values.data()),
+                                                    static_cast<Py_ssize_t>(values.size() * sizeof(double)));
+    if (!bytes)
+        return NULL;
+    PyObject *view = PyMemoryView_FromObject(bytes);
+    Py_DECREF(bytes);
+    if (!view)
+        return NULL;
+    PyObject *shaped = rows < 0 ? PyObject_CallMethod(view, "cast", "s", "d")
+                                : PyObject_CallMethod(view, "cast", "s(nn)", "d", rows, columns);
+    Py_DECREF(view);
+    return shaped;
+}
+
+static PyObject *names(const openvq_context *ctx, int count, const char *(*name)(const openvq_context *, int)) {
+    PyObject *tuple = PyTuple_New(count);
+    for (int i = 0; tuple && i < count; i++) {
+        PyTuple_SET_ITEM(tuple, i, PyUnicode_FromString(name(ctx, i)));
+    }
+    return tuple;
+}
+
+static int Stream_init(StreamObject *self, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"metric", "width", "height", "frames", "options", NULL};
+    const char *metric;
+    int frameCount;
+    PyObject *options = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "siii|O", const_cast<char **>(keywords), &metric,
+                                     &self->width, &self->height, &frameCount, &options))
+        return -1;
+
+    std::vector<std::string> optionStrings;
+    if (options) {
+        PyObject *sequence = PySequence_Fast(options, "options must be a sequence of strings");
+        if (!sequence)
+            return -1;
+        for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); i++) {
+            const char *option = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(sequence, i));
+            if (!option) {
+                Py_DECREF(sequence);
+                return -1;
+            }
+            optionStrings.push_back(option);
+        }
+        Py_DECREF(sequence);
+    }
+    std::vector<const char *> argv;
+    for (auto &option : optionStrings) {
+        argv.push_back(option.c_str());
+    }
+
+    releaseLast(self);
+    openvq_destroy(self->ctx);
+    self->ctx = openvq_create(metric, self->width, self->height, frameCount, static_cast<int>(argv.size()),
+                              argv.data());
+    if (!self->ctx) {
+        raiseLastError();
+        return -1;
+    }
+    return 0;
+}
+
+static void Stream_dealloc(StreamObject *self) {
+    releaseLast(self);
+    openvq_destroy(self->ctx);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+static bool checkContext(StreamObject *self) {
+    if (!self->ctx) {
+        PyErr_SetString(PyExc_RuntimeError, "stream is not initialised");
+        return false;
+    }
+    return true;
+}
+
+static PyObject *push(StreamObject *self, PyObject *srcObject, PyObject *pvsObject, int ndim, int threads) {
+    if (!checkContext(self))
+        return NULL;
+
+    Py_buffer src, pvs;
+    std::vector<openvq_frame> srcFrames, pvsFrames;
+    if (!getFrames(srcObject, &src, ndim, self->width, self->height, srcFrames))
+        return NULL;
+    if (!getFrames(pvsObject, &pvs, ndim, self->width, self->height, pvsFrames)) {
+        PyBuffer_Release(&src);
+        return NULL;
+    }
+    if (srcFrames.size() != pvsFrames.size()) {
+        PyBuffer_Release(&src);
+        PyBuffer_Release(&pvs);
+        PyErr_SetString(PyExc_ValueError, "SRC and PVS must have the same number of frames");
+        return NULL;
+    }
+
+    int ret;
+    Py_BEGIN_ALLOW_THREADS
+    if (ndim == 3) {
+        ret = openvq_push(self->ctx, &srcFrames[0], &pvsFrames[0]);
+    } else {
+        ret = openvq_push_batch(self->ctx, static_cast<int>(srcFrames.size()), srcFrames.data(),
+                                pvsFrames.data(), threads);
+    }
+    Py_END_ALLOW_THREADS
+
+    if (ret < 0 || srcFrames.empty()) {
+        PyBuffer_Release(&src);
+        PyBuffer_Release(&pvs);
+        if (ret < 0)
+            return raiseLastError();
+        Py_RETURN_NONE;
+    }
+    /* Keep the arrays alive and their buffers exported until the next frame has been analysed */
+    releaseLast(self);
+    self->lastSrc = src;
+    self->lastPvs = pvs;
+    self->holding = true;
+    Py_RETURN_NONE;
+}
+
+static PyObject *Stream_push(StreamObject *self, PyObject *args) {
+    PyObject *src, *pvs;
+    if (!PyArg_ParseTuple(args, "OO", &src, &pvs))
+        return NULL;
+    return push(self, src, pvs, 3, 1);
+}
+
+static PyObject *Stream_push_batch(StreamObject *self, PyObject *args, PyObject *kwargs) {
+    static const char *keywords[] = {"src", "pvs", "threads", NULL};
+    PyObject *src, *pvs;
+    int threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|i", const_cast<char **>(keywords), &src, &pvs, &threads))
+        return NULL;
+    return push(self, src, pvs, 4, threads);
+}
+
+static PyObject *Stream_frame_values(StreamObject *self, PyObject *args) {
+    PyObject *frame = Py_None;
+    if (!PyArg_ParseTuple(args, "|O", &frame) || !checkContext(self))
+        return NULL;
+
+    int columns = openvq_frame_value_count(self->ctx);
+    if (frame != Py_None) {
+        long t = PyLong_AsLong(frame);
+        if (t == -1 && PyErr_Occurred())
+            return NULL;
+        std::vector<double> values(columns);
+        if (openvq_frame_values(self->ctx, static_cast<int>(t), values.data()) < 0)
+            return raiseLastError();
+        return doubles(values, -1, 0);
+    }
+
+    int rows = openvq_frames_analysed(self->ctx);
+    std::vector<double> values(static_cast<std::size_t>(rows) * columns);
+    for (int t = 0; t < rows; t++) {
+        if (openvq_frame_values(self->ctx, t, values.data() + static_cast<std::size_t>(t) * columns) < 0)
+            return raiseLastError();
+    }
+    return doubles(values, rows, columns);
+}
+
+static PyObject *Stream_finish(StreamObject *self, PyObject *) {
+    if (!checkContext(self))
+        return NULL;
+
+    std::vector<double> values(openvq_value_count(self->ctx));
+    int ret;
+    Py_BEGIN_ALLOW_THREADS
+    ret = openvq_finish(self->ctx, values.data());
+    Py_END_ALLOW_THREADS
+    releaseLast(self);
+    if (ret < 0)
+        return raiseLastError();
+
+    PyObject *result = PyDict_New();
+    for (unsigned i = 0; result && i < values.size(); i++) {
+        PyObject *value = PyFloat_FromDouble(values[i]);
+        if (!value || PyDict_SetItemString(result, openvq_value_name(self->ctx, i), value) < 0) {
+            Py_XDECREF(value);
+            Py_DECREF(result);
+            return NULL;
+        }
+        Py_DECREF(value);
+    }
+    return result;
+}
+
+static PyObject *Stream_value_names(StreamObject *self, void *) {
+    if (!checkContext(self))
+        return NULL;
+    return names(self->ctx, openvq_value_count(self->ctx), openvq_value_name);
+}
+
+static PyObject *Stream_frame_value_names(StreamObject *self, void *) {
+    if (!checkContext(self))
+        return NULL;
+    return names(self->ctx, openvq_frame_value_count(self->ctx), openvq_frame_value_name);
+}
+
+static PyObject *Stream_frames_analysed(StreamObject *self, void *) {
+    if (!checkContext(self))
+        return NULL;
+    return PyLong_FromLong(openvq_frames_analysed(self->ctx));
+}
+
+static PyMethodDef Stream_methods[] = {
+        {"push", reinterpret_cast<PyCFunction>(Stream_push), METH_VARARGS,
+                "push(src, pvs)\nAnalyses the next frame pair, arrays of shape (3, height, width)"},
+        {"push_batch", reinterpret_cast<PyCFunction>(Stream_push_batch), METH_VARARGS | METH_KEYWORDS,
+                "push_batch(src, pvs, threads=0)\nAnalyses consecutive frame pairs, arrays of shape "
+                "(n, 3, height, width), on up to threads threads (0 for one per core)"},
+        {"frame_values", reinterpret_cast<PyCFunction>(Stream_frame_values), METH_VARARGS,
+                "frame_values(t=None)\nValues of frame t, or of all analysed frames as rows"},
+        {"finish", reinterpret_cast<PyCFunction>(Stream_finish), METH_NOARGS,
+                "finish()\nSequence values by name, once all frames have been pushed"},
+        {NULL}
+};
+
+static PyGetSetDef Stream_getset[] = {
+        {const_cast<char *>("value_names"), reinterpret_cast<getter>(Stream_value_names), NULL, NULL, NULL},
+        {const_cast<char *>("frame_value_names"), reinterpret_cast<getter>(Stream_frame_value_names), NULL, NULL,
+         NULL},
+        {const_cast<char *>("frames_analysed"), reinterpret_cast<getter>(Stream_frames_analysed), NULL, NULL, NULL},
+        {NULL}
+};
+
+static PyTypeObject StreamType = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+};
+
+static PyObject *set_log_level(PyObject *, PyObject *args) {
+    const char *level;
+    if (!PyArg_ParseTuple(args, "s", &level))
+        return NULL;
+    if (openvq_set_log_level(level) < 0)
+        return raiseLastError();
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef module_methods[] = {
+        {"set_log_level", set_log_level, METH_VARARGS,
+                "set_log_level(level)\nLog level threshold {trace,debug,info,warn,error}"},
+        {NULL}
+};
+
+static PyModuleDef module = {
+        PyModuleDef_HEAD_INIT, "openvq", "Video quality metrics of OpenVQ on frames in memory", -1, module_methods
+};
+
+PyMODINIT_FUNC PyInit_openvq(void) {
+    StreamType.tp_name = "openvq.Stream";
+    StreamType.tp_basicsize = sizeof(StreamObject);
+    StreamType.tp_flags = Py_TPFLAGS_DEFAULT;
+    StreamType.tp_doc = "Stream(metric, width, height, frames, options=())\n"
+            "Scores frames pushed to it with metric, one of opvq, psnr, ssim, msssim and vif";
+    StreamType.tp_new = PyType_GenericNew;
+    StreamType.tp_init = reinterpret_cast<initproc>(Stream_init);
+    StreamType.tp_dealloc = reinterpret_cast<destructor>(Stream_dealloc);
+    StreamType.tp_methods = Stream_methods;
+    StreamType.tp_getset = Stream_getset;
+    if (PyType_Ready(&StreamType) < 0)
+        return NULL;
+
+    PyObject *m = PyModule_Create(&module);
+    if (!m)
+        return NULL;
+    Py_INCREF(&StreamType);
+    if (PyModule_AddObject(m, "Stream", reinterpret_cast<PyObject *>(&StreamType)) < 0) {
+        Py_DECREF(&StreamType);
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,201 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <thread>
+
+#include <metrics/Metrics.h>
+
+#include "FrameStream.h"
+
+
+static std::shared_ptr<Frame> copy(const Frame &frame) {
+    std::shared_ptr<Frame> copied = std::make_shared<Frame>(frame.Y.clone(), frame.U.clone(), frame.V.clone());
+    copied->account(MemoryAccounting::FRAMES);
+    return copied;
+}
+
+FrameStream::FrameStream(const std::string &command, int width, int height, unsigned frameCount,
+                         const std::vector<std::string> &options)
+        : pushed(0), analysedFrames(0), finished(false) {
+    static const std::set<std::string> supported = {"opvq", "psnr", "ssim", "msssim", "vif"};
+    if (!supported.count(command)) {
+        throw std::runtime_error("Command can't be fed frame by frame: " + command);
+    }
+    if (width <= 0 || height <= 0 || frameCount == 0) {
+        throw std::runtime_error("Invalid frame size or count");
+    }
+
+    std::unique_ptr<Algorithm> created = Metrics::getAlgorithm(command);
+    algorithm.reset(dynamic_cast<FullReferenceAlgorithm *>(created.release()));
+
+    /* SRC and PVS are required options, here they only name the streams */
+    std::vector<std::string> args = {"openvq", "-s", "src", "-p", "pvs"};
+    args.insert(args.end(), options.begin(), options.end());
+    std::vector<const char *> argv;
+    for (auto &arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    algorithm->parseOptions(static_cast<int>(argv.size()), argv.data());
+
+    VideoInfo info;
+    info.width = width;
+    info.height = height;
+    info.duration = 0;
+    info.frame_count = static_cast<int>(frameCount);
+    info.filename = "";
+    info.avg_framerate = 0;
+    algorithm->attach(info);
+    algorithm->initAnalysis();
+}
+
+void FrameStream::push(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame) {
+    if (finished || pushed >= algorithm->length()) {
+        throw std::runtime_error("More frames pushed than announced");
+    }
+    unsigned t = pushed++;
+
+    if (algorithm->hasPreparationPass()) {
+        algorithm->preparationFrame(FullReferenceAlgorithm::view(srcFrame), FullReferenceAlgorithm::view(pvsFrame), t);
+        retained.push_back(std::make_pair(copy(*srcFrame), copy(*pvsFrame)));
+        return;
+    }
+    analyse(srcFrame, pvsFrame);
+}
+
+void FrameStream::push(const std::vector<FramePair> &frames, unsigned threads) {
+    if (finished || pushed + frames.size() > algorithm->length()) {
+        throw std::runtime_error("More frames pushed than announced");
+    }
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    if (threads > 1 && (!pool || pool->size() != threads)) {
+        pool.reset(new WorkerPool(threads));
+    } else if (threads == 1) {
+        pool.reset();
+    }
+    unsigned first = pushed;
+    pushed += static_cast<unsigned>(frames.size());
+
+    /* Different frames are analysed concurrently, as in the passes of ParallelFullReferenceAlgorithm */
+    if (algorithm->hasPreparationPass()) {
+        retained.resize(pushed);
+        forEach(static_cast<unsigned>(frames.size()), [&](unsigned i) {
+            algorithm->preparationFrame(FullReferenceAlgorithm::view(frames[i].first),
+                                        FullReferenceAlgorithm::view(frames[i].second), first + i);
+            retained[first + i] = std::make_pair(copy(*frames[i].first), copy(*frames[i].second));
+        });
+        return;
+    }
+    forEach(static_cast<unsigned>(frames.size()), [&](unsigned i) {
+        std::shared_ptr<Frame> srcPrevious = i > 0 ? frames[i - 1].first : srcPrev;
+        std::shared_ptr<Frame> pvsPrevious = i > 0 ? frames[i - 1].second : pvsPrev;
+        algorithm->analysisFrame(FullReferenceAlgorithm::view(frames[i].first),
+                                 FullReferenceAlgorithm::view(frames[i].second),
+                                 FullReferenceAlgorithm::view(srcPrevious),
+                                 FullReferenceAlgorithm::view(pvsPrevious), analysedFrames + i);
+    });
+    if (!frames.empty()) {
+        srcPrev = frames.back().first;
+        pvsPrev = frames.back().second;
+        analysedFrames += static_cast<unsigned>(frames.size());
+    }
+}
+
+void FrameStream::forEach(unsigned count, std::function<void(unsigned)> body) {
+    if (!pool) {
+        for (unsigned i = 0; i < count; i++) {
+            body(i);
+        }
+        return;
+    }
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    {
+        WorkerPool::Group group(*pool, 2 * pool->size());
+        for (unsigned i = 0; i < count; i++) {
+            group.submit([&, i]() {
+                try {
+                    body(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> g(errorMutex);
+                    if (!error)
+                        error = std::current_exception();
+                }
+            });
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void FrameStream::analyse(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame) {
+    algorithm->analysisFrame(FullReferenceAlgorithm::view(srcFrame), FullReferenceAlgorithm::view(pvsFrame),
+                             FullReferenceAlgorithm::view(srcPrev), FullReferenceAlgorithm::view(pvsPrev),
+                             analysedFrames);
+    srcPrev = srcFrame;
+    pvsPrev = pvsFrame;
+    analysedFrames++;
+}
+
+unsigned FrameStream::analysed() const {
+    return analysedFrames;
+}
+
+std::vector<double> FrameStream::frameValues(unsigned t) const {
+    if (t >= analysedFrames) {
+        throw std::runtime_error("Frame " + std::to_string(t) + " has not been analysed yet");
+    }
+    return algorithm->frameValues(t);
+}
+
+std::vector<std::string> FrameStream::frameValueNames() const {
+    return algorithm->frameValueNames();
+}
+
+std::vector<double> FrameStream::finish() {
+    if (finished) {
+        throw std::runtime_error("Stream has been finished already");
+    }
+    if (pushed < algorithm->length()) {
+        throw std::runtime_error("Only " + std::to_string(pushed) + " of " + std::to_string(algorithm->length()) +
+                                 " frames have been pushed");
+    }
+    finished = true;
+
+    if (algorithm->hasPreparationPass()) {
+        algorithm->finishPreparation();
+        forEach(static_cast<unsigned>(retained.size()), [&](unsigned t) {
+            algorithm->analysisFrame(FullReferenceAlgorithm::view(retained[t].first),
+                                     FullReferenceAlgorithm::view(retained[t].second),
+                                     t > 0 ? FullReferenceAlgorithm::view(retained[t - 1].first) : nullptr,
+                                     t > 0 ? FullReferenceAlgorithm::view(retained[t - 1].second) : nullptr, t);
+        });
+        analysedFrames = static_cast<unsigned>(retained.size());
+        retained.clear();
+    }
+    srcPrev.reset();
+    pvsPrev.reset();
+    return algorithm->finishAnalysis();
+}
+
+std::vector<std::string> FrameStream::valueNames() const {
+    return algorithm->valueNames();
+}
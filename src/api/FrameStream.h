@@ -0,0 +1,74 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FRAMESTREAM_H
+#define __FRAMESTREAM_H
+
+#include <metrics/Algorithm.h>
+#include <metrics/common/pool/WorkerPool.h>
+
+/*
+ * A full reference algorithm fed with frames the caller already has in memory instead of decoding SRC
+ * and PVS. Frames are YUV 4:4:4 whose pixel data stays owned by the caller; push() doesn't copy it.
+ * Algorithms that need two passes over the sequence (OPVQ with colour correction) are the exception:
+ * they keep a copy of every frame for their analysis pass, which runs in finish().
+ */
+class FrameStream {
+public:
+    typedef std::pair<std::shared_ptr<Frame>, std::shared_ptr<Frame> > FramePair;
+
+    /* command is one of opvq, psnr, ssim, msssim and vif, options are given as on its command line */
+    FrameStream(const std::string &command, int width, int height, unsigned frameCount,
+                const std::vector<std::string> &options);
+
+    /* Analyses the next frame pair. Its pixel data must not change until the next push() or finish() has
+     * returned, the analysis of a frame looks back at the previous one */
+    void push(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame);
+
+    /* Analyses consecutive frame pairs on up to threads threads, 0 for one per core. The last pair must stay
+     * unchanged as above */
+    void push(const std::vector<FramePair> &frames, unsigned threads);
+
+    /* Frames whose values can be fetched with frameValues() */
+    unsigned analysed() const;
+
+    std::vector<double> frameValues(unsigned t) const;
+
+    std::vector<std::string> frameValueNames() const;
+
+    /* Sequence values, once all frames have been pushed */
+    std::vector<double> finish();
+
+    std::vector<std::string> valueNames() const;
+
+private:
+    std::unique_ptr<FullReferenceAlgorithm> algorithm;
+    unsigned pushed;
+    unsigned analysedFrames;
+    bool finished;
+    std::shared_ptr<Frame> srcPrev, pvsPrev;
+    std::vector<FramePair> retained;
+    std::unique_ptr<WorkerPool> pool;
+
+    void analyse(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame);
+
+    /* body(i) for i below count, on the pool if there is one. Rethrows the first exception of body */
+    void forEach(unsigned count, std::function<void(unsigned)> body);
+};
+
+#endif //__FRAMESTREAM_H
@@ -0,0 +1,194 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <io/FrameRing.h>
+#include <io/Logger.h>
+
+#include "FrameStream.h"
+#include "openvq.h"
+
+
+struct openvq_context {
+    std::unique_ptr<FrameStream> stream;
+    int width;
+    int height;
+    std::vector<std::string> valueNames;
+    std::vector<std::string> frameValueNames;
+};
+
+struct openvq_ring {
+    std::shared_ptr<FrameRing> ring;
+};
+
+static thread_local std::string lastError;
+
+/* Runs body, turning exceptions into the -1 returned through the C interface */
+template<typename Body>
+static int guarded(Body body) {
+    try {
+        body();
+        return 0;
+    } catch (std::exception &e) {
+        lastError = e.what();
+    } catch (...) {
+        lastError = "Unknown error";
+    }
+    return -1;
+}
+
+static std::shared_ptr<Frame> wrap(const openvq_frame *frame, int width, int height) {
+    if (!frame) {
+        throw std::runtime_error("Missing frame");
+    }
+    cv::Mat planes[3];
+    for (int p = 0; p < 3; p++) {
+        if (!frame->data[p] || frame->stride[p] < width) {
+            throw std::runtime_error("Invalid plane " + std::to_string(p));
+        }
+        /* The analysis only reads the pixels, so the caller's buffers are wrapped without copying them */
+        planes[p] = cv::Mat(height, width, CV_8UC1, const_cast<uint8_t *>(frame->data[p]),
+                            static_cast<std::size_t>(frame->stride[p]));
+    }
+    return std::make_shared<Frame>(planes[0], planes[1], planes[2]);
+}
+
+int openvq_api_version(void) {
+    return OPENVQ_API_VERSION;
+}
+
+int openvq_set_log_level(const char *level) {
+    return guarded([&]() {
+        std::string threshold(level ? level : "");
+        Logger::setThreshold(threshold);
+    });
+}
+
+openvq_context *openvq_create(const char *metric, int width, int height, int frame_count,
+                              int argc, const char *const *argv) {
+    std::unique_ptr<openvq_context> ctx(new openvq_context());
+    int ret = guarded([&]() {
+        if (!metric || frame_count <= 0 || argc < 0 || (argc > 0 && !argv)) {
+            throw std::runtime_error("Invalid arguments");
+        }
+        std::vector<std::string> options(argv, argv + argc);
+        ctx->stream.reset(new FrameStream(metric, width, height, static_cast<unsigned>(frame_count), options));
+        ctx->width = width;
+        ctx->height = height;
+        ctx->valueNames = ctx->stream->valueNames();
+        ctx->frameValueNames = ctx->stream->frameValueNames();
+    });
+    return ret == 0 ? ctx.release() : NULL;
+}
+
+void openvq_destroy(openvq_context *ctx) {
+    delete ctx;
+}
+
+int openvq_push(openvq_context *ctx, const openvq_frame *src, const openvq_frame *pvs) {
+    return guarded([&]() {
+        ctx->stream->push(wrap(src, ctx->width, ctx->height), wrap(pvs, ctx->width, ctx->height));
+    });
+}
+
+int openvq_push_batch(openvq_context *ctx, int count, const openvq_frame *src, const openvq_frame *pvs,
+                      int threads) {
+    return guarded([&]() {
+        if (count < 0 || threads < 0 || (count > 0 && (!src || !pvs))) {
+            throw std::runtime_error("Invalid arguments");
+        }
+        std::vector<FrameStream::FramePair> frames;
+        for (int i = 0; i < count; i++) {
+            frames.push_back(std::make_pair(wrap(&src[i], ctx->width, ctx->height),
+                                            wrap(&pvs[i], ctx->width, ctx->height)));
+        }
+        ctx->stream->push(frames, static_cast<unsigned>(threads));
+    });
+}
+
+int openvq_frames_analysed(const openvq_context *ctx) {
+    return static_cast<int>(ctx->stream->analysed());
+}
+
+int openvq_frame_value_count(const openvq_context *ctx) {
+    return static_cast<int>(ctx->frameValueNames.size());
+}
+
+const char *openvq_frame_value_name(const openvq_context *ctx, int index) {
+    if (index < 0 || index >= static_cast<int>(ctx->frameValueNames.size()))
+        return NULL;
+    return ctx->frameValueNames[index].c_str();
+}
+
+int openvq_frame_values(const openvq_context *ctx, int t, double *values) {
+    return guarded([&]() {
+        if (t < 0) {
+            throw std::runtime_error("Invalid frame index");
+        }
+        std::vector<double> frameValues = ctx->stream->frameValues(static_cast<unsigned>(t));
+        std::copy(frameValues.begin(), frameValues.end(), values);
+    });
+}
+
+int openvq_value_count(const openvq_context *ctx) {
+    return static_cast<int>(ctx->valueNames.size());
+}
+
+const char *openvq_value_name(const openvq_context *ctx, int index) {
+    if (index < 0 || index >= static_cast<int>(ctx->valueNames.size()))
+        return NULL;
+    return ctx->valueNames[index].c_str();
+}
+
+int openvq_finish(openvq_context *ctx, double *values) {
+    return guarded([&]() {
+        std::vector<double> sequenceValues = ctx->stream->finish();
+        std::copy(sequenceValues.begin(), sequenceValues.end(), values);
+    });
+}
+
+const char *openvq_last_error(void) {
+    return lastError.c_str();
+}
+
+openvq_ring *openvq_ring_create(const char *name, int width, int height, int frame_count, int slots,
+                                float framerate) {
+    std::unique_ptr<openvq_ring> ring(new openvq_ring());
+    int ret = guarded([&]() {
+        if (!name || slots < 0) {
+            throw std::runtime_error("Invalid arguments");
+        }
+        ring->ring = FrameRing::create(name, width, height, frame_count, static_cast<unsigned>(slots), framerate);
+    });
+    return ret == 0 ? ring.release() : NULL;
+}
+
+int openvq_ring_write(openvq_ring *ring, const openvq_frame *frame) {
+    return guarded([&]() {
+        if (!frame) {
+            throw std::runtime_error("Missing frame");
+        }
+        ring->ring->write(frame->data, frame->stride);
+    });
+}
+
+void openvq_ring_close(openvq_ring *ring) {
+    if (ring) {
+        ring->ring->close();
+    }
+    delete ring;
+}
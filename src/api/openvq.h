@@ -0,0 +1,121 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPENVQ_H
+#define OPENVQ_H
+
+/*
+ * C interface of libopenvq: scores frames the caller has in memory, e.g. inside an encoding loop,
+ * instead of decoding SRC and PVS from files.
+ *
+ *   openvq_context *ctx = openvq_create("psnr", width, height, frames, 0, NULL);
+ *   for each frame: openvq_push(ctx, &src, &pvs), then optionally openvq_frame_values(ctx, t, values)
+ *   openvq_finish(ctx, values);
+ *   openvq_destroy(ctx);
+ *
+ * Functions returning int return 0 on success and -1 on failure; openvq_last_error() then describes
+ * the failure of the last call made by the calling thread.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OPENVQ_API_VERSION 1
+
+typedef struct openvq_context openvq_context;
+
+/* 8 bit YUV 4:4:4 frame, three planes of width x height samples */
+typedef struct openvq_frame {
+    const uint8_t *data[3];
+    /* Bytes from one row of a plane to the next */
+    int stride[3];
+} openvq_frame;
+
+int openvq_api_version(void);
+
+/* Log level threshold {trace,debug,info,warn,error} of all contexts, info by default */
+int openvq_set_log_level(const char *level);
+
+/*
+ * Context scoring frame_count frame pairs with metric, one of "opvq", "psnr", "ssim", "msssim" and "vif".
+ * argv holds further options as on the metric's command line, e.g. "--disable-colour-correction".
+ * Returns NULL on failure.
+ */
+openvq_context *openvq_create(const char *metric, int width, int height, int frame_count,
+                              int argc, const char *const *argv);
+
+void openvq_destroy(openvq_context *ctx);
+
+/*
+ * Analyses the next frame pair without copying it. The planes must stay valid and unchanged until the
+ * next openvq_push() or openvq_finish() on ctx has returned, since a frame is compared with the previous
+ * one. OPVQ with alignment or colour correction needs the whole sequence before its analysis; it copies
+ * the frames and analyses them in openvq_finish(), so pass "--disable-spatial-alignment" and
+ * "--disable-colour-correction" to score in the loop.
+ */
+int openvq_push(openvq_context *ctx, const openvq_frame *src, const openvq_frame *pvs);
+
+/* Pushes count consecutive frame pairs, analysed concurrently on up to threads threads (0 for one per
+ * core). Only the last pair has to stay valid after the call */
+int openvq_push_batch(openvq_context *ctx, int count, const openvq_frame *src, const openvq_frame *pvs,
+                      int threads);
+
+/* Number of frames whose values openvq_frame_values() can return */
+int openvq_frames_analysed(const openvq_context *ctx);
+
+/* Per-frame values, 0 for metrics that only have sequence values */
+int openvq_frame_value_count(const openvq_context *ctx);
+
+const char *openvq_frame_value_name(const openvq_context *ctx, int index);
+
+/* Writes openvq_frame_value_count() values of frame t to values */
+int openvq_frame_values(const openvq_context *ctx, int t, double *values);
+
+int openvq_value_count(const openvq_context *ctx);
+
+const char *openvq_value_name(const openvq_context *ctx, int index);
+
+/* Writes openvq_value_count() sequence values to values, once all frames have been pushed */
+int openvq_finish(openvq_context *ctx, double *values);
+
+const char *openvq_last_error(void);
+
+/*
+ * Producer side of a shared memory frame ring, which openvq reads as the sequence "shm:/name", e.g.
+ *   openvq opvq -s src.y4m -p shm:/encoder-recon --disable-spatial-alignment --disable-colour-correction
+ * The ring has slots frames of room; openvq_ring_write() waits while openvq hasn't released any of them.
+ * Create the ring before starting openvq, it is removed by openvq_ring_close().
+ */
+typedef struct openvq_ring openvq_ring;
+
+openvq_ring *openvq_ring_create(const char *name, int width, int height, int frame_count, int slots,
+                                float framerate);
+
+int openvq_ring_write(openvq_ring *ring, const openvq_frame *frame);
+
+void openvq_ring_close(openvq_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //OPENVQ_H
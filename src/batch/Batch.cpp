@@ -0,0 +1,200 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+#include <metrics/Metrics.h>
+
+#include "Batch.h"
+
+
+/* Fields of a manifest line, which may be quoted to contain commas */
+static std::vector<std::string> csvFields(const std::string &line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (std::size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (c == '"' && quoted && i + 1 < line.size() && line[i + 1] == '"') {
+            fields.back() += c;
+            i++;
+        } else if (c == '"') {
+            quoted = !quoted;
+        } else if (c == ',' && !quoted) {
+            fields.push_back("");
+        } else {
+            fields.back() += c;
+        }
+    }
+    for (auto &field : fields) {
+        boost::algorithm::trim(field);
+    }
+    return fields;
+}
+
+Batch::Batch()
+        : Algorithm("Batch") {
+    options.add_options()
+            ("manifest", opts::value<std::string>(&manifestURL)->required(),
+             "CSV file with one metric,src,pvs[,options] line per pair to score (required)")
+            ("num_threads,j", opts::value<unsigned>(&threads)->default_value(std::thread::hardware_concurrency()),
+             "Number of worker threads shared by all pairs")
+            ("pairs", opts::value<unsigned>(&pairs),
+             "Number of pairs scored at once, each decodes on a thread of its own. Defaults to -j")
+            ("memory-budget", opts::value<unsigned>(&memoryBudgetSize)->default_value(4096),
+             "Memory in MiB the pairs scored at once are estimated to need at most")
+            ("feature-cache", opts::value<std::string>(&featureCacheDir),
+             "SRC feature cache directory of pairs that don't name one");
+    positional.add("manifest", 1);
+}
+
+void Batch::configure(const opts::variables_map &vm) {
+    threads = std::max(threads, 1u);
+    if (!vm.count("pairs")) {
+        pairs = threads;
+    }
+    pairs = std::max(pairs, 1u);
+}
+
+void Batch::init(int argc, const char **argv) {
+    parseOptions(argc, argv);
+    readManifest();
+}
+
+void Batch::readManifest() {
+    std::ifstream manifest(manifestURL);
+    if (!manifest) {
+        throw std::runtime_error("Could not open manifest " + manifestURL);
+    }
+
+    std::string line;
+    for (unsigned number = 1; std::getline(manifest, line); number++) {
+        boost::algorithm::trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::vector<std::string> fields = csvFields(line);
+        if (number == 1 && fields[0] == "metric")
+            continue; // Header
+        if (fields.size() < 3 || fields.size() > 4) {
+            throw std::runtime_error(manifestURL + ":" + std::to_string(number) + ": expected metric,src,pvs[,options]");
+        }
+        if (fields[0] == "batch" || fields[0] == "serve" || fields[0] == "bench" ||
+            fields[0] == "generate" || fields[0] == "equivalence") {
+            throw std::runtime_error(manifestURL + ":" + std::to_string(number) + ": not a metric: " + fields[0]);
+        }
+
+        Entry entry;
+        entry.line = number;
+        entry.command = fields[0];
+        entry.args = {"-s", fields[1], "-p", fields[2]};
+        if (fields.size() == 4 && !fields[3].empty()) {
+            std::vector<std::string> options;
+            boost::algorithm::split(options, fields[3], boost::algorithm::is_space(),
+                                    boost::algorithm::token_compress_on);
+            entry.args.insert(entry.args.end(), options.begin(), options.end());
+        }
+        entries.push_back(entry);
+    }
+    logger(INFO) << "Read " << entries.size() << " pairs from " << manifestURL;
+}
+
+int Batch::run() {
+    ParallelFullReferenceAlgorithm::useSharedPool(std::make_shared<WorkerPool>(threads));
+    MemoryBudget budget(static_cast<std::size_t>(memoryBudgetSize) << 20);
+
+    std::vector<Outcome> outcomes(entries.size());
+    std::atomic<unsigned> next(0);
+    std::mutex outputMutex;
+    unsigned written = 0;
+    unsigned finished = 0;
+    bool failed = false;
+
+    std::vector<std::thread> drivers;
+    for (unsigned d = 0; d < std::min<std::size_t>(pairs, entries.size()); d++) {
+        drivers.push_back(std::thread([&]() {
+            // Progress bars of concurrent pairs would overwrite each other
+            Logger::setProgressListener([](int, int) { });
+            for (unsigned i; (i = next++) < entries.size();) {
+                Outcome outcome = score(entries[i], budget);
+
+                /* Results are written as soon as all pairs before them are done */
+                std::lock_guard<std::mutex> g(outputMutex);
+                outcomes[i] = outcome;
+                failed |= outcome.failed;
+                for (; written < outcomes.size() && outcomes[written].done; written++) {
+                    for (auto &result : outcomes[written].results) {
+                        writeRecord(result);
+                    }
+                    outcomes[written].results.clear();
+                }
+                logger(INFO) << "Finished " << ++finished << " of " << entries.size() << " pairs";
+            }
+            Logger::setProgressListener(nullptr);
+        }));
+    }
+    for (auto &driver : drivers) {
+        driver.join();
+    }
+    flushResults();
+    return failed ? 1 : 0;
+}
+
+Batch::Outcome Batch::score(const Entry &entry, MemoryBudget &budget) {
+    Outcome outcome;
+    outcome.done = true;
+    try {
+        std::unique_ptr<Algorithm> algorithm = Metrics::getAlgorithm(entry.command);
+
+        std::vector<std::string> args = {"openvq"};
+        args.insert(args.end(), entry.args.begin(), entry.args.end());
+        if (!featureCacheDir.empty() && std::find(args.begin(), args.end(), "--feature-cache") == args.end()) {
+            args.insert(args.end(), {"--feature-cache", featureCacheDir});
+        }
+        if (!resultCacheDir.empty() && std::find(args.begin(), args.end(), "--result-cache") == args.end()) {
+            args.insert(args.end(), {"--result-cache", resultCacheDir});
+        }
+        std::vector<const char *> argv;
+        for (auto &arg : args) {
+            argv.push_back(arg.c_str());
+        }
+
+        algorithm->setResultListener([&](const ResultRecord &record) {
+            outcome.results.push_back(record);
+        });
+        algorithm->init(static_cast<int>(argv.size()), argv.data());
+
+        std::size_t reserved = budget.acquire(algorithm->memoryEstimate());
+        try {
+            outcome.failed = algorithm->run() != 0;
+        } catch (...) {
+            budget.release(reserved);
+            throw;
+        }
+        budget.release(reserved);
+    } catch (std::exception &e) {
+        logger(ERROR) << manifestURL << ":" << entry.line << ": " << e.what();
+        outcome.failed = true;
+    }
+    return outcome;
+}
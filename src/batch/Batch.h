@@ -0,0 +1,68 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BATCH_H
+#define __BATCH_H
+
+#include <metrics/Algorithm.h>
+#include <metrics/common/pool/MemoryBudget.h>
+
+/*
+ * Scores the pairs of a manifest from one process. Each line of the manifest is
+ *   metric,src,pvs[,options]
+ * with options as on the metric's command line, separated by spaces. Up to --pairs pairs are run at once
+ * and all of them share one worker pool for their frames, so short clips keep the cores busy across
+ * pairs and long ones across frames. Results are written in manifest order.
+ */
+class Batch : public Algorithm {
+public:
+    Batch();
+
+    virtual void init(int argc, const char **argv) override;
+
+    int run() override;
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+private:
+    struct Entry {
+        unsigned line;
+        std::string command;
+        std::vector<std::string> args;
+    };
+
+    struct Outcome {
+        bool done = false;
+        bool failed = false;
+        std::vector<ResultRecord> results;
+    };
+
+    std::string manifestURL;
+    unsigned threads;
+    unsigned pairs;
+    unsigned memoryBudgetSize;
+    std::string featureCacheDir;
+    std::vector<Entry> entries;
+
+    void readManifest();
+
+    Outcome score(const Entry &entry, MemoryBudget &budget);
+};
+
+#endif //__BATCH_H
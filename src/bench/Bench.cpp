@@ -0,0 +1,269 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include <io/MemoryAccounting.h>
+#include <io/SyntheticSequence.h>
+#include <io/Trace.h>
+#include <io/Y4mWriter.h>
+#include <metrics/Metrics.h>
+
+#include "Bench.h"
+
+
+static std::vector<std::string> listItems(const std::string &list) {
+    std::vector<std::string> items;
+    boost::algorithm::split(items, list, boost::algorithm::is_any_of(","), boost::algorithm::token_compress_on);
+    items.erase(std::remove(items.begin(), items.end(), ""), items.end());
+    return items;
+}
+
+/* 1, 2, 4, ... up to the number of cores, and the number of cores itself */
+static std::string defaultThreadList() {
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+    std::string list;
+    for (unsigned j = 1; j < cores; j *= 2) {
+        list += std::to_string(j) + ",";
+    }
+    return list + std::to_string(cores);
+}
+
+Bench::Bench()
+        : Algorithm("Bench") {
+    options.add_options()
+            ("src,s", opts::value<std::string>(&srcURL), "SRC to run the metrics on instead of generated clips")
+            ("pvs,p", opts::value<std::string>(&pvsURL), "PVS compared with --src, the SRC itself if not given")
+            ("metrics", opts::value<std::string>(&metricList)->default_value("psnr,ssim,opvq"),
+             "Full reference metrics to run, comma separated")
+            ("threads", opts::value<std::string>(&threadList)->default_value(defaultThreadList()),
+             "Values of -j to run the metrics that take it with, comma separated")
+            ("sizes", opts::value<std::string>(&sizeList)->default_value("vga,1080p"),
+             ("Resolutions of the generated clips, comma separated {" + VideoProperties::resolutionNames() + "}").c_str())
+            ("frames", opts::value<unsigned>(&frameCount)->default_value(60), "Frames of the generated clips")
+            ("repetitions", opts::value<unsigned>(&repetitions)->default_value(1),
+             "Runs of every configuration, the fastest one counts")
+            ("tmp-dir", opts::value<std::string>(&tmpDir)->default_value("/tmp"),
+             "Directory the clips are generated in, they are removed afterwards");
+}
+
+void Bench::configure(const opts::variables_map &vm) {
+    metrics = listItems(metricList);
+    for (auto &metric : metrics) {
+        std::unique_ptr<Algorithm> algorithm = Metrics::getAlgorithm(metric);
+        if (!dynamic_cast<FullReferenceAlgorithm *>(algorithm.get()) || metric == "opvq-ladder") {
+            throw std::runtime_error("Not a full reference metric of a single PVS: " + metric);
+        }
+    }
+
+    threadCounts.clear();
+    for (auto &item : listItems(threadList)) {
+        int threads = std::stoi(item);
+        if (threads <= 0) {
+            throw std::runtime_error("Thread counts must be positive");
+        }
+        threadCounts.push_back(static_cast<unsigned>(threads));
+    }
+    std::sort(threadCounts.begin(), threadCounts.end());
+    threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+    if (metrics.empty() || threadCounts.empty()) {
+        throw std::runtime_error("Nothing to run");
+    }
+    if (frameCount < 2 || repetitions == 0) {
+        throw std::runtime_error("Clips need at least 2 frames and every configuration a run");
+    }
+
+    clips.clear();
+    if (!srcURL.empty()) {
+        clips.push_back({srcURL, srcURL, pvsURL.empty() ? srcURL : pvsURL, false});
+        return;
+    }
+    if (!pvsURL.empty()) {
+        throw std::runtime_error("--pvs needs --src");
+    }
+    for (auto &size : listItems(sizeList)) {
+        ResolutionID resolution = VideoProperties::resolutionByName(size);
+        if (resolution == RES_UNSUPPORTED) {
+            throw std::runtime_error("Unknown resolution \"" + size + "\", expected one of " +
+                                     VideoProperties::resolutionNames());
+        }
+        clips.push_back({size, "", "", true});
+    }
+}
+
+void Bench::init(int argc, const char **argv) {
+    parseOptions(argc, argv);
+}
+
+Bench::Clip Bench::generateClip(ResolutionID resolution) {
+    const ResolutionInfo &info = VideoProperties::resolutionInfo[resolution];
+    Clip clip = {info.name, tmpDir + "/openvq-bench-" + info.name + "-src.y4m",
+                 tmpDir + "/openvq-bench-" + info.name + "-pvs.y4m", true};
+    logger(INFO) << "Generating " << frameCount << " frames at " << info.width << "x" << info.height;
+
+    /* Blurred and noisy, as a coded sequence would be */
+    SyntheticSequence sequence(info.width, info.height, frameCount, 0x6f7671);
+    std::vector<SyntheticSequence::Distortion> distortions = SyntheticSequence::parseDistortions("blur:0.8+noise:3");
+    Y4mWriter src(clip.src, info.width, info.height, 25, true);
+    Y4mWriter pvs(clip.pvs, info.width, info.height, 25, true);
+    for (unsigned t = 0; t < frameCount; t++) {
+        src.write(sequence.source(t));
+        pvs.write(sequence.processed(t, distortions));
+    }
+    src.close();
+    pvs.close();
+    return clip;
+}
+
+Bench::Measurement Bench::measure(const std::string &metric, const Clip &clip, unsigned threads) {
+    Measurement best = Measurement();
+    for (unsigned r = 0; r < repetitions; r++) {
+        std::unique_ptr<Algorithm> algorithm = Metrics::getAlgorithm(metric);
+        FullReferenceAlgorithm *fullRef = dynamic_cast<FullReferenceAlgorithm *>(algorithm.get());
+
+        std::vector<std::string> args = {"openvq", "-s", clip.src, "-p", clip.pvs};
+        if (dynamic_cast<ParallelFullReferenceAlgorithm *>(algorithm.get())) {
+            args.insert(args.end(), {"-j", std::to_string(threads)});
+        }
+        if (maxFrames != std::numeric_limits<int>::max()) {
+            args.insert(args.end(), {"-t", std::to_string(maxFrames)});
+        }
+        std::vector<const char *> argv;
+        for (auto &arg : args) {
+            argv.push_back(arg.c_str());
+        }
+        algorithm->setResultListener([](const ResultRecord &) { });
+        algorithm->init(static_cast<int>(argv.size()), argv.data());
+
+        Trace::resetTotals();
+        MemoryAccounting::resetPeak();
+        auto start = std::chrono::steady_clock::now();
+        if (algorithm->run() != 0) {
+            throw std::runtime_error(metric + " failed on " + clip.name);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::map<std::string, std::uint64_t> stages = Trace::stageNanoseconds();
+        Measurement m = Measurement();
+        m.metric = metric;
+        m.clip = clip.name;
+        m.threads = threads;
+        m.frames = fullRef->length();
+        m.seconds = seconds;
+        m.fps = m.frames / seconds;
+        m.decodeSeconds = (stages["read"] + stages["decode"] + stages["sws_scale"]) / 1e9;
+        m.analysisSeconds = (stages["preparation"] + stages["analysis"]) / 1e9;
+        m.peakBytes = MemoryAccounting::peakTotal();
+        if (r == 0 || m.fps > best.fps) {
+            best = m;
+        }
+    }
+    return best;
+}
+
+int Bench::run() {
+    Trace::enable(Trace::eventsEnabled(), Trace::countersEnabled(), true);
+
+    std::ostringstream table;
+    table << std::fixed << std::left << std::setw(12) << "METRIC" << std::setw(40) << "CLIP" << std::right
+          << std::setw(8) << "THREADS" << std::setw(8) << "FRAMES" << std::setw(10) << "FPS" << std::setw(12)
+          << "EFFICIENCY" << std::setw(10) << "DECODE S" << std::setw(12) << "ANALYSIS S" << std::setw(10)
+          << "DECODE %" << std::setw(10) << "PEAK MIB" << std::endl;
+
+    for (Clip clip : clips) {
+        try {
+            if (clip.generated) {
+                clip = generateClip(VideoProperties::resolutionByName(clip.name));
+            }
+            measureClip(clip, table);
+        } catch (std::exception &e) {
+            logger(ERROR) << e.what();
+            removeClip(clip);
+            return 1;
+        }
+        removeClip(clip);
+    }
+
+    logger(INFO) << "Decode and analysis seconds are summed over all threads. Efficiency is fps per thread "
+                 << "relative to the fewest threads run" << std::endl << table.str();
+    flushResults();
+    return 0;
+}
+
+void Bench::measureClip(const Clip &clip, std::ostream &table) {
+    for (auto &metric : metrics) {
+        bool parallel = dynamic_cast<ParallelFullReferenceAlgorithm *>(Metrics::getAlgorithm(metric).get());
+
+        /* Per-run logging and progress bars would bury the table; the metric's own errors still show */
+        LogLevel threshold = Logger::getThreshold();
+        Logger::setThreshold(std::max(threshold, ERROR));
+        Logger::setProgressListener([](int, int) { });
+        std::vector<Measurement> sweep;
+        try {
+            for (unsigned threads : threadCounts) {
+                sweep.push_back(measure(metric, clip, parallel ? threads : 1));
+                if (!parallel)
+                    break;
+            }
+        } catch (...) {
+            Logger::setThreshold(threshold);
+            Logger::setProgressListener(nullptr);
+            throw;
+        }
+        Logger::setThreshold(threshold);
+        Logger::setProgressListener(nullptr);
+
+        const Measurement &fewest = sweep.front();
+        for (Measurement &m : sweep) {
+            m.efficiency = (m.fps / m.threads) / (fewest.fps / fewest.threads);
+            double busy = m.decodeSeconds + m.analysisSeconds;
+            double decodeShare = busy > 0 ? m.decodeSeconds / busy : 0;
+
+            table << std::left << std::setw(12) << m.metric << std::setw(40) << m.clip << std::right
+                  << std::setw(8) << m.threads << std::setw(8) << m.frames << std::setprecision(1)
+                  << std::setw(10) << m.fps << std::setprecision(2) << std::setw(12) << m.efficiency
+                  << std::setw(10) << m.decodeSeconds << std::setw(12) << m.analysisSeconds
+                  << std::setprecision(1) << std::setw(10) << decodeShare * 100
+                  << std::setw(10) << m.peakBytes / (1024.0 * 1024.0) << std::endl;
+            logger(DEBUG) << m.metric << " on " << m.clip << " with " << m.threads << " threads: " << m.fps << " fps";
+
+            writeResult(m.metric + "@" + m.clip + "#j=" + std::to_string(m.threads),
+                        {"threads", "frames", "seconds", "fps", "efficiency", "decode_seconds",
+                         "analysis_seconds", "decode_share", "peak_bytes"},
+                        {static_cast<double>(m.threads), static_cast<double>(m.frames), m.seconds, m.fps,
+                         m.efficiency, m.decodeSeconds, m.analysisSeconds, decodeShare,
+                         static_cast<double>(m.peakBytes)});
+        }
+    }
+}
+
+void Bench::removeClip(const Clip &clip) {
+    if (clip.generated) {
+        std::remove(clip.src.c_str());
+        std::remove(clip.pvs.c_str());
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <io/VideoProperties.h>
+#include <metrics/Algorithm.h>
+
+/*
+ * Runs metrics end to end over a sweep of -j values and resolutions, on synthetic clips written to
+ * --tmp-dir or on a given SRC and PVS. Reports frames per second, the efficiency per thread relative to
+ * the fewest threads run, the time spent decoding and analysing, and the peak memory tracked, as a table
+ * and as results with one record per metric, resolution and thread count.
+ */
+class Bench : public Algorithm {
+public:
+    Bench();
+
+    virtual void init(int argc, const char **argv) override;
+
+    int run() override;
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+private:
+    struct Clip {
+        std::string name;
+        std::string src;
+        std::string pvs;
+        bool generated;
+    };
+
+    struct Measurement {
+        std::string metric;
+        std::string clip;
+        unsigned threads;
+        unsigned frames;
+        double seconds;
+        double fps;
+        double efficiency;
+        double decodeSeconds;
+        double analysisSeconds;
+        std::size_t peakBytes;
+    };
+
+    std::string srcURL;
+    std::string pvsURL;
+    std::string metricList;
+    std::string threadList;
+    std::string sizeList;
+    unsigned frameCount;
+    unsigned repetitions;
+    std::string tmpDir;
+
+    std::vector<std::string> metrics;
+    std::vector<unsigned> threadCounts;
+    std::vector<Clip> clips;
+
+    /* Synthetic SRC and a blurred, noisy copy as PVS, 4:2:0 like coded video */
+    Clip generateClip(ResolutionID resolution);
+
+    /* Fastest of the repetitions; efficiency is filled in once the whole sweep of a metric is known */
+    Measurement measure(const std::string &metric, const Clip &clip, unsigned threads);
+
+    /* Sweeps every metric over the thread counts, adding table rows and result records */
+    void measureClip(const Clip &clip, std::ostream &table);
+
+    void removeClip(const Clip &clip);
+};
+
+#endif //__BENCH_H
@@ -0,0 +1,397 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include <io/SyntheticSequence.h>
+#include <io/VideoProperties.h>
+#include <io/VideoSequence.h>
+#include <io/Y4mWriter.h>
+#include <metrics/Metrics.h>
+#include <metrics/common/alignment/ColourAlignment.h>
+#include <metrics/common/alignment/SpatialAlignment.h>
+#include <metrics/opvq/OPVQ.h>
+
+#include "Equivalence.h"
+#include "ReferenceOPVQ.h"
+
+
+static std::vector<std::string> listItems(const std::string &list) {
+    std::vector<std::string> items;
+    boost::algorithm::split(items, list, boost::algorithm::is_any_of(","), boost::algorithm::token_compress_on);
+    items.erase(std::remove(items.begin(), items.end(), ""), items.end());
+    return items;
+}
+
+/* Kernels in the order they run, then the values of opvq end to end. Alignment is integral and must match
+ * exactly, the rest is compared in absolute terms */
+static const std::vector<std::pair<std::string, double> > defaultTolerances = {
+        {"spatial-offset",    0},
+        {"colour-histograms", 0},
+        {"colour-curves",     0},
+        {"colour-correction", 0},
+        {"edginess",          1e-9},
+        {"luminance",         1e-9},
+        {"chrominance",       1e-9},
+        {"omitted",           1e-9},
+        {"introduced",        1e-9},
+        {"dmos-mapping",      1e-9},
+        {"opvq_luma",         1e-9},
+        {"opvq_chroma",       1e-9},
+        {"opvq_introduced",   1e-9},
+        {"opvq_omitted",      1e-9},
+        {"opvq_dmos",         1e-9}
+};
+
+Equivalence::Equivalence()
+        : Algorithm("Equivalence") {
+    std::string names;
+    for (auto &tolerance : defaultTolerances) {
+        names += (names.empty() ? "" : ",") + tolerance.first;
+    }
+    options.add_options()
+            ("src,s", opts::value<std::string>(&srcURL), "Recorded SRC to compare on besides the synthetic clips")
+            ("pvs,p", opts::value<std::string>(&pvsURL), "PVS compared with --src, the SRC itself if not given")
+            ("sizes", opts::value<std::string>(&sizeList)->default_value("qcif,cif,vga"),
+             ("Resolutions of the synthetic clips, comma separated, none for only --src {" +
+              VideoProperties::resolutionNames() + "}").c_str())
+            ("distortions", opts::value<std::string>(&distortionList)->default_value(
+                    "blur,blockiness,noise,colour-shift,spatial-shift:1,dropped-frames,blur:0.8+noise:3"),
+             "PVS of the synthetic clips, comma separated, as for generate")
+            ("frames", opts::value<unsigned>(&frameCount)->default_value(12),
+             "Frames of the synthetic clips, and at most compared of --src")
+            ("seed", opts::value<std::uint64_t>(&seed)->default_value(1), "Seed of the synthetic clips")
+            ("tolerances", opts::value<std::string>(&toleranceList)->default_value(""),
+             ("Largest absolute deviations allowed instead of the defaults, e.g. luminance=1e-6,opvq_dmos=1e-4 {" +
+              names + "}").c_str())
+            ("tmp-dir", opts::value<std::string>(&tmpDir)->default_value("/tmp"),
+             "Directory the synthetic clips are written to, they are removed afterwards");
+}
+
+void Equivalence::configure(const opts::variables_map &vm) {
+    deviations.clear();
+    for (auto &tolerance : defaultTolerances) {
+        deviations.push_back({tolerance.first, tolerance.second, 0, 0, 0, ""});
+    }
+    for (auto &item : listItems(toleranceList)) {
+        std::size_t equals = item.find('=');
+        auto deviation = std::find_if(deviations.begin(), deviations.end(), [&](const Deviation &d) {
+            return d.name == item.substr(0, equals);
+        });
+        if (equals == std::string::npos || deviation == deviations.end()) {
+            throw std::runtime_error("Expected name=tolerance of a kernel or value: " + item);
+        }
+        deviation->tolerance = std::stod(item.substr(equals + 1));
+    }
+
+    sizes.clear();
+    for (auto &size : listItems(sizeList)) {
+        if (size == "none")
+            continue;
+        if (VideoProperties::resolutionByName(size) == RES_UNSUPPORTED) {
+            throw std::runtime_error("Unknown resolution \"" + size + "\", expected one of " +
+                                     VideoProperties::resolutionNames());
+        }
+        sizes.push_back(size);
+    }
+    distortions = listItems(distortionList);
+    for (auto &spec : distortions) {
+        SyntheticSequence::parseDistortions(spec);
+    }
+
+    if (frameCount < 2) {
+        throw std::runtime_error("The temporal indicators need at least 2 frames");
+    }
+    if (!pvsURL.empty() && srcURL.empty()) {
+        throw std::runtime_error("--pvs needs --src");
+    }
+    if (srcURL.empty() && (sizes.empty() || distortions.empty())) {
+        throw std::runtime_error("Nothing to compare");
+    }
+}
+
+void Equivalence::init(int argc, const char **argv) {
+    parseOptions(argc, argv);
+}
+
+void Equivalence::add(const std::string &name, const std::string &caseName, double deviation) {
+    if (std::isnan(deviation)) {
+        deviation = std::numeric_limits<double>::infinity();
+    }
+    for (auto &d : deviations) {
+        if (d.name == name) {
+            if (d.samples == 0 || deviation > d.max) {
+                d.max = deviation;
+                d.worst = caseName;
+            }
+            d.sum += deviation;
+            d.samples++;
+            return;
+        }
+    }
+}
+
+double Equivalence::maxDifference(const Frame &a, const Frame &b) {
+    if (a.Y.size().width != b.Y.size().width || a.Y.size().height != b.Y.size().height || a.Y.type() != b.Y.type()) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return std::max({cv::norm(a.Y, b.Y, cv::NORM_INF), cv::norm(a.U, b.U, cv::NORM_INF),
+                     cv::norm(a.V, b.V, cv::NORM_INF)});
+}
+
+std::vector<Equivalence::Case> Equivalence::generateCases(const std::string &size) {
+    const ResolutionInfo &info = VideoProperties::resolutionInfo[VideoProperties::resolutionByName(size)];
+    std::string prefix = tmpDir + "/openvq-equivalence-" + size;
+    SyntheticSequence sequence(info.width, info.height, frameCount, seed);
+
+    std::vector<Case> cases;
+    std::vector<std::vector<SyntheticSequence::Distortion> > parsed;
+    for (unsigned i = 0; i < distortions.size(); i++) {
+        cases.push_back({size + "/" + distortions[i], prefix + "-src.y4m", prefix + "-pvs" + std::to_string(i) + ".y4m",
+                         true});
+        parsed.push_back(SyntheticSequence::parseDistortions(distortions[i]));
+    }
+
+    try {
+        Y4mWriter src(cases.front().src, info.width, info.height, 25, true);
+        std::vector<std::unique_ptr<Y4mWriter> > pvs;
+        for (auto &c : cases) {
+            pvs.emplace_back(new Y4mWriter(c.pvs, info.width, info.height, 25, true));
+        }
+        for (unsigned t = 0; t < frameCount; t++) {
+            src.write(sequence.source(t));
+            for (unsigned i = 0; i < pvs.size(); i++) {
+                pvs[i]->write(sequence.processed(t, parsed[i]));
+            }
+        }
+        src.close();
+        for (auto &writer : pvs) {
+            writer->close();
+        }
+    } catch (...) {
+        removeCases(cases);
+        throw;
+    }
+    return cases;
+}
+
+ResultRecord Equivalence::productionResult(const Case &c) {
+    std::unique_ptr<Algorithm> algorithm = Metrics::getAlgorithm("opvq");
+    std::vector<std::string> args = {"openvq", "-s", c.src, "-p", c.pvs, "-t", std::to_string(frameCount)};
+    std::vector<const char *> argv;
+    for (auto &arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    ResultRecord result;
+    algorithm->setResultListener([&result](const ResultRecord &record) { result = record; });
+    algorithm->init(static_cast<int>(argv.size()), argv.data());
+
+    /* Its logging and progress bar would bury the report; its own errors still show */
+    LogLevel threshold = Logger::getThreshold();
+    Logger::setThreshold(std::max(threshold, ERROR));
+    Logger::setProgressListener([](int, int) { });
+    int status = algorithm->run();
+    Logger::setThreshold(threshold);
+    Logger::setProgressListener(nullptr);
+    if (status != 0) {
+        throw std::runtime_error("opvq failed on " + c.name);
+    }
+    return result;
+}
+
+void Equivalence::compareCase(const Case &c) {
+    logger(INFO) << "Comparing " << c.name;
+    ResultRecord production = productionResult(c);
+
+    std::string srcName = c.src, pvsName = c.pvs;
+    VideoSequence srcSequence, pvsSequence;
+    VideoInfo info = srcSequence.init(srcName, static_cast<int>(frameCount), AV_PIX_FMT_YUV444P);
+    pvsSequence.init(pvsName, static_cast<int>(frameCount), AV_PIX_FMT_YUV444P);
+    std::vector<std::shared_ptr<Frame> > src, pvs;
+    for (std::shared_ptr<Frame> s = srcSequence.nextFrame(), p = pvsSequence.nextFrame(); s && p;
+         s = srcSequence.nextFrame(), p = pvsSequence.nextFrame()) {
+        src.push_back(s);
+        pvs.push_back(p);
+    }
+    unsigned n = static_cast<unsigned>(src.size());
+    if (n < 2) {
+        throw std::runtime_error(c.name + " has fewer than 2 frames");
+    }
+
+    int crop = ReferenceOPVQ::crop(info.width, info.height);
+    int width = info.width - 2 * crop;
+    int height = info.height - 2 * crop;
+
+    /* Alignment; the reference results are what every later kernel is fed */
+    SpatialAlignment alignment(n);
+    ColourAlignment srcColour(n), pvsColour(n);
+    std::vector<std::array<cv::Mat, 3> > srcHistograms(n), pvsHistograms(n);
+    std::vector<std::shared_ptr<Frame> > srcCropped(n), pvsAligned(n);
+    for (unsigned t = 0; t < n; t++) {
+        cv::Point2i offset = ReferenceOPVQ::spatialOffset(*src[t], *pvs[t], crop);
+        cv::Point2i production = alignment.spatialOffsetDetermination(src[t], pvs[t], crop);
+        add("spatial-offset", c.name, std::abs(production.x - offset.x) + std::abs(production.y - offset.y));
+
+        srcCropped[t] = std::make_shared<Frame>(*src[t]);
+        srcCropped[t]->adjustROI(-crop, -crop, -crop, -crop);
+        pvsAligned[t] = std::make_shared<Frame>(*pvs[t]);
+        pvsAligned[t]->adjustROI(-(crop + offset.y), -(crop - offset.y), -(crop + offset.x), -(crop - offset.x));
+
+        srcHistograms[t] = ReferenceOPVQ::histograms(*srcCropped[t]);
+        pvsHistograms[t] = ReferenceOPVQ::histograms(*pvsAligned[t]);
+        std::array<cv::Mat, 3> srcProduction = ColourAlignment::frameHistograms(*srcCropped[t]);
+        std::array<cv::Mat, 3> pvsProduction = ColourAlignment::frameHistograms(*pvsAligned[t]);
+        add("colour-histograms", c.name,
+            std::max(maxDifference(Frame(srcProduction[0], srcProduction[1], srcProduction[2]),
+                                   Frame(srcHistograms[t][0], srcHistograms[t][1], srcHistograms[t][2])),
+                     maxDifference(Frame(pvsProduction[0], pvsProduction[1], pvsProduction[2]),
+                                   Frame(pvsHistograms[t][0], pvsHistograms[t][1], pvsHistograms[t][2]))));
+        srcColour.setFrameHistograms(t, srcHistograms[t]);
+        pvsColour.setFrameHistograms(t, pvsHistograms[t]);
+    }
+
+    std::vector<cv::Mat> curves = ReferenceOPVQ::correctionCurves(srcHistograms, pvsHistograms, width, height);
+    srcColour.createCumulative(width, height);
+    pvsColour.createCumulative(width, height);
+    std::vector<cv::Mat> productionCurves = ColourAlignment::createCorrectionCurves(srcColour, pvsColour);
+    add("colour-curves", c.name, maxDifference(Frame(productionCurves[0], productionCurves[1], productionCurves[2]),
+                                               Frame(curves[0], curves[1], curves[2])));
+
+    /* Indicators */
+    double weightSum;
+    cv::Mat weights = ReferenceOPVQ::weights(width, height, weightSum);
+    LuminanceIndicator luminanceIndicator(n, width, height);
+    ChrominanceIndicator chrominanceIndicator(n, width, height);
+    TemporalVariabilityIndicators temporalIndicators(n);
+    std::vector<double> luminance(n), chrominance(n), omitted(n), introduced(n);
+    std::shared_ptr<Frame> pvsPrev;
+    for (unsigned t = 0; t < n; t++) {
+        std::shared_ptr<Frame> pvsCurr = std::make_shared<Frame>(ReferenceOPVQ::corrected(*pvsAligned[t], curves));
+        add("colour-correction", c.name,
+            maxDifference(*ColourAlignment::createCorrectedFrame(pvsAligned[t], curves), *pvsCurr));
+
+        std::shared_ptr<Frame> srcEdge = std::make_shared<Frame>(ReferenceOPVQ::edginess(*srcCropped[t]));
+        std::shared_ptr<Frame> pvsEdge = std::make_shared<Frame>(ReferenceOPVQ::edginess(*pvsCurr));
+        add("edginess", c.name, std::max(maxDifference(*EdginessImage::createEdginessImage(srcCropped[t]), *srcEdge),
+                                         maxDifference(*EdginessImage::createEdginessImage(pvsCurr), *pvsEdge)));
+
+        luminance[t] = ReferenceOPVQ::luminance(*srcCropped[t], *pvsCurr, *srcEdge, *pvsEdge, weights, weightSum);
+        luminanceIndicator.analyzeFrame(srcCropped[t], pvsCurr, srcEdge, pvsEdge, t);
+        add("luminance", c.name, std::fabs(luminanceIndicator.frameValue(t) - luminance[t]));
+
+        chrominance[t] = ReferenceOPVQ::chrominance(*srcCropped[t], *pvsCurr, *srcEdge, *pvsEdge, weights, weightSum);
+        chrominanceIndicator.analyzeFrame(srcCropped[t], pvsCurr, srcEdge, pvsEdge, t);
+        add("chrominance", c.name, std::fabs(chrominanceIndicator.frameValue(t) - chrominance[t]));
+
+        if (t > 0) {
+            ReferenceOPVQ::temporal(*srcCropped[t], *pvsCurr, *srcCropped[t - 1], *pvsPrev, omitted[t], introduced[t]);
+            temporalIndicators.analyzeFrame(srcCropped[t], pvsCurr, srcCropped[t - 1], pvsPrev, t);
+            add("omitted", c.name, std::fabs(temporalIndicators.frameOmitted(t) - omitted[t]));
+            add("introduced", c.name, std::fabs(temporalIndicators.frameIntroduced(t) - introduced[t]));
+        }
+        pvsPrev = pvsCurr;
+    }
+
+    std::vector<double> indicators = ReferenceOPVQ::pool(luminance, chrominance, omitted, introduced);
+    double dmos = ReferenceOPVQ::dmos(indicators, ReferenceOPVQ::coefficients(info.width, info.height));
+    add("dmos-mapping", c.name, std::fabs(DMOSMapper::score(indicators, OPVQ::resolutionData(info).coeff) - dmos));
+
+    /* End to end, with everything opvq does around the kernels */
+    std::vector<std::pair<std::string, double> > reference = {
+            {"opvq_luma",       indicators[LUMA_IND]},
+            {"opvq_chroma",     indicators[CHROMA_IND]},
+            {"opvq_introduced", indicators[INTRO_IND]},
+            {"opvq_omitted",    indicators[OMIT_IND]},
+            {"opvq_dmos",       dmos}
+    };
+    for (auto &value : reference) {
+        auto name = std::find(production.names.begin(), production.names.end(), value.first);
+        if (name == production.names.end()) {
+            throw std::runtime_error("opvq didn't write " + value.first);
+        }
+        add(value.first, c.name, std::fabs(production.values[name - production.names.begin()] - value.second));
+    }
+    logger(DEBUG) << c.name << ": " << n << " frames, reference DMOS " << dmos;
+}
+
+void Equivalence::removeCases(const std::vector<Case> &cases) {
+    for (auto &c : cases) {
+        if (c.generated) {
+            std::remove(c.src.c_str());
+            std::remove(c.pvs.c_str());
+        }
+    }
+}
+
+int Equivalence::run() {
+    try {
+        if (!srcURL.empty()) {
+            std::string pvs = pvsURL.empty() ? srcURL : pvsURL;
+            compareCase({pvs, srcURL, pvs, false});
+        }
+        for (auto &size : sizes) {
+            std::vector<Case> cases = generateCases(size);
+            try {
+                for (auto &c : cases) {
+                    compareCase(c);
+                }
+            } catch (...) {
+                removeCases(cases);
+                throw;
+            }
+            removeCases(cases);
+        }
+    } catch (std::exception &e) {
+        logger(ERROR) << e.what();
+        return 1;
+    }
+
+    std::ostringstream table;
+    table << std::left << std::setw(20) << "VALUE" << std::right << std::setw(9) << "SAMPLES" << std::setw(14)
+          << "MAX" << std::setw(14) << "MEAN" << std::setw(14) << "TOLERANCE" << "  " << std::left
+          << std::setw(6) << "" << "WORST" << std::endl;
+    bool passed = true;
+    for (auto &d : deviations) {
+        double mean = d.samples ? d.sum / d.samples : 0;
+        bool within = d.max <= d.tolerance;
+        passed = passed && within;
+        table << std::left << std::setw(20) << d.name << std::right << std::setw(9) << d.samples
+              << std::scientific << std::setprecision(3) << std::setw(14) << d.max << std::setw(14) << mean
+              << std::setw(14) << d.tolerance << "  " << std::left << std::setw(6) << (within ? "ok" : "FAIL")
+              << (d.max > 0 ? d.worst : "") << std::endl;
+        writeResult(d.name, {"samples", "max", "mean", "tolerance", "passed"},
+                    {static_cast<double>(d.samples), d.max, mean, d.tolerance, within ? 1.0 : 0.0});
+    }
+    logger(INFO) << "Absolute deviations from the reference kernels, per frame for kernels and per sequence for "
+                 << "opvq values" << std::endl << table.str();
+    flushResults();
+
+    if (!passed) {
+        logger(ERROR) << "Deviations exceed their tolerance";
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __EQUIVALENCE_H
+#define __EQUIVALENCE_H
+
+#include <io/Frame.h>
+#include <metrics/Algorithm.h>
+
+/*
+ * Compares the OPVQ kernels in use with the frozen copies in ReferenceOPVQ, so that faster implementations
+ * can't change scores unnoticed. Each kernel is fed the same frames as its reference, and opvq run end to
+ * end is compared with the reference pipeline, on synthetic clips written to --tmp-dir and on a given SRC
+ * and PVS. Reports the largest and mean absolute deviation of every kernel and value, and fails if one
+ * exceeds its tolerance.
+ */
+class Equivalence : public Algorithm {
+public:
+    Equivalence();
+
+    virtual void init(int argc, const char **argv) override;
+
+    int run() override;
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+private:
+    struct Case {
+        std::string name;
+        std::string src;
+        std::string pvs;
+        bool generated;
+    };
+
+    struct Deviation {
+        std::string name;
+        double tolerance;
+        unsigned samples;
+        double max;
+        double sum;
+        std::string worst;
+    };
+
+    std::string srcURL;
+    std::string pvsURL;
+    std::string sizeList;
+    std::string distortionList;
+    std::string toleranceList;
+    unsigned frameCount;
+    std::uint64_t seed;
+    std::string tmpDir;
+
+    std::vector<Deviation> deviations;
+    std::vector<std::string> sizes;
+    std::vector<std::string> distortions;
+
+    void add(const std::string &name, const std::string &caseName, double deviation);
+
+    /* Writes the SRC and a PVS for every distortion at one size */
+    std::vector<Case> generateCases(const std::string &size);
+
+    void removeCases(const std::vector<Case> &cases);
+
+    void compareCase(const Case &c);
+
+    /* Values opvq writes for the case, run as it would be from the command line */
+    ResultRecord productionResult(const Case &c);
+
+    static double maxDifference(const Frame &a, const Frame &b);
+};
+
+#endif //__EQUIVALENCE_H
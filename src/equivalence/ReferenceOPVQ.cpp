@@ -0,0 +1,542 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "ReferenceOPVQ.h"
+
+
+static const MappingCoefficients VGAcoeff = {
+        {0.0000000, 0.0888870, 0.0000000, 0.0000000},
+        {26.3458920, 11.9341383, 1603.3526610, 44.0389137},
+        {5.5178358, -61.9967023, -12.8507869, -0.2219432},
+        {0.1982675, 0.8956342, 0.0026048, 0.7256163},
+        {-1.9184154, -14.5877780, 2.3705606, -15.7681800},
+        63.1413711
+};
+static const MappingCoefficients CIFcoeff = {
+        {0.00000000, 0.0888870, 0.00000000, 0.00000000},
+        {26.34589190, 11.9341383, 1603.35266000, 44.03891370},
+        {5.31724460, 492.6884156, -26163.42844000, -1.28731130},
+        {0.18924704, 0.5660372, 0.00234274, 0.04960221},
+        {-1.83546050, 7.2721399, 10.06642100, -0.51780410},
+        1.6945190
+};
+static const MappingCoefficients QCIFcoeff = {
+        {0.0000000, 0.0888870, 0.0000000, 0.0000000},
+        {26.3458920, 11.9341383, 1603.3526600, 44.0389137},
+        {6.1842156, 2.5008131, -5699.5850910, -0.8661656},
+        {0.1683161, 1.3506481, 0.0036791, 0.3119277},
+        {-1.4493381, -17.7480150, 8.7293193, -6.7674783},
+        -0.9269844
+};
+
+int ReferenceOPVQ::crop(int width, int height) {
+    if (width == 352 && height == 288)
+        return 6;
+    if (width == 176 && height == 144)
+        return 3;
+    return 12;
+}
+
+MappingCoefficients ReferenceOPVQ::coefficients(int width, int height) {
+    if (width == 352 && height == 288)
+        return CIFcoeff;
+    if (width == 176 && height == 144)
+        return QCIFcoeff;
+    return VGAcoeff;
+}
+
+static void edginessFilter(const cv::Mat &in, cv::Mat &out, cv::Mat Kh, cv::Mat Kv) {
+    cv::Mat temp_y_h(in.rows, in.cols, in.type());
+    cv::Mat temp_y_v(in.rows, in.cols, in.type());
+    cv::Mat sqrtRes(in.rows, in.cols, in.type());
+
+    cv::filter2D(in, temp_y_h, CV_64F, Kh);
+    cv::filter2D(in, temp_y_v, CV_64F, Kv);
+
+    cv::pow(temp_y_h, 2.0, temp_y_h);
+    cv::pow(temp_y_v, 2.0, temp_y_v);
+
+    cv::Mat res(temp_y_h.rows, temp_y_h.cols, temp_y_h.type());
+    cv::add(temp_y_h, temp_y_v, res);
+
+    cv::sqrt(res, sqrtRes);
+    cv::dilate(sqrtRes, out, cv::Mat());
+}
+
+Frame ReferenceOPVQ::edginess(const Frame &frame) {
+    double filter1D[5] = {0.5, 0.5, 0, -0.5, -0.5};
+    double filter1DFlipped[5] = {-0.5, -0.5, 0, 0.5, 0.5};
+
+    cv::Mat Kv = cv::Mat(5, 1, CV_64FC1, &filter1D[0]);
+    cv::Mat Kh = cv::Mat(1, 5, CV_64FC1, &filter1DFlipped[0]);
+
+    Frame edge(frame.Y.rows, frame.Y.cols, CV_64FC1);
+    edginessFilter(frame.Y, edge.Y, Kh, Kv);
+    edginessFilter(frame.U, edge.U, Kh, Kv);
+    edginessFilter(frame.V, edge.V, Kh, Kv);
+    return edge;
+}
+
+cv::Mat ReferenceOPVQ::weights(int width, int height, double &sum) {
+    cv::Mat wij(height, width, CV_64FC1);
+    sum = 0;
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            double sinw = std::sin(M_PI * ((double) x / (double) width));
+            double sinh = std::sin(M_PI * ((double) y / (double) height));
+            wij.at<double>(y, x) = std::abs(sinw * sinh);
+            sum += wij.at<double>(y, x);
+        }
+    }
+    return wij;
+}
+
+double ReferenceOPVQ::luminance(const Frame &src, const Frame &pvs, const Frame &srcEdge, const Frame &pvsEdge,
+                                const cv::Mat &weights, double weightSum) {
+    cv::Mat corrSA, corrPA;
+    src.Y.convertTo(corrSA, CV_64FC1);
+    pvs.Y.convertTo(corrPA, CV_64FC1);
+
+    //dev = max( |SaY[i,j,t]-100|, |PaY[i,j,t]-100)
+    cv::Mat dev, SaYSub100, PaYSub100;
+    cv::subtract(corrSA, cv::Scalar(100.0), SaYSub100);
+    cv::subtract(corrPA, cv::Scalar(100.0), PaYSub100);
+    SaYSub100 = cv::abs(SaYSub100);
+    PaYSub100 = cv::abs(PaYSub100);
+    cv::max(SaYSub100, PaYSub100, dev);
+
+    cv::Mat eYNumer;
+    cv::subtract(pvsEdge.Y, srcEdge.Y, eYNumer);
+
+    cv::Mat eYDenom;
+    cv::add(srcEdge.Y, cv::Scalar(80.0), eYDenom);
+    cv::add(eYDenom, dev, eYDenom);
+
+    cv::Mat eY;
+    cv::divide(eYNumer, eYDenom, eY);
+    cv::multiply(eY, cv::Scalar(80.0), eY);
+
+    cv::min(eY, cv::Scalar(40.0), eY);
+    cv::max(eY, cv::Scalar(-40.0), eY);
+
+    eY = cv::abs(eY);
+    cv::pow(eY, 5.0, eY);
+    cv::multiply(eY, weights, eY);
+    double finalSum = cv::sum(eY)[0];
+    return cv::pow(finalSum / weightSum, 0.2);
+}
+
+double ReferenceOPVQ::chrominance(const Frame &src, const Frame &pvs, const Frame &srcEdge, const Frame &pvsEdge,
+                                  const cv::Mat &weights, double weightSum) {
+    cv::Mat srcUCorr, srcVCorr, pvsUCorr, pvsVCorr;
+    src.U.convertTo(srcUCorr, CV_64FC1);
+    src.V.convertTo(srcVCorr, CV_64FC1);
+    pvs.U.convertTo(pvsUCorr, CV_64FC1);
+    pvs.V.convertTo(pvsVCorr, CV_64FC1);
+
+    //MX = sqrt(pow(SaU-128) + pow(SaV-128));
+    cv::Mat mxCbSub, mxCrSub, mxMat;
+    cv::subtract(srcUCorr, cv::Scalar(128.0), mxCbSub);
+    cv::subtract(srcVCorr, cv::Scalar(128.0), mxCrSub);
+    cv::pow(mxCbSub, 2, mxCbSub);
+    cv::pow(mxCrSub, 2, mxCrSub);
+    cv::add(mxCbSub, mxCrSub, mxMat);
+    cv::sqrt(mxMat, mxMat);
+
+    //MY = sqrt(pow(PaU-128) + pow(PaV-128));
+    cv::Mat myCbSub, myCrSub, myMat;
+    cv::subtract(pvsUCorr, cv::Scalar(128.0), myCbSub);
+    cv::subtract(pvsVCorr, cv::Scalar(128.0), myCrSub);
+    cv::pow(myCbSub, 2, myCbSub);
+    cv::pow(myCrSub, 2, myCrSub);
+    cv::add(myCbSub, myCrSub, myMat);
+    cv::sqrt(myMat, myMat);
+
+    cv::Mat devCbCr, ZP8MulDevCbCr;
+    cv::max(mxMat, myMat, devCbCr);
+    cv::multiply(cv::Scalar(0.8), devCbCr, ZP8MulDevCbCr);
+
+    cv::Mat eCb, eCbNumer, eCbDenom;
+    cv::subtract(pvsEdge.U, srcEdge.U, eCbNumer);
+    cv::add(srcEdge.U, cv::Scalar(40.0), eCbDenom);
+    cv::add(eCbDenom, ZP8MulDevCbCr, eCbDenom);
+    cv::divide(eCbNumer, eCbDenom, eCb);
+    cv::multiply(eCb, cv::Scalar(40.0), eCb);
+
+    cv::Mat eCr, eCrNumer, eCrDenom;
+    cv::subtract(pvsEdge.V, srcEdge.V, eCrNumer);
+    cv::add(srcEdge.V, cv::Scalar(40.0), eCrDenom);
+    cv::add(eCrDenom, ZP8MulDevCbCr, eCrDenom);
+    cv::divide(eCrNumer, eCrDenom, eCr);
+    cv::multiply(eCr, cv::Scalar(40.0), eCr);
+
+    cv::Mat eCbClipped, eCrClipped;
+    cv::min(eCb, cv::Scalar(40.0), eCbClipped);
+    cv::max(eCbClipped, cv::Scalar(-40.0), eCbClipped);
+    cv::min(eCr, cv::Scalar(40.0), eCrClipped);
+    cv::max(eCrClipped, cv::Scalar(-40.0), eCrClipped);
+
+    cv::Mat eCbWijMul, eCrWijMul;
+    cv::multiply(cv::abs(eCbClipped), weights, eCbWijMul);
+    cv::multiply(cv::abs(eCrClipped), weights, eCrWijMul);
+
+    cv::Mat eCbWijDiv, eCrWijDiv;
+    cv::divide(eCbWijMul, cv::Scalar(weightSum), eCbWijDiv);
+    cv::divide(eCrWijMul, cv::Scalar(weightSum), eCrWijDiv);
+
+    return 0.5 * (cv::sum(eCbWijDiv)[0] + cv::sum(eCrWijDiv)[0]);
+}
+
+void ReferenceOPVQ::temporal(const Frame &srcCurr, const Frame &pvsCurr, const Frame &srcPrev, const Frame &pvsPrev,
+                             double &omitted, double &introduced) {
+    cv::Mat saDiff, paDiff;
+    cv::Mat(cv::abs(srcCurr.Y - srcPrev.Y)).convertTo(saDiff, CV_64F);
+    cv::Mat(cv::abs(pvsCurr.Y - pvsPrev.Y)).convertTo(paDiff, CV_64F);
+    cv::Mat d = saDiff - paDiff;
+
+    /* L norm over space (== mean) */
+    cv::Mat do_orig(cv::max(d, 0));
+    omitted = cv::mean(do_orig)[0];
+
+    /* L5 norm over space */
+    cv::Mat di_orig(cv::abs(cv::min(d, 0))), di_t;
+    cv::pow(di_orig, 5.0, di_orig);
+    cv::pow(cv::sum(di_orig / (di_orig.cols * di_orig.rows)), 1.0 / 5.0, di_t);
+    introduced = di_t.at<double>(0);
+}
+
+cv::Point2i ReferenceOPVQ::spatialOffset(const Frame &srcFrame, const Frame &pvsFrame, int crop) {
+    double minimizedError = std::numeric_limits<double>::max();
+
+    cv::Mat src(srcFrame.Y);
+    src.adjustROI(-crop, -crop, -crop, -crop);
+
+    cv::Point2i offset;
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            cv::Mat candidate, diffSquared;
+            candidate = cv::Mat(pvsFrame.Y);
+            candidate.adjustROI(-(crop + dy), -(crop - dy), -(crop + dx), -(crop - dx));
+            cv::pow(src - candidate, 2, diffSquared);
+            double error = cv::sum(diffSquared)[0];
+
+            if (error < minimizedError) {
+                minimizedError = error;
+                offset.x = dx;
+                offset.y = dy;
+            }
+        }
+    }
+    return offset;
+}
+
+std::array<cv::Mat, 3> ReferenceOPVQ::histograms(const Frame &frame) {
+    static int sizes[] = {256};
+    static int channels[] = {0};
+    static float range[] = {0, 256};
+    static const float *ranges[] = {range};
+
+    std::array<cv::Mat, 3> histograms;
+    cv::calcHist(&frame.Y, 1, channels, cv::Mat(), histograms[0], 1, sizes, ranges, true, false);
+    cv::calcHist(&frame.U, 1, channels, cv::Mat(), histograms[1], 1, sizes, ranges, true, false);
+    cv::calcHist(&frame.V, 1, channels, cv::Mat(), histograms[2], 1, sizes, ranges, true, false);
+    return histograms;
+}
+
+std::vector<cv::Mat> ReferenceOPVQ::correctionCurves(const std::vector<std::array<cv::Mat, 3> > &src,
+                                                     const std::vector<std::array<cv::Mat, 3> > &pvs,
+                                                     int width, int height) {
+    /* Normalized histograms and their cumulative sums of the whole sequence, per plane */
+    std::vector<float> hist[2][3], cumulative[2][3];
+    const std::vector<std::array<cv::Mat, 3> > *sequences[] = {&src, &pvs};
+    for (int s = 0; s < 2; s++) {
+        for (int c = 0; c < 3; c++) {
+            const std::vector<std::array<cv::Mat, 3> > &frames = *sequences[s];
+            cv::Mat h, cum(256, 1, CV_32FC1, cv::Scalar(0));
+            frames[0][c].copyTo(h);
+            for (unsigned t = 1; t < frames.size(); t++) {
+                h += frames[t][c];
+            }
+            double scale = 1.0 / (frames.size() * width * height);
+            cv::multiply(h, cv::Scalar(scale), h);
+
+            cum.at<float>(0, 0) = h.at<float>(0, 0);
+            for (int i = 1; i < h.rows; i++) {
+                cv::add(h.row(i), cum.row(i - 1), cum.row(i));
+            }
+            h.copyTo(hist[s][c]);
+            cum.copyTo(cumulative[s][c]);
+        }
+    }
+
+    std::vector<cv::Mat> curves(3);
+    lumaCorrectionCurve(hist[0][0], hist[1][0], cumulative[0][0], cumulative[1][0], curves[0]);
+    chromaCorrectionCurve(hist[0][1], hist[1][1], cumulative[0][1], cumulative[1][1], curves[1]);
+    chromaCorrectionCurve(hist[0][2], hist[1][2], cumulative[0][2], cumulative[1][2], curves[2]);
+    return curves;
+}
+
+void ReferenceOPVQ::lumaCorrectionCurve(const std::vector<float> &hs, const std::vector<float> &hp,
+                                        const std::vector<float> &HCs, const std::vector<float> &HCp,
+                                        cv::Mat &curve) {
+    int binS = 0;
+    int binP = 128;
+    std::vector<std::uint8_t> out_correctionCurve(256);
+
+    float fracS = hs[binS];
+    float cumFracS = HCs[binS];
+    float fracP = hp[binP];
+    float cumFracP = HCp[binP];
+
+    float tarS = 0;
+    int steepnessS = 0;
+    while ((HCs[binS] < cumFracP) && binS < 255) {
+        binS++;
+    }
+
+    for (binP = 128; binP < 256; binP++) {
+        fracP = hp[binP];
+        cumFracP = HCp[binP];
+        if (binS < 255) {
+            if ((fracS < 0.0008) && fracP < 0.0008) {
+                binS++;
+                fracS = hs[binS];
+                cumFracS = HCs[binS];
+
+                tarS = static_cast<float>(binS);
+            }
+            else {
+                steepnessS = 0;
+                while (cumFracS < cumFracP && binS < 255 && steepnessS <= 50) {
+                    binS++;
+                    steepnessS++;
+                    fracS = hs[binS];
+                    cumFracS = HCs[binS];
+                }
+                if (cumFracS >= cumFracP) {
+                    tarS = (binS - 1) * (HCs[binS] - cumFracP) + binS * ((cumFracP - HCs[binS - 1]) / (HCs[binS] - HCs[binS - 1]));
+                    tarS = std::max(tarS, static_cast<float>(binS - 1));
+                    tarS = std::min(tarS, static_cast<float>(binS));
+                }
+                else {
+                    tarS = static_cast<float>(binS);
+                }
+            }
+
+        }
+        out_correctionCurve[binP] = static_cast<std::uint8_t>(std::round(tarS));
+    }
+
+    binS = 255;
+    fracS = hs[binS];
+    cumFracS = HCs[binS];
+
+    cumFracP = HCp[128];
+    while (HCs[binS] >= cumFracP && binS >= 0) {
+        binS--;
+    }
+
+    for (binP = 127; binP >= 0; binP--) {
+        fracP = hp[binP];
+        cumFracP = HCp[binP];
+        if (binS > 0) {
+            if (fracS < 0.0008 && fracP < 0.0008) {
+                binS--;
+                fracS = hs[binS];
+                cumFracS = HCs[binS];
+                tarS = static_cast<float>(binS);
+            }
+            else {
+                steepnessS = 0;
+                while (cumFracS > cumFracP && binS >= 0 && steepnessS <= 50) {
+                    binS--;
+                    steepnessS++;
+                    fracS = hs[binS];
+                    cumFracS = HCs[binS];
+                }
+                if (cumFracS <= cumFracP) {
+                    tarS = binS * (HCs[binS + 1] - cumFracP) + (binS + 1) * ((cumFracP - HCs[binS]) / (HCs[binS + 1] - HCs[binS]));
+                    tarS = std::max(tarS, static_cast<float>(binS));
+                    tarS = std::min(tarS, static_cast<float>(binS + 1));
+                }
+                else {
+                    tarS = static_cast<float>(binS);
+                }
+            }
+        }
+        out_correctionCurve[binP] = static_cast<std::uint8_t>(std::round(tarS));
+    }
+
+    cv::Mat temp(256, 1, CV_8UC1);
+    memcpy(temp.data, out_correctionCurve.data(), 256);
+    temp.copyTo(curve);
+}
+
+void ReferenceOPVQ::chromaCorrectionCurve(const std::vector<float> &hs, const std::vector<float> &hp,
+                                          const std::vector<float> &HCs, const std::vector<float> &HCp,
+                                          cv::Mat &curve) {
+    int binS = 0;
+    int binP = 128;
+    std::vector<std::uint8_t> out_correctionCurve(256);
+
+    double fracS = hs[binS];
+    double cumFracS = HCs[binS];
+    double fracP = hp[binP];
+    double cumFracP = HCp[binP];
+    double tarS = 0.0;
+    int oldBinS = binS;
+    double steps = 0.0;
+
+    while ((HCs[binS] < cumFracP) && (binS < 255)) {
+        binS++;
+    }
+    for (binP = 128; binP < 256; binP++) {
+        steps = steps + 0.5;
+        fracP = hp[binP];
+        cumFracP = HCp[binP];
+
+        if (binS < 255) {
+            if ((fracS < 0.0008) && (fracP < 0.0008)) {
+                binS++;
+                fracS = hs[binS];
+                cumFracS = HCs[binS];
+                tarS = static_cast<double>(binS);
+            }
+            else {
+                while ((cumFracS < cumFracP) && (binS < 255)) {
+                    binS++;
+                    fracS = hs[binS];
+                    cumFracS = HCs[binS];
+                }
+                if (cumFracS >= cumFracP) {
+                    tarS = (binS - 1) * (HCs[binS] - cumFracP) + (binS) * ((cumFracP - HCs[binS - 1]) / (HCs[binS] - HCs[binS - 1]));
+                    tarS = std::max(tarS, static_cast<double>(binS - 1));
+                    tarS = std::min(tarS, static_cast<double>(binS));
+                }
+                else {
+                    tarS = static_cast<double>(binS);
+                }
+            }
+        }
+        if (steps >= 1) {
+            if (((binS - oldBinS) / steps) < 1) {
+                binS++;
+                tarS++;
+            }
+            steps = 0;
+            oldBinS = binS;
+        }
+        out_correctionCurve[binP] = static_cast<int>(round(tarS));
+    }
+
+    binS = 255;
+    fracS = hs[binS];
+    cumFracS = HCs[binS];
+    oldBinS = binS;
+
+    steps = 0;
+    cumFracP = HCp[128];
+    while ((HCs[binS] >= cumFracP) && (binS > 0)) {
+        binS--;
+    }
+    for (binP = 127; binP >= 0; binP--) {
+        steps = steps + 0.5;
+        fracP = hp[binP];
+        cumFracP = HCp[binP];
+        if (binS > 0) {
+            if ((fracS < 0.0008) && (fracP < 0.0008)) {
+                binS--;
+                fracS = hs[binS];
+                cumFracS = HCs[binS];
+            }
+            else {
+                while ((cumFracS > cumFracP) && (binS >= 0)) {
+                    binS--;
+                    fracS = hs[binS];
+                    cumFracS = HCs[binS];
+                    tarS = static_cast<double>(binS);
+                }
+                if (cumFracS <= cumFracP) {
+                    tarS = (binS) * (HCs[binS + 1] - cumFracP) + (binS + 1) * ((cumFracP - HCs[binS]) / (HCs[binS + 1] - HCs[binS]));
+                    tarS = std::max(tarS, static_cast<double>(binS));
+                    tarS = std::min(tarS, static_cast<double>(binS + 1));
+                }
+                else {
+                    tarS = static_cast<double>(binS);
+                }
+            }
+        }
+        if (steps >= 1) {
+            if ((static_cast<double>(oldBinS - binS) / steps) < 1.0) {
+                binS++;
+                tarS++;
+            }
+            steps = 0;
+            oldBinS = binS;
+        }
+        out_correctionCurve[binP] = static_cast<int>(round(tarS));
+    }
+
+    cv::Mat temp(256, 1, CV_8UC1);
+    memcpy(temp.data, out_correctionCurve.data(), 256);
+    temp.copyTo(curve);
+}
+
+Frame ReferenceOPVQ::corrected(const Frame &frame, const std::vector<cv::Mat> &curves) {
+    Frame corrected = Frame(cv::Mat(), cv::Mat(), cv::Mat());
+    cv::LUT(frame.Y, curves[0], corrected.Y);
+    cv::LUT(frame.U, curves[1], corrected.U);
+    cv::LUT(frame.V, curves[2], corrected.V);
+    return corrected;
+}
+
+std::vector<double> ReferenceOPVQ::pool(const std::vector<double> &luminance, const std::vector<double> &chrominance,
+                                        const std::vector<double> &omitted, const std::vector<double> &introduced) {
+    std::vector<double> indicators(NUM_IND);
+
+    double luminanceSum = 0.0, chrominanceSum = 0.0;
+    for (unsigned t = 0; t < luminance.size(); t++) {
+        luminanceSum += luminance[t];
+        chrominanceSum += chrominance[t];
+    }
+    indicators[LUMA_IND] = (1.0 / static_cast<double>(luminance.size())) * luminanceSum;
+    indicators[CHROMA_IND] = chrominanceSum / static_cast<double>(chrominance.size());
+
+    cv::Mat d_omitted(1, static_cast<int>(omitted.size()) - 1, CV_64FC1);
+    cv::Mat d_introduced(1, static_cast<int>(introduced.size()) - 1, CV_64FC1);
+    for (unsigned t = 1; t < omitted.size(); t++) {
+        d_omitted.at<double>(t - 1) = omitted[t];
+        d_introduced.at<double>(t - 1) = introduced[t];
+    }
+    indicators[OMIT_IND] = cv::mean(d_omitted)[0];
+    indicators[INTRO_IND] = cv::norm(d_introduced, cv::NORM_L2) / cv::sqrt(d_introduced.cols);
+    return indicators;
+}
+
+double ReferenceOPVQ::dmos(const std::vector<double> &indicators, const MappingCoefficients &coeff) {
+    double score = coeff.LinearOffset;
+    for (unsigned i = 0; i < NUM_IND; i++) {
+        double limited = std::max(std::min(indicators[i], coeff.Imax[i]), coeff.Imin[i]);
+        score += coeff.w[i] / (1 + std::exp(coeff.alpha[i] * limited + coeff.beta[i]));
+    }
+    return std::max(std::min(score, 5.0), 1.0);
+}
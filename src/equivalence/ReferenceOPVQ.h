@@ -0,0 +1,84 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ReferenceOPVQ_h
+#define ReferenceOPVQ_h
+
+#include <array>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include <io/Frame.h>
+#include <metrics/opvq/score/DMOSMapper.h>
+
+
+/*
+ * Frozen copies of the OPVQ kernels as they were when the equivalence check was added: edginess, the
+ * luminance, chrominance and temporal indicators, spatial and colour alignment and the DMOS mapping.
+ * They are the oracles faster implementations are compared against, so they must not be optimized or
+ * otherwise changed.
+ */
+class ReferenceOPVQ {
+public:
+    /* Crop and mapping of a frame size, those of VGA for unsupported sizes */
+    static int crop(int width, int height);
+
+    static MappingCoefficients coefficients(int width, int height);
+
+    static Frame edginess(const Frame &frame);
+
+    /* sin(pi x / width) * sin(pi y / height), the spatial weights of the luminance and chrominance indicators */
+    static cv::Mat weights(int width, int height, double &sum);
+
+    static double luminance(const Frame &src, const Frame &pvs, const Frame &srcEdge, const Frame &pvsEdge,
+                            const cv::Mat &weights, double weightSum);
+
+    static double chrominance(const Frame &src, const Frame &pvs, const Frame &srcEdge, const Frame &pvsEdge,
+                              const cv::Mat &weights, double weightSum);
+
+    /* Omitted and introduced terms of the current frame */
+    static void temporal(const Frame &srcCurr, const Frame &pvsCurr, const Frame &srcPrev, const Frame &pvsPrev,
+                         double &omitted, double &introduced);
+
+    static cv::Point2i spatialOffset(const Frame &src, const Frame &pvs, int crop);
+
+    static std::array<cv::Mat, 3> histograms(const Frame &frame);
+
+    /* Y, U and V curves from the histograms of all frames of SRC and PVS */
+    static std::vector<cv::Mat> correctionCurves(const std::vector<std::array<cv::Mat, 3> > &src,
+                                                 const std::vector<std::array<cv::Mat, 3> > &pvs,
+                                                 int width, int height);
+
+    static Frame corrected(const Frame &frame, const std::vector<cv::Mat> &curves);
+
+    /* Indicators pooled over the sequence in the order of DMOSMapper, the omitted and introduced terms
+     * of the first frame are left out */
+    static std::vector<double> pool(const std::vector<double> &luminance, const std::vector<double> &chrominance,
+                                    const std::vector<double> &omitted, const std::vector<double> &introduced);
+
+    static double dmos(const std::vector<double> &indicators, const MappingCoefficients &coeff);
+
+private:
+    static void lumaCorrectionCurve(const std::vector<float> &hs, const std::vector<float> &hp,
+                                    const std::vector<float> &HCs, const std::vector<float> &HCp, cv::Mat &curve);
+
+    static void chromaCorrectionCurve(const std::vector<float> &hs, const std::vector<float> &hp,
+                                      const std::vector<float> &HCs, const std::vector<float> &HCp, cv::Mat &curve);
+};
+
+#endif //ReferenceOPVQ_h
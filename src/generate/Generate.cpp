@@ -0,0 +1,149 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+
+#include <io/VideoProperties.h>
+#include <io/Y4mWriter.h>
+
+#include "Generate.h"
+
+
+static std::vector<std::string> listItems(const std::string &list) {
+    std::vector<std::string> items;
+    boost::algorithm::split(items, list, boost::algorithm::is_any_of(","), boost::algorithm::token_compress_on);
+    items.erase(std::remove(items.begin(), items.end(), ""), items.end());
+    return items;
+}
+
+Generate::Generate()
+        : Algorithm("Generate") {
+    options.add_options()
+            ("sizes", opts::value<std::string>(&sizeList)->default_value("qcif,cif,vga"),
+             ("Resolutions to generate, comma separated {all," + VideoProperties::resolutionNames() + "}").c_str())
+            ("frames", opts::value<unsigned>(&frameCount)->default_value(60), "Frames of every sequence")
+            ("seed", opts::value<std::uint64_t>(&seed)->default_value(1), "Seed of the content and the noise")
+            ("framerate", opts::value<int>(&framerate)->default_value(25), "Frame rate written to the files")
+            ("distortions", opts::value<std::string>(&distortionList)->default_value(
+                    "blur,blockiness,noise,colour-shift,spatial-shift,dropped-frames"),
+             "PVS to make of every SRC, comma separated. Each is a distortion or several joined by +, optionally "
+             "with a strength, e.g. blur:0.8+noise:3 {blur,blockiness,noise,colour-shift,spatial-shift,"
+             "dropped-frames}")
+            ("yuv444", opts::bool_switch(&yuv444), "Write chroma at full resolution instead of 4:2:0")
+            ("output-dir,o", opts::value<std::string>(&outputDir)->default_value("."),
+             "Directory the sequences and manifest.csv are written to")
+            ("metric", opts::value<std::string>(&metric)->default_value("opvq"), "Metric of the manifest lines");
+}
+
+void Generate::configure(const opts::variables_map &vm) {
+    if (frameCount == 0 || framerate <= 0) {
+        throw std::runtime_error("Sequences need at least one frame and a positive frame rate");
+    }
+
+    resolutions.clear();
+    for (auto &size : listItems(sizeList)) {
+        if (size == "all") {
+            for (int i = 0; i != RES_UNSUPPORTED; i++) {
+                resolutions.push_back(static_cast<ResolutionID>(i));
+            }
+            continue;
+        }
+        ResolutionID resolution = VideoProperties::resolutionByName(size);
+        if (resolution == RES_UNSUPPORTED) {
+            throw std::runtime_error("Unknown resolution \"" + size + "\", expected one of " +
+                                     VideoProperties::resolutionNames());
+        }
+        resolutions.push_back(resolution);
+    }
+
+    variants.clear();
+    for (auto &spec : listItems(distortionList)) {
+        /* The spec names the file, so keep it to characters that are safe there */
+        std::string name = spec;
+        std::replace(name.begin(), name.end(), ':', '_');
+        variants.emplace_back(name, SyntheticSequence::parseDistortions(spec));
+    }
+
+    if (resolutions.empty()) {
+        throw std::runtime_error("Nothing to generate");
+    }
+}
+
+void Generate::init(int argc, const char **argv) {
+    parseOptions(argc, argv);
+}
+
+int Generate::run() {
+    std::string manifestURL = outputDir + "/manifest.csv";
+    std::ofstream manifest(manifestURL, std::ios::trunc);
+    if (!manifest) {
+        logger(ERROR) << "Could not write " << manifestURL;
+        return 1;
+    }
+    manifest << "metric,src,pvs" << std::endl;
+
+    try {
+        for (ResolutionID resolution : resolutions) {
+            const ResolutionInfo &info = VideoProperties::resolutionInfo[resolution];
+            logger(INFO) << "Generating " << frameCount << " frames of SRC and " << variants.size() << " PVS at "
+                         << info.width << "x" << info.height;
+
+            SyntheticSequence sequence(info.width, info.height, frameCount, seed);
+            std::string srcURL = outputDir + "/" + info.name + "-src.y4m";
+            Y4mWriter src(srcURL, info.width, info.height, framerate, !yuv444);
+            std::vector<std::unique_ptr<Y4mWriter>> pvs;
+            for (auto &variant : variants) {
+                std::string pvsURL = outputDir + "/" + info.name + "-" + variant.first + ".y4m";
+                pvs.emplace_back(new Y4mWriter(pvsURL, info.width, info.height, framerate, !yuv444));
+                manifest << metric << "," << srcURL << "," << pvsURL << std::endl;
+            }
+
+            Logger::initProgress();
+            for (unsigned t = 0; t < frameCount; t++) {
+                src.write(sequence.source(t));
+                for (std::size_t i = 0; i < variants.size(); i++) {
+                    pvs[i]->write(sequence.processed(t, variants[i].second));
+                }
+                Logger::logProgress(t + 1, frameCount);
+            }
+            Logger::resetProgress();
+
+            src.close();
+            for (auto &writer : pvs) {
+                writer->close();
+            }
+        }
+    } catch (std::exception &e) {
+        Logger::resetProgress();
+        logger(ERROR) << e.what();
+        return 1;
+    }
+
+    manifest.close();
+    if (!manifest) {
+        logger(ERROR) << "Could not write " << manifestURL;
+        return 1;
+    }
+    logger(INFO) << "Wrote " << manifestURL;
+    return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GENERATE_H
+#define __GENERATE_H
+
+#include <io/SyntheticSequence.h>
+#include <metrics/Algorithm.h>
+
+/*
+ * Writes a corpus of synthetic SRC sequences and distorted PVS of them as Y4M files, the same for the
+ * same --seed, along with a batch manifest that scores every PVS against its SRC.
+ */
+class Generate : public Algorithm {
+public:
+    Generate();
+
+    virtual void init(int argc, const char **argv) override;
+
+    int run() override;
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+private:
+    std::string sizeList;
+    std::string distortionList;
+    unsigned frameCount;
+    std::uint64_t seed;
+    int framerate;
+    bool yuv444;
+    std::string outputDir;
+    std::string metric;
+
+    std::vector<ResolutionID> resolutions;
+    std::vector<std::pair<std::string, std::vector<SyntheticSequence::Distortion>>> variants;
+};
+
+#endif //__GENERATE_H
@@ -0,0 +1,161 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <vector>
+
+#include "ContentHash.h"
+
+
+static const std::uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+static const std::uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const std::uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+static const std::uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+static const std::uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+static inline std::uint64_t rotl(std::uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Little endian loads, byte by byte so unaligned input is fine
+static inline std::uint64_t read64(const unsigned char *p) {
+    std::uint64_t v = 0;
+    for (int i = 7; i >= 0; i--)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static inline std::uint32_t read32(const unsigned char *p) {
+    return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 |
+           static_cast<std::uint32_t>(p[2]) << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+ContentHash::ContentHash(std::uint64_t seed)
+        : seed(seed), totalLength(0), buffered(0) {
+    acc[0] = seed + PRIME1 + PRIME2;
+    acc[1] = seed + PRIME2;
+    acc[2] = seed;
+    acc[3] = seed - PRIME1;
+}
+
+std::uint64_t ContentHash::round(std::uint64_t acc, std::uint64_t input) {
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+std::uint64_t ContentHash::mergeRound(std::uint64_t acc, std::uint64_t value) {
+    acc ^= round(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+void ContentHash::consumeStripe(const unsigned char *stripe) {
+    acc[0] = round(acc[0], read64(stripe));
+    acc[1] = round(acc[1], read64(stripe + 8));
+    acc[2] = round(acc[2], read64(stripe + 16));
+    acc[3] = round(acc[3], read64(stripe + 24));
+}
+
+void ContentHash::update(const void *data, std::size_t length) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    totalLength += length;
+
+    if (buffered + length < sizeof(buffer)) {
+        std::memcpy(buffer + buffered, p, length);
+        buffered += length;
+        return;
+    }
+    if (buffered > 0) {
+        std::size_t fill = sizeof(buffer) - buffered;
+        std::memcpy(buffer + buffered, p, fill);
+        consumeStripe(buffer);
+        p += fill;
+        length -= fill;
+        buffered = 0;
+    }
+    for (; length >= sizeof(buffer); p += sizeof(buffer), length -= sizeof(buffer)) {
+        consumeStripe(p);
+    }
+    std::memcpy(buffer, p, length);
+    buffered = length;
+}
+
+std::uint64_t ContentHash::digest() const {
+    std::uint64_t h;
+    if (totalLength >= sizeof(buffer)) {
+        h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+        for (int i = 0; i < 4; i++)
+            h = mergeRound(h, acc[i]);
+    } else {
+        h = seed + PRIME5;
+    }
+    h += totalLength;
+
+    const unsigned char *p = buffer;
+    std::size_t remaining = buffered;
+    for (; remaining >= 8; p += 8, remaining -= 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+    }
+    if (remaining >= 4) {
+        h ^= read32(p) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+        remaining -= 4;
+    }
+    for (; remaining > 0; p++, remaining--) {
+        h ^= *p * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+std::uint64_t ContentHash::file(const std::string &path) {
+    std::unique_ptr<FILE, int (*)(FILE *)> f(std::fopen(path.c_str(), "rb"), std::fclose);
+    if (!f) {
+        throw std::runtime_error("Could not open " + path + " for hashing");
+    }
+
+    ContentHash hash;
+    std::vector<unsigned char> chunk(1 << 20);
+    std::size_t n;
+    while ((n = std::fread(chunk.data(), 1, chunk.size(), f.get())) > 0) {
+        hash.update(chunk.data(), n);
+    }
+    if (std::ferror(f.get())) {
+        throw std::runtime_error("Could not read " + path + " for hashing");
+    }
+    return hash.digest();
+}
+
+std::string ContentHash::hex(std::uint64_t hash) {
+    std::ostringstream out;
+    out << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return out.str();
+}
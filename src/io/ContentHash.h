@@ -0,0 +1,55 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ContentHash_h
+#define ContentHash_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+/* Streaming 64-bit XXH64 hash, used to recognise inputs by their content rather than their path */
+class ContentHash {
+public:
+    ContentHash(std::uint64_t seed = 0);
+
+    void update(const void *data, std::size_t length);
+
+    std::uint64_t digest() const;
+
+    /* Hash of the complete file contents */
+    static std::uint64_t file(const std::string &path);
+
+    static std::string hex(std::uint64_t hash);
+
+private:
+    std::uint64_t seed;
+    std::uint64_t acc[4];
+    std::uint64_t totalLength;
+    unsigned char buffer[32];
+    std::size_t buffered;
+
+    static std::uint64_t round(std::uint64_t acc, std::uint64_t input);
+
+    static std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t value);
+
+    void consumeStripe(const unsigned char *stripe);
+};
+
+#endif //ContentHash_h
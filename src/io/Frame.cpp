@@ -32,4 +32,11 @@ Frame::Frame(int rows, int cols, int type)
 
 Frame::Frame(cv::Mat y, cv::Mat u, cv::Mat v)
         : Y(y), U(u), V(v) {
-}
\ No newline at end of file
+}
+std::size_t Frame::bytes() const {
+    return Y.total() * Y.elemSize() + U.total() * U.elemSize() + V.total() * V.elemSize();
+}
+
+void Frame::account(MemoryAccounting::Category category) {
+    allocation = std::make_shared<const MemoryAccounting::Allocation>(category, bytes());
+}
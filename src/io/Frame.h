@@ -19,15 +19,26 @@
 #ifndef __FRAME_H
 #define __FRAME_H
 
+#include <memory>
 #include <opencv2/opencv.hpp>
 
+#include "MemoryAccounting.h"
+
 struct Frame {
     Frame(cv::Mat y, cv::Mat u, cv::Mat v);
     Frame(int rows, int cols, int type);
 
     cv::Mat Y, U, V;
 
+    /* Accounts the planes' bytes until the last Frame sharing them is gone, set by whoever allocated them */
+    std::shared_ptr<const MemoryAccounting::Allocation> allocation;
+
     void adjustROI(int dtop, int dbottom, int dleft, int dright);
+
+    /* Bytes of the three planes */
+    std::size_t bytes() const;
+
+    void account(MemoryAccounting::Category category);
 };
 
 #endif
\ No newline at end of file
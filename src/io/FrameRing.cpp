@@ -0,0 +1,230 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "FrameRing.h"
+
+
+static const char MAGIC[8] = "OPVQRNG";
+static const std::uint32_t VERSION = 1;
+static const std::size_t HEADER_SPACE = 4096;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The ring indices must be lock free to be shared between processes");
+
+/* The other side of the ring is another process, so waiting is polling with a short sleep */
+static void pause(unsigned &spins) {
+    if (spins++ < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+static std::string shmName(const std::string &name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+Logger FrameRing::logger = Logger("FrameRing");
+
+FrameRing::FrameRing(const std::string &name, bool producer)
+        : name(shmName(name)), producer(producer), header(nullptr), slotData(nullptr), mappingSize(0),
+          mappedBytes(MemoryAccounting::FRAMES), next(0) {
+}
+
+FrameRing::~FrameRing() {
+    if (header) {
+        munmap(header, mappingSize);
+    }
+    if (producer) {
+        shm_unlink(name.c_str());
+    }
+}
+
+void FrameRing::map(int fd, std::size_t size) {
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        throw std::runtime_error("Could not map frame ring " + name + ": " + std::strerror(errno));
+    }
+    header = static_cast<Header *>(p);
+    slotData = static_cast<std::uint8_t *>(p) + HEADER_SPACE;
+    mappingSize = size;
+    mappedBytes.resize(size);
+}
+
+std::shared_ptr<FrameRing> FrameRing::create(const std::string &name, int width, int height, int frameCount,
+                                             unsigned slots, float avgFramerate) {
+    if (width <= 0 || height <= 0 || frameCount <= 0 || slots < 3) {
+        throw std::runtime_error("A frame ring needs a frame size, a frame count and at least 3 slots");
+    }
+    std::shared_ptr<FrameRing> ring(new FrameRing(name, true));
+    ring->self = ring;
+
+    std::uint64_t slotSize = (3 * static_cast<std::uint64_t>(width) * height + 63) & ~static_cast<std::uint64_t>(63);
+    std::size_t size = HEADER_SPACE + slots * slotSize;
+    int fd = shm_open(ring->name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        ring->producer = false; // Don't remove somebody else's ring
+        throw std::runtime_error("Could not create frame ring " + ring->name + ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not size frame ring " + ring->name + ": " + std::strerror(errno));
+    }
+    ring->map(fd, size);
+
+    Header *head = new(ring->header) Header();
+    head->version = VERSION;
+    head->format = YUV444P;
+    head->width = width;
+    head->height = height;
+    head->frameCount = frameCount;
+    head->slots = slots;
+    head->slotSize = slotSize;
+    head->avgFramerate = avgFramerate;
+    head->head.store(0);
+    head->tail.store(0);
+    head->closed.store(0);
+    /* A consumer only trusts the header once it sees the magic */
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(head->magic, MAGIC, sizeof(MAGIC));
+    return ring;
+}
+
+std::shared_ptr<FrameRing> FrameRing::attach(const std::string &name) {
+    std::shared_ptr<FrameRing> ring(new FrameRing(name, false));
+    ring->self = ring;
+
+    int fd = shm_open(ring->name.c_str(), O_RDWR, 0);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) < 0 || static_cast<std::size_t>(info.st_size) < HEADER_SPACE) {
+        if (fd >= 0)
+            ::close(fd);
+        throw std::runtime_error("Could not open frame ring " + ring->name);
+    }
+    ring->map(fd, static_cast<std::size_t>(info.st_size));
+
+    const Header &head = *ring->header;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (std::memcmp(head.magic, MAGIC, sizeof(MAGIC)) != 0 || head.version != VERSION) {
+        throw std::runtime_error("Not a frame ring: " + ring->name);
+    }
+    if (head.format != YUV444P) {
+        throw std::runtime_error("Unsupported pixel format of frame ring " + ring->name);
+    }
+    if (HEADER_SPACE + head.slots * head.slotSize > ring->mappingSize) {
+        throw std::runtime_error("Frame ring " + ring->name + " is truncated");
+    }
+    if (head.tail.load() != 0) {
+        throw std::runtime_error("Frame ring " + ring->name + " has been read already");
+    }
+    ring->released.assign(head.slots, 0);
+    return ring;
+}
+
+std::uint8_t *FrameRing::slot(std::uint64_t frame) const {
+    return slotData + (frame % header->slots) * header->slotSize;
+}
+
+void FrameRing::write(const std::uint8_t *const planes[3], const int strides[3]) {
+    std::uint64_t frame = header->head.load(std::memory_order_relaxed);
+    unsigned spins = 0;
+    while (frame - header->tail.load(std::memory_order_acquire) >= header->slots) {
+        pause(spins);
+    }
+
+    std::size_t planeSize = static_cast<std::size_t>(header->width) * header->height;
+    for (int p = 0; p < 3; p++) {
+        std::uint8_t *plane = slot(frame) + p * planeSize;
+        for (int y = 0; y < header->height; y++) {
+            std::memcpy(plane + y * header->width, planes[p] + y * strides[p], header->width);
+        }
+    }
+    header->head.store(frame + 1, std::memory_order_release);
+}
+
+void FrameRing::close() {
+    header->closed.store(1, std::memory_order_release);
+}
+
+VideoInfo FrameRing::getVideoInfo() {
+    VideoInfo info;
+    info.width = header->width;
+    info.height = header->height;
+    info.frame_count = header->frameCount;
+    info.avg_framerate = header->avgFramerate;
+    info.duration = header->avgFramerate > 0 ? header->frameCount / header->avgFramerate : 0;
+    info.filename = "shm:" + name;
+    return info;
+}
+
+std::shared_ptr<Frame> FrameRing::nextFrame() {
+    if (next >= static_cast<std::uint64_t>(header->frameCount))
+        return nullptr;
+
+    unsigned spins = 0;
+    while (header->head.load(std::memory_order_acquire) <= next) {
+        if (header->closed.load(std::memory_order_acquire) && header->head.load(std::memory_order_acquire) <= next) {
+            logger(WARN) << "Frame ring " << name << " was closed after " << next << " of " << header->frameCount
+                         << " frames";
+            return nullptr;
+        }
+        pause(spins);
+    }
+
+    /* The planes stay in the slot, which is handed back to the producer when the last view is gone */
+    std::uint64_t frame = next++;
+    std::size_t planeSize = static_cast<std::size_t>(header->width) * header->height;
+    std::uint8_t *data = slot(frame);
+    std::shared_ptr<FrameRing> ring = self.lock();
+    return std::shared_ptr<Frame>(new Frame(cv::Mat(header->height, header->width, CV_8UC1, data),
+                                            cv::Mat(header->height, header->width, CV_8UC1, data + planeSize),
+                                            cv::Mat(header->height, header->width, CV_8UC1, data + 2 * planeSize)),
+                                  [ring, frame](Frame *f) {
+                                      delete f;
+                                      ring->release(frame);
+                                  });
+}
+
+void FrameRing::release(std::uint64_t frame) {
+    /* Frames are released in whatever order the analysis finishes them, tail only passes released ones */
+    std::lock_guard<std::mutex> g(releaseMutex);
+    released[frame % header->slots] = 1;
+    std::uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    while (released[tail % header->slots]) {
+        released[tail % header->slots] = 0;
+        tail++;
+    }
+    header->tail.store(tail, std::memory_order_release);
+}
+
+void FrameRing::rewind() {
+    if (next > 0) {
+        throw std::runtime_error("Frame ring " + name + " can only be read once, the algorithm needs a single pass");
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FrameRing_h
+#define FrameRing_h
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <io/Frame.h>
+#include <io/Logger.h>
+#include <io/VideoSequence.h>
+
+
+/*
+ * Frames handed over by another process through a POSIX shared memory ring, e.g. the reconstructed
+ * frames of an encoder. The producer writes 8 bit YUV 4:4:4 frames into a fixed number of slots and
+ * advances head; openvq wraps the slots as Frame planes in place and advances tail once the analysis
+ * has released them. A producer finding all slots in use waits, as does a consumer finding none written.
+ *
+ * Sequences named "shm:/name" are read from the ring /name by VideoSequence. A ring is read once, so
+ * only algorithms with a single pass over the sequence can use it. As with decoded frames, views of a
+ * frame (FullReferenceAlgorithm::view()) must not outlive it.
+ */
+class FrameRing : public FrameSource {
+public:
+    enum PixelFormat {
+        YUV444P = 0
+    };
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t format;
+        std::int32_t width;
+        std::int32_t height;
+        std::int32_t frameCount;
+        std::uint32_t slots;
+        std::uint64_t slotSize;
+        float avgFramerate;
+        /* Frames written by the producer and released by the consumer, the slot of frame i is i % slots */
+        alignas(64) std::atomic<std::uint64_t> head;
+        alignas(64) std::atomic<std::uint64_t> tail;
+        std::atomic<std::uint32_t> closed;
+    };
+
+    /* Producer side, the ring is removed again when the producer is destroyed */
+    static std::shared_ptr<FrameRing> create(const std::string &name, int width, int height, int frameCount,
+                                             unsigned slots, float avgFramerate);
+
+    /* Consumer side of a ring created by another process */
+    static std::shared_ptr<FrameRing> attach(const std::string &name);
+
+    ~FrameRing();
+
+    /* Copies the next frame into the ring, waiting for a free slot */
+    void write(const std::uint8_t *const planes[3], const int strides[3]);
+
+    /* No more frames follow, the consumer sees the end of the sequence once it has read the written ones */
+    void close();
+
+    VideoInfo getVideoInfo() override;
+
+    std::shared_ptr<Frame> nextFrame() override;
+
+    /* Only possible before the first frame has been read */
+    void rewind() override;
+
+private:
+    std::string name;
+    bool producer;
+    Header *header;
+    std::uint8_t *slotData;
+    std::size_t mappingSize;
+    MemoryAccounting::Allocation mappedBytes;
+    std::uint64_t next;
+    std::mutex releaseMutex;
+    std::vector<char> released;
+    std::weak_ptr<FrameRing> self;
+
+    static Logger logger;
+
+    FrameRing(const std::string &name, bool producer);
+
+    void map(int fd, std::size_t size);
+
+    std::uint8_t *slot(std::uint64_t frame) const;
+
+    void release(std::uint64_t frame);
+};
+
+#endif //FrameRing_h
@@ -0,0 +1,35 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Json_h
+#define Json_h
+
+#include <string>
+
+
+/* Formatting of JSON values, for the line-oriented JSON openvq writes */
+class Json {
+public:
+    /* Quoted and escaped */
+    static std::string string(const std::string &s);
+
+    /* null for NaN and infinities, which JSON can't represent */
+    static std::string number(double v);
+};
+
+#endif //Json_h
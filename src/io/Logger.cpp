@@ -17,7 +17,197 @@
  */
 
 #include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+namespace {
+    const char *levelToString[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+
+    struct Record {
+        std::uint64_t sequence;
+        std::time_t time;
+        LogLevel level;
+        std::string msg;
+    };
+
+    /* Records of one thread. Only that thread appends, only drain() takes them out */
+    struct Ring {
+        static const unsigned SIZE = 1024;
+
+        Record records[SIZE];
+        std::atomic<std::uint64_t> head{0};
+        std::atomic<std::uint64_t> tail{0};
+        std::atomic<bool> closed{false};
+    };
+
+    /* Marks the ring of a thread that has ended, it is dropped once empty */
+    struct RingHandle {
+        std::shared_ptr<Ring> ring;
+
+        ~RingHandle() {
+            if (ring)
+                ring->closed = true;
+        }
+    };
+
+    std::atomic<std::uint64_t> nextSequence(0);
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<Ring> > registry;
+    thread_local RingHandle threadRing;
+
+    const std::chrono::milliseconds WRITER_PERIOD(10);
+    const std::chrono::milliseconds PROGRESS_PERIOD(100);
+
+    std::atomic<bool> inProgress(false);
+    std::atomic<int> progressValue(0);
+    std::atomic<int> progressLength(1);
+
+    // Held while records are taken out of the rings and written, guards the state below
+    std::mutex drainMutex;
+    std::vector<Record> held;
+    bool barShown = false;
+    int drawnProgress = -1;
+    std::chrono::steady_clock::time_point lastDraw;
+
+    std::once_flag writerStarted;
+    std::atomic<bool> writerRunning(false);
+    std::atomic<bool> stopWriter(false);
+    std::thread *writer = nullptr;
+    // Wakes the writer early when a ring fills up
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+
+    void drawBar(std::ostringstream &out, int progress, int length) {
+        static const int totalBarLength = 72;
+        length = std::max(length, 1);
+        int percent = static_cast<int>(std::round((double) progress * 100.0 / (double) length));
+        int barLength = (progress * totalBarLength) / length;
+
+        out << "\r[";
+        for (int i = 0; i < barLength; i++)
+            out << "=";
+        out << ">";
+        for (int i = barLength; i < totalBarLength - 1; i++) {
+            out << " ";
+        }
+        out << "] " << percent << "%";
+    }
+
+    void writeRecords(std::ostringstream &out, const std::vector<Record> &records) {
+        for (const Record &record : records) {
+            char timestamp[20];
+            struct tm local;
+            localtime_r(&record.time, &local);
+            strftime(timestamp, sizeof(timestamp), "%X", &local);
+            out << timestamp << " [" << levelToString[record.level] << "] " << record.msg << std::endl;
+        }
+    }
+
+    /* Takes the records out of all rings and writes them, or holds them back while the bar is shown */
+    void drain() {
+        std::lock_guard<std::mutex> d(drainMutex);
+        std::vector<Record> records;
+        {
+            std::lock_guard<std::mutex> g(registryMutex);
+            for (auto it = registry.begin(); it != registry.end();) {
+                Ring &ring = **it;
+                bool closed = ring.closed.load(std::memory_order_acquire);
+                std::uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+                std::uint64_t head = ring.head.load(std::memory_order_acquire);
+                for (; tail != head; tail++) {
+                    records.push_back(std::move(ring.records[tail % Ring::SIZE]));
+                }
+                ring.tail.store(tail, std::memory_order_release);
+                it = closed ? registry.erase(it) : it + 1;
+            }
+        }
+        std::sort(records.begin(), records.end(), [](const Record &a, const Record &b) {
+            return a.sequence < b.sequence;
+        });
+
+        std::ostringstream out;
+        if (inProgress.load(std::memory_order_acquire)) {
+            std::move(records.begin(), records.end(), std::back_inserter(held));
+            int progress = progressValue.load(std::memory_order_relaxed);
+            auto now = std::chrono::steady_clock::now();
+            if (!barShown || (progress != drawnProgress && now - lastDraw >= PROGRESS_PERIOD)) {
+                drawBar(out, progress, progressLength.load(std::memory_order_relaxed));
+                barShown = true;
+                drawnProgress = progress;
+                lastDraw = now;
+            }
+        } else {
+            if (barShown) {
+                drawBar(out, progressValue.load(std::memory_order_relaxed),
+                        progressLength.load(std::memory_order_relaxed));
+                out << std::endl;
+                barShown = false;
+            }
+            writeRecords(out, held);
+            held.clear();
+            writeRecords(out, records);
+        }
+
+        std::string text = out.str();
+        if (!text.empty()) {
+            std::cout << text << std::flush;
+        }
+    }
+
+    void stopWriting() {
+        stopWriter = true;
+        writer->join();
+        writerRunning = false;
+        drain();
+    }
+
+    void startWriting() {
+        writerRunning = true;
+        writer = new std::thread([]() {
+            while (!stopWriter.load(std::memory_order_relaxed)) {
+                drain();
+                std::unique_lock<std::mutex> l(wakeMutex);
+                wake.wait_for(l, WRITER_PERIOD);
+            }
+        });
+        // Runs on exit(), before the state above is destroyed
+        std::atexit(stopWriting);
+    }
+
+    void push(Record &&record) {
+        if (!threadRing.ring) {
+            threadRing.ring = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> g(registryMutex);
+            registry.push_back(threadRing.ring);
+        }
+        Ring &ring = *threadRing.ring;
+        std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+        std::uint64_t used;
+        while ((used = head - ring.tail.load(std::memory_order_acquire)) >= Ring::SIZE) {
+            if (writerRunning) {
+                wake.notify_one();
+                std::this_thread::yield();
+            } else {
+                drain();
+            }
+        }
+        ring.records[head % Ring::SIZE] = std::move(record);
+        ring.head.store(head + 1, std::memory_order_release);
+        if (used == Ring::SIZE / 2) {
+            wake.notify_one();
+        }
+    }
+}
 
 
 LogStream::LogStream(Logger &logger, LogLevel logLevel) : logger(logger), logLevel(logLevel) {
@@ -39,11 +229,7 @@ LogStream Logger::operator()(LogLevel level) {
 }
 
 LogLevel Logger::threshold = TRACE;
-std::mutex Logger::outmutex;
-std::mutex Logger::queuemutex;
-std::mutex Logger::progmutex;
-std::ostringstream Logger::queue;
-bool Logger::inProgress = false;
+thread_local std::function<void(int, int)> Logger::progressListener;
 
 void Logger::setThreshold(std::string &level) {
     if (level == "trace")
@@ -60,91 +246,73 @@ void Logger::setThreshold(std::string &level) {
         throw std::runtime_error("Invalid log level \"" + level + "\"");
 }
 
+void Logger::setThreshold(LogLevel level) {
+    Logger::threshold = level;
+}
+
+LogLevel Logger::getThreshold() {
+    return Logger::threshold;
+}
+
 void Logger::log(LogLevel logLevel, std::string msg) {
     if (logLevel < threshold)
         return;
 
-    const static char *levelToString[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
-    time_t now = time(NULL);
-    char timestamp[20];
-    strftime(timestamp, sizeof(timestamp), "%X", localtime(&now));
-
-    {
-        std::lock_guard<std::mutex> g(queuemutex);
-        queue << timestamp << " ";
-        queue << "[" << levelToString[logLevel] << "] ";
+    std::call_once(writerStarted, startWriting);
 #ifdef OPENVQ_DEBUG
-        queue << className << ": ";
+    msg = className + ": " + msg;
 #endif
-        queue << msg << std::endl;
+    push({nextSequence.fetch_add(1, std::memory_order_relaxed), time(NULL), logLevel, std::move(msg)});
+    if (logLevel >= WARN || !writerRunning) {
+        drain();
     }
-    flush();
+}
+
+void Logger::setProgressListener(std::function<void(int, int)> listener) {
+    progressListener = listener;
 }
 
 bool Logger::initProgress() {
-    std::lock_guard<std::mutex> q(progmutex);
-    if (inProgress) {
+    if (progressListener) {
+        return false;
+    }
+    // Records logged before the pass are written before the bar
+    drain();
+    bool shown = false;
+    if (!inProgress.compare_exchange_strong(shown, true)) {
         return false;
     }
-    return (inProgress = true);
+    progressValue = 0;
+    progressLength = 1;
+    return true;
 }
 
 bool Logger::resetProgress() {
-    {
-        std::lock_guard<std::mutex> g(progmutex);
-        if (!inProgress) {
-            return false;
-        }
-        inProgress = false;
+    if (progressListener) {
+        return false;
     }
-    {
-        std::lock_guard<std::mutex> g(outmutex);
-        std::cout << std::endl;
+    bool shown = true;
+    if (!inProgress.compare_exchange_strong(shown, false)) {
+        return false;
     }
-    flush();
+    drain();
     return true;
 }
 
 /*progress is the current progress while length is the total final length*/
 void Logger::logProgress(int progress, int length)
 {
-    std::lock_guard<std::mutex> pg(progmutex);
-    if (!inProgress) {
+    if (progressListener) {
+        progressListener(progress, length);
         return;
     }
-    std::lock_guard<std::mutex> og(outmutex);
-    int percent = static_cast<int>(std::round((double)progress * 100.0/ (double)length));
-    std::cout << "\r";
-
-    static const int totalBarLength = 72;
-    int barLength = (progress * totalBarLength) / length;
-
-    std::cout << "[";
-    for (int i = 0; i < barLength; i++)
-        std::cout << "=";
-    std::cout << ">";
-    for (int i = barLength; i < totalBarLength-1; i++){
-        std::cout << " ";
+    if (!inProgress.load(std::memory_order_relaxed)) {
+        return;
     }
-    std::cout << "] " << percent << "%";
+    progressLength.store(length, std::memory_order_relaxed);
+    progressValue.store(progress, std::memory_order_relaxed);
 }
 
 void Logger::flush() {
-    {
-        std::lock_guard<std::mutex> g(progmutex);
-        if (inProgress) {
-            return;
-        }
-    }
-    std::string q;
-    {
-        std::lock_guard<std::mutex> g(queuemutex);
-        q = queue.str();
-        queue.clear();
-        queue.str("");
-    }
-    {
-        std::lock_guard<std::mutex> g(outmutex);
-        std::cout << q;
-    }
+    drain();
 }
@@ -48,15 +48,16 @@ public:
 };
 
 
+/*
+ * Records are appended to a lock-free ring of the logging thread and written to stdout by a background
+ * thread, so logging doesn't stall decoding or dispatch. Records of different threads come out in the
+ * order they were logged in. Warnings and errors are written before log() returns.
+ */
 class Logger {
     std::string className;
-    static std::ostringstream queue;
 
     static LogLevel threshold;
-    static std::mutex outmutex;
-    static std::mutex queuemutex;
-    static std::mutex progmutex;
-    static bool inProgress;
+    static thread_local std::function<void(int, int)> progressListener;
 
 public:
     Logger(std::string className);
@@ -67,10 +68,20 @@ public:
 
     static void setThreshold(std::string &level);
 
+    static void setThreshold(LogLevel level);
+
+    static LogLevel getThreshold();
+
+    /* The progress bar is redrawn by the background thread at most 10 times a second, records logged
+     * while it is shown are held back until resetProgress() */
     static bool initProgress();
     static bool resetProgress();
     static void logProgress(int progress, int length);
 
+    /* Progress of passes driven by the calling thread goes to listener instead of the progress bar */
+    static void setProgressListener(std::function<void(int, int)> listener);
+
+    /* Writes out everything logged so far, unless the progress bar is shown */
     static void flush();
 };
 
@@ -0,0 +1,159 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+#include <sys/resource.h>
+
+#include "MemoryAccounting.h"
+
+
+namespace {
+    std::atomic<std::size_t> liveBytes[MemoryAccounting::NUM_CATEGORIES];
+    std::atomic<std::size_t> peakBytes[MemoryAccounting::NUM_CATEGORIES];
+    std::atomic<std::size_t> liveTotal(0);
+    std::atomic<std::size_t> peakOfTotal(0);
+
+    void raise(std::atomic<std::size_t> &peak, std::size_t value) {
+        std::size_t current = peak.load(std::memory_order_relaxed);
+        while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+MemoryAccounting::Allocation::Allocation(Category category, std::size_t bytes)
+        : category(category), bytes(bytes) {
+    add(category, bytes);
+}
+
+MemoryAccounting::Allocation::~Allocation() {
+    release(category, bytes);
+}
+
+void MemoryAccounting::Allocation::resize(std::size_t bytes) {
+    if (bytes > this->bytes) {
+        add(category, bytes - this->bytes);
+    } else {
+        release(category, this->bytes - bytes);
+    }
+    this->bytes = bytes;
+}
+
+const char *MemoryAccounting::name(Category category) {
+    switch (category) {
+        case FRAMES:
+            return "frames";
+        case SCRATCH:
+            return "analysis scratch";
+        case PER_FRAME:
+            return "per-frame data";
+        case CACHE:
+            return "caches";
+        default:
+            return "";
+    }
+}
+
+void MemoryAccounting::add(Category category, std::size_t bytes) {
+    if (bytes == 0)
+        return;
+    raise(peakBytes[category], liveBytes[category].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    raise(peakOfTotal, liveTotal.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void MemoryAccounting::release(Category category, std::size_t bytes) {
+    liveBytes[category].fetch_sub(bytes, std::memory_order_relaxed);
+    liveTotal.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+MemoryAccounting::Bytes MemoryAccounting::live() {
+    Bytes bytes;
+    for (int c = 0; c < NUM_CATEGORIES; c++) {
+        bytes[c] = liveBytes[c].load(std::memory_order_relaxed);
+    }
+    return bytes;
+}
+
+MemoryAccounting::Bytes MemoryAccounting::peak() {
+    Bytes bytes;
+    for (int c = 0; c < NUM_CATEGORIES; c++) {
+        bytes[c] = peakBytes[c].load(std::memory_order_relaxed);
+    }
+    return bytes;
+}
+
+std::size_t MemoryAccounting::peakTotal() {
+    return peakOfTotal.load(std::memory_order_relaxed);
+}
+
+void MemoryAccounting::resetPeak() {
+    for (int c = 0; c < NUM_CATEGORIES; c++) {
+        peakBytes[c].store(liveBytes[c].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    peakOfTotal.store(liveTotal.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+std::size_t MemoryAccounting::peakRss() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+    // Kilobytes on Linux
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+std::string MemoryAccounting::formatBytes(std::size_t bytes) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << bytes / (1024.0 * 1024.0) << " MiB";
+    return out.str();
+}
+
+std::string MemoryAccounting::summary() {
+    Bytes liveNow = live();
+    Bytes peakNow = peak();
+    std::ostringstream out;
+    out << std::left << std::setw(20) << "CATEGORY" << std::right << std::setw(14) << "LIVE" << std::setw(14) << "PEAK"
+        << std::endl;
+    for (int c = 0; c < NUM_CATEGORIES; c++) {
+        out << std::left << std::setw(20) << name(static_cast<Category>(c)) << std::right
+            << std::setw(14) << formatBytes(liveNow[c]) << std::setw(14) << formatBytes(peakNow[c]) << std::endl;
+    }
+    out << std::left << std::setw(20) << "tracked total" << std::right << std::setw(14) << ""
+        << std::setw(14) << formatBytes(peakTotal()) << std::endl;
+    std::size_t rss = peakRss();
+    out << std::left << std::setw(20) << "peak RSS" << std::right << std::setw(14) << ""
+        << std::setw(14) << (rss ? formatBytes(rss) : "n/a");
+    return out.str();
+}
+
+std::string MemoryAccounting::estimate(const Bytes &bytes) {
+    std::ostringstream out;
+    std::size_t total = 0;
+    for (int c = 0; c < NUM_CATEGORIES; c++) {
+        out << std::left << std::setw(20) << name(static_cast<Category>(c)) << std::right
+            << std::setw(14) << formatBytes(bytes[c]) << std::endl;
+        total += bytes[c];
+    }
+    out << std::left << std::setw(20) << "expected peak" << std::right << std::setw(14) << formatBytes(total);
+    return out.str();
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MemoryAccounting_h
+#define MemoryAccounting_h
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+
+/* Live and peak bytes of the large allocations of the process, by category. Counted where frames,
+ * scratch planes and per-frame data are allocated, so the total is a lower bound of what is in use. */
+class MemoryAccounting {
+public:
+    enum Category {
+        FRAMES = 0, // Decoded frame planes and frame ring slots
+        SCRATCH,    // Planes the analysis derives from frames, such as edginess images
+        PER_FRAME,  // Values kept for every frame of a sequence, such as histograms
+        CACHE,      // Mapped feature cache entries
+        NUM_CATEGORIES
+    };
+
+    typedef std::array<std::size_t, NUM_CATEGORIES> Bytes;
+
+    /* Bytes of one category, counted while the object lives */
+    class Allocation {
+    public:
+        Allocation(Category category, std::size_t bytes = 0);
+
+        ~Allocation();
+
+        Allocation(const Allocation &) = delete;
+
+        Allocation &operator=(const Allocation &) = delete;
+
+        void resize(std::size_t bytes);
+
+    private:
+        Category category;
+        std::size_t bytes;
+    };
+
+    static const char *name(Category category);
+
+    static void add(Category category, std::size_t bytes);
+
+    static void release(Category category, std::size_t bytes);
+
+    static Bytes live();
+
+    static Bytes peak();
+
+    /* Peak of the sum over all categories, which may be less than the sum of the peaks */
+    static std::size_t peakTotal();
+
+    /* Starts the peaks over from the bytes live now */
+    static void resetPeak();
+
+    /* Peak resident set size of the process, 0 if unknown */
+    static std::size_t peakRss();
+
+    /* Table of live and peak bytes per category */
+    static std::string summary();
+
+    /* Table of an estimate per category and its total */
+    static std::string estimate(const Bytes &bytes);
+
+    static std::string formatBytes(std::size_t bytes);
+};
+
+#endif //MemoryAccounting_h
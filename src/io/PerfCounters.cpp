@@ -0,0 +1,132 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "PerfCounters.h"
+
+
+namespace {
+    std::atomic<unsigned> availableMask((1u << PerfCounters::NUM_COUNTERS) - 1);
+    std::mutex reasonMutex;
+    std::string reason;
+
+    void unavailable(PerfCounters::Counter counter, const std::string &why) {
+        availableMask.fetch_and(~(1u << counter));
+        std::lock_guard<std::mutex> g(reasonMutex);
+        if (reason.empty()) {
+            reason = std::string(PerfCounters::name(counter)) + ": " + why;
+        }
+    }
+
+    /* Counter group of one thread, read with a single read() */
+    struct ThreadCounters {
+        bool opened = false;
+        int leader = -1;
+        int fds[PerfCounters::NUM_COUNTERS] = {-1, -1, -1};
+        int slot[PerfCounters::NUM_COUNTERS] = {-1, -1, -1};
+        int members = 0;
+
+        ~ThreadCounters() {
+#ifdef __linux__
+            for (int fd : fds) {
+                if (fd >= 0)
+                    close(fd);
+            }
+#endif
+        }
+
+        void open() {
+            opened = true;
+#ifdef __linux__
+            const std::uint64_t configs[PerfCounters::NUM_COUNTERS] = {
+                    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+            for (int c = 0; c < PerfCounters::NUM_COUNTERS; c++) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = configs[c];
+                attr.read_format = PERF_FORMAT_GROUP;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0));
+                if (fd < 0) {
+                    unavailable(static_cast<PerfCounters::Counter>(c), std::strerror(errno));
+                    continue;
+                }
+                if (leader < 0) {
+                    leader = fd;
+                }
+                fds[c] = fd;
+                slot[c] = members++;
+            }
+#else
+            for (int c = 0; c < PerfCounters::NUM_COUNTERS; c++) {
+                unavailable(static_cast<PerfCounters::Counter>(c), "perf_event_open is Linux only");
+            }
+#endif
+        }
+    };
+
+    thread_local ThreadCounters counters;
+}
+
+const char *PerfCounters::name(Counter counter) {
+    static const char *names[NUM_COUNTERS] = {"cycles", "instructions", "LLC misses"};
+    return names[counter];
+}
+
+void PerfCounters::read(Values &values) {
+    values.fill(0);
+    if (!counters.opened) {
+        counters.open();
+    }
+#ifdef __linux__
+    if (counters.leader < 0)
+        return;
+
+    std::uint64_t buffer[1 + NUM_COUNTERS];
+    if (::read(counters.leader, buffer, sizeof(buffer)) < static_cast<ssize_t>(sizeof(std::uint64_t)))
+        return;
+    for (int c = 0; c < NUM_COUNTERS; c++) {
+        if (counters.slot[c] >= 0 && static_cast<std::uint64_t>(counters.slot[c]) < buffer[0]) {
+            values[c] = buffer[1 + counters.slot[c]];
+        }
+    }
+#endif
+}
+
+bool PerfCounters::available(Counter counter) {
+    return availableMask.load() & (1u << counter);
+}
+
+std::string PerfCounters::unavailableReason() {
+    std::lock_guard<std::mutex> g(reasonMutex);
+    return reason;
+}
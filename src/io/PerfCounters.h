@@ -0,0 +1,54 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PerfCounters_h
+#define PerfCounters_h
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+
+/* Hardware counters of the calling thread, from perf_event_open on Linux */
+class PerfCounters {
+public:
+    enum Counter {
+        CYCLES = 0,
+        INSTRUCTIONS,
+        LLC_MISSES,
+        NUM_COUNTERS
+    };
+
+    typedef std::array<std::uint64_t, NUM_COUNTERS> Values;
+
+    /* Bytes moved from memory per last level cache miss, a lower bound of the bandwidth used */
+    static const std::uint64_t LINE_SIZE = 64;
+
+    static const char *name(Counter counter);
+
+    /* Opens the counters of the calling thread on first use. Counters that can't be opened, such as
+     * without permission or inside a VM, read as 0 and available() tells which */
+    static void read(Values &values);
+
+    static bool available(Counter counter);
+
+    /* Why counters are missing, empty if all are there */
+    static std::string unavailableReason();
+};
+
+#endif //PerfCounters_h
@@ -0,0 +1,203 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "SyntheticSequence.h"
+
+
+const char *const SyntheticSequence::distortionNames[] = {
+        "blur", "blockiness", "noise", "colour-shift", "spatial-shift", "dropped-frames"
+};
+
+/* Strength of a distortion named without one, in the order of Distortion::Kind */
+static const double defaultStrengths[] = {1.5, 8, 4, 8, 2, 4};
+
+std::vector<SyntheticSequence::Distortion> SyntheticSequence::parseDistortions(const std::string &spec) {
+    std::vector<Distortion> distortions;
+    std::size_t begin = 0;
+    while (begin <= spec.size()) {
+        std::size_t end = std::min(spec.find('+', begin), spec.size());
+        std::string item = spec.substr(begin, end - begin);
+        begin = end + 1;
+        if (item.empty() || item == "none")
+            continue;
+
+        std::size_t colon = item.find(':');
+        std::string name = item.substr(0, colon);
+        std::size_t kind = 0;
+        while (kind <= Distortion::DROPPED_FRAMES && name != distortionNames[kind]) {
+            kind++;
+        }
+        if (kind > Distortion::DROPPED_FRAMES) {
+            throw std::runtime_error("Unknown distortion \"" + name + "\"");
+        }
+        double strength = defaultStrengths[kind];
+        if (colon != std::string::npos) {
+            try {
+                strength = std::stod(item.substr(colon + 1));
+            } catch (std::exception &) {
+                throw std::runtime_error("Bad strength in \"" + item + "\"");
+            }
+        }
+        if (strength <= 0) {
+            throw std::runtime_error("Strength must be positive in \"" + item + "\"");
+        }
+        distortions.push_back({static_cast<Distortion::Kind>(kind), strength});
+    }
+    return distortions;
+}
+
+/* Values of a triangle wave between 0 and 1 with a period of 1 */
+static double triangle(double u) {
+    return 1 - std::fabs(2 * (u - std::floor(u)) - 1);
+}
+
+SyntheticSequence::SyntheticSequence(int width, int height, unsigned frames, std::uint64_t seed)
+        : width(width), height(height), frames(frames), seed(seed),
+          sceneLength(std::max((frames + 3) / 4, 1u)),
+          canvas(height + static_cast<int>(sceneLength), width + 2 * static_cast<int>(sceneLength), CV_8UC1),
+          still(height, width, CV_8UC1) {
+    if (width <= 0 || height <= 0) {
+        throw std::runtime_error("Synthetic sequences need a positive size");
+    }
+    cv::RNG rng(seed);
+
+    /* Blurred noise has edges at all scales; it is large enough to pan over for a whole scene */
+    for (auto plane : {std::make_pair(&canvas.Y, 100), std::make_pair(&canvas.U, 30), std::make_pair(&canvas.V, 30)}) {
+        rng.fill(*plane.first, cv::RNG::UNIFORM, 128 - plane.second, 128 + plane.second);
+        cv::GaussianBlur(*plane.first, *plane.first, cv::Size(5, 5), 1.5);
+    }
+
+    /* Flat 32 pixel blocks with hard edges between them, over a faint copy of the texture */
+    const int block = 32;
+    for (auto plane : {std::make_pair(&still.Y, &canvas.Y), std::make_pair(&still.U, &canvas.U),
+                       std::make_pair(&still.V, &canvas.V)}) {
+        cv::Mat blocks((height + block - 1) / block, (width + block - 1) / block, CV_8UC1);
+        rng.fill(blocks, cv::RNG::UNIFORM, plane.first == &still.Y ? 16 : 64, plane.first == &still.Y ? 236 : 192);
+        cv::resize(blocks, blocks, cv::Size(blocks.cols * block, blocks.rows * block), 0, 0, cv::INTER_NEAREST);
+        cv::addWeighted(blocks(cv::Rect(0, 0, width, height)), 0.8, (*plane.second)(cv::Rect(0, 0, width, height)),
+                        0.2, 0, *plane.first);
+    }
+}
+
+Frame SyntheticSequence::gradient(unsigned t) const {
+    Frame frame(height, width, CV_8UC1);
+    for (int y = 0; y < height; y++) {
+        std::uint8_t *Y = frame.Y.ptr<std::uint8_t>(y);
+        std::uint8_t *U = frame.U.ptr<std::uint8_t>(y);
+        std::uint8_t *V = frame.V.ptr<std::uint8_t>(y);
+        double v = static_cast<double>(y) / height;
+        for (int x = 0; x < width; x++) {
+            double u = static_cast<double>(x) / width;
+            Y[x] = static_cast<std::uint8_t>(16 + std::lround(219 * triangle(u + 0.5 * v + 0.01 * t)));
+            U[x] = static_cast<std::uint8_t>(68 + std::lround(120 * v));
+            V[x] = static_cast<std::uint8_t>(68 + std::lround(120 * triangle(0.5 * (u + v) - 0.005 * t)));
+        }
+    }
+    return frame;
+}
+
+Frame SyntheticSequence::source(unsigned t) const {
+    unsigned scene = (t / sceneLength) % 4;
+    int local = static_cast<int>(t % sceneLength);
+    int last = static_cast<int>(sceneLength) - 1;
+
+    switch (scene) {
+        case 0: {
+            cv::Rect roi(2 * local, local, width, height);
+            return Frame(canvas.Y(roi), canvas.U(roi), canvas.V(roi));
+        }
+        case 1:
+            return gradient(t % sceneLength);
+        case 2:
+            return still;
+        default: {
+            cv::Rect roi(2 * (last - local), last - local, width, height);
+            Frame frame(height, width, CV_8UC1);
+            cv::flip(canvas.Y(roi), frame.Y, -1);
+            cv::flip(canvas.U(roi), frame.U, -1);
+            cv::flip(canvas.V(roi), frame.V, -1);
+            return frame;
+        }
+    }
+}
+
+Frame SyntheticSequence::processed(unsigned t, const std::vector<Distortion> &distortions) const {
+    unsigned shown = t;
+    for (auto &distortion : distortions) {
+        unsigned period = static_cast<unsigned>(std::max(std::lround(distortion.strength), 2L));
+        if (distortion.kind == Distortion::DROPPED_FRAMES && shown % period == period - 1) {
+            shown--;
+        }
+    }
+    Frame frame = source(shown);
+
+    /* Seeded by the frame number so that the noise doesn't depend on which frames were made before */
+    cv::RNG rng(seed ^ (0x9e3779b97f4a7c15ULL * (t + 1)));
+    for (auto &distortion : distortions) {
+        Frame distorted(height, width, CV_8UC1);
+        for (auto planes : {std::make_pair(&frame.Y, &distorted.Y), std::make_pair(&frame.U, &distorted.U),
+                            std::make_pair(&frame.V, &distorted.V)}) {
+            const cv::Mat &in = *planes.first;
+            cv::Mat &out = *planes.second;
+            bool luma = planes.first == &frame.Y;
+
+            switch (distortion.kind) {
+                case Distortion::BLUR:
+                    cv::GaussianBlur(in, out, cv::Size(0, 0), distortion.strength);
+                    break;
+                case Distortion::BLOCKINESS: {
+                    int block = static_cast<int>(std::max(std::lround(distortion.strength), 2L));
+                    for (int y = 0; y < height; y += block) {
+                        for (int x = 0; x < width; x += block) {
+                            cv::Rect roi(x, y, std::min(block, width - x), std::min(block, height - y));
+                            out(roi).setTo(cv::mean(in(roi)));
+                        }
+                    }
+                    break;
+                }
+                case Distortion::NOISE: {
+                    cv::Mat noisy, noise(height, width, CV_16SC1);
+                    in.convertTo(noisy, CV_16SC1);
+                    rng.fill(noise, cv::RNG::NORMAL, 0, luma ? distortion.strength : distortion.strength / 2);
+                    cv::Mat(noisy + noise).convertTo(out, CV_8UC1);
+                    break;
+                }
+                case Distortion::COLOUR_SHIFT:
+                    in.convertTo(out, CV_8UC1, 1, luma ? 0 : planes.first == &frame.U ? distortion.strength
+                                                                                       : -distortion.strength);
+                    break;
+                case Distortion::SPATIAL_SHIFT: {
+                    int shift = static_cast<int>(std::lround(distortion.strength));
+                    cv::Mat bordered;
+                    cv::copyMakeBorder(in, bordered, shift, 0, shift, 0, cv::BORDER_REPLICATE);
+                    bordered(cv::Rect(0, 0, width, height)).copyTo(out);
+                    break;
+                }
+                case Distortion::DROPPED_FRAMES:
+                    out = in;
+                    break;
+            }
+        }
+        frame = distorted;
+    }
+    return frame;
+}
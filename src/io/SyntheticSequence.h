@@ -0,0 +1,81 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SyntheticSequence_h
+#define SyntheticSequence_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Frame.h"
+
+
+/*
+ * Generated SRC content and PVS distortions of it. Every frame is a function of the seed and its number,
+ * so the same sequence comes out on every run and frames can be produced in any order.
+ */
+class SyntheticSequence {
+public:
+    struct Distortion {
+        enum Kind {
+            BLUR = 0,           // Gaussian blur, strength is sigma
+            BLOCKINESS,         // Blocks replaced by their mean, strength is the block size
+            NOISE,              // Gaussian noise, strength is sigma of luma, chroma gets half
+            COLOUR_SHIFT,       // U raised and V lowered by strength
+            SPATIAL_SHIFT,      // Picture moved right and down by strength pixels
+            DROPPED_FRAMES      // Every strength-th frame repeats the one before
+        };
+
+        Kind kind;
+        double strength;
+    };
+
+    static const char *const distortionNames[];
+
+    /* Distortions of a spec such as "blur" or "blur:0.8+noise:3", applied in that order */
+    static std::vector<Distortion> parseDistortions(const std::string &spec);
+
+    /*
+     * The SRC runs through four scenes with cuts between them: a texture panning diagonally, moving
+     * gradients, a still picture of flat blocks and fine texture, and the texture turned around panning back
+     */
+    SyntheticSequence(int width, int height, unsigned frames, std::uint64_t seed);
+
+    unsigned size() const { return frames; }
+
+    /* Frame t of the SRC. It may share data with the sequence, so it must not be written to */
+    Frame source(unsigned t) const;
+
+    /* Frame t of the PVS with the given distortions */
+    Frame processed(unsigned t, const std::vector<Distortion> &distortions) const;
+
+private:
+    int width;
+    int height;
+    unsigned frames;
+    std::uint64_t seed;
+    unsigned sceneLength;
+
+    Frame canvas;
+    Frame still;
+
+    Frame gradient(unsigned t) const;
+};
+
+#endif //SyntheticSequence_h
@@ -0,0 +1,313 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "Json.h"
+#include "Trace.h"
+
+
+namespace {
+    struct Event {
+        const char *name;
+        std::uint64_t start;
+        std::uint64_t end;
+        long frame;
+    };
+
+    struct StageTotals {
+        std::uint64_t spans = 0;
+        std::uint64_t frames = 0;
+        std::uint64_t ns = 0;
+        PerfCounters::Values counters = {{0, 0, 0}};
+    };
+
+    /* Events are written by its thread only. Chunks never move, so the writer can read the first count
+     * events while the thread goes on appending. The totals are only taken with counters, which cost a
+     * system call per span anyway, or when asked for */
+    struct ThreadBuffer {
+        static const std::size_t CHUNK_EVENTS = 4096;
+        static const std::size_t MAX_CHUNKS = 4096;
+
+        unsigned tid;
+        std::string name;
+        std::atomic<std::size_t> count;
+        std::atomic<std::uint64_t> dropped;
+        std::unique_ptr<Event[]> chunks[MAX_CHUNKS];
+
+        std::mutex totalsMutex;
+        std::map<const char *, StageTotals> stages;
+        bool sampled;
+        PerfCounters::Values first, last;
+        std::uint64_t firstTime, lastTime;
+
+        ThreadBuffer(unsigned tid) : tid(tid), count(0), dropped(0), sampled(false), firstTime(0), lastTime(0) {
+        };
+    };
+
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer> > registry;
+    thread_local ThreadBuffer *local = nullptr;
+    std::chrono::steady_clock::time_point epoch;
+    std::atomic<bool> withEvents(false);
+    std::atomic<bool> withTotals(false);
+    std::atomic<std::uint64_t> framePixels(0);
+
+    ThreadBuffer &localBuffer() {
+        if (!local) {
+            std::lock_guard<std::mutex> g(registryMutex);
+            registry.emplace_back(new ThreadBuffer(static_cast<unsigned>(registry.size() + 1)));
+            local = registry.back().get();
+            local->name = local->tid == 1 ? "main" : "thread " + std::to_string(local->tid);
+        }
+        return *local;
+    }
+}
+
+std::atomic<bool> Trace::active(false);
+std::atomic<bool> Trace::withCounters(false);
+
+void Trace::enable(bool events, bool counters, bool totals) {
+    epoch = std::chrono::steady_clock::now();
+    localBuffer();
+    withEvents.store(events);
+    withCounters.store(counters);
+    withTotals.store(counters || totals);
+    active.store(events || counters || totals);
+}
+
+bool Trace::eventsEnabled() {
+    return withEvents.load(std::memory_order_relaxed);
+}
+
+void Trace::setFramePixels(std::uint64_t pixels) {
+    framePixels.store(pixels);
+}
+
+void TraceSpan::begin() {
+    if (Trace::countersEnabled()) {
+        PerfCounters::read(counters);
+    }
+    start = Trace::now();
+}
+
+void Trace::setThreadName(const std::string &name) {
+    if (!enabled())
+        return;
+    ThreadBuffer &buffer = localBuffer();
+    std::lock_guard<std::mutex> g(registryMutex);
+    buffer.name = name + " " + std::to_string(buffer.tid);
+}
+
+std::map<std::string, std::uint64_t> Trace::stageNanoseconds() {
+    std::map<std::string, std::uint64_t> ns;
+    std::lock_guard<std::mutex> g(registryMutex);
+    for (auto &buffer : registry) {
+        std::lock_guard<std::mutex> t(buffer->totalsMutex);
+        for (auto &stage : buffer->stages) {
+            ns[stage.first] += stage.second.ns;
+        }
+    }
+    return ns;
+}
+
+void Trace::resetTotals() {
+    std::lock_guard<std::mutex> g(registryMutex);
+    for (auto &buffer : registry) {
+        std::lock_guard<std::mutex> t(buffer->totalsMutex);
+        buffer->stages.clear();
+        buffer->sampled = false;
+    }
+}
+
+std::uint64_t Trace::now() {
+    return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+void Trace::record(const char *name, std::uint64_t start, std::uint64_t end, long frame,
+                   const PerfCounters::Values &counters) {
+    ThreadBuffer &buffer = localBuffer();
+    if (withTotals.load(std::memory_order_relaxed)) {
+        PerfCounters::Values now = {{0, 0, 0}};
+        bool sample = countersEnabled();
+        if (sample) {
+            PerfCounters::read(now);
+        }
+        std::lock_guard<std::mutex> g(buffer.totalsMutex);
+        StageTotals &stage = buffer.stages[name];
+        stage.spans++;
+        stage.frames += frame >= 0 ? 1 : 0;
+        stage.ns += end - start;
+        if (sample) {
+            for (int c = 0; c < PerfCounters::NUM_COUNTERS; c++) {
+                stage.counters[c] += now[c] - counters[c];
+            }
+            if (!buffer.sampled) {
+                buffer.sampled = true;
+                buffer.first = counters;
+                buffer.firstTime = start;
+            }
+            buffer.last = now;
+            buffer.lastTime = end;
+        }
+    }
+    if (!withEvents.load(std::memory_order_relaxed))
+        return;
+
+    std::size_t n = buffer.count.load(std::memory_order_relaxed);
+    std::size_t chunk = n / ThreadBuffer::CHUNK_EVENTS;
+    if (chunk >= ThreadBuffer::MAX_CHUNKS) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!buffer.chunks[chunk]) {
+        buffer.chunks[chunk].reset(new Event[ThreadBuffer::CHUNK_EVENTS]);
+    }
+    buffer.chunks[chunk][n % ThreadBuffer::CHUNK_EVENTS] = {name, start, end, frame};
+    buffer.count.store(n + 1, std::memory_order_release);
+}
+
+void Trace::write(const std::string &path) {
+    std::ofstream out(path, std::ofstream::trunc);
+    if (!out) {
+        throw std::runtime_error("Could not write trace " + path);
+    }
+
+    // Microseconds, as the format wants them
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"openvq\"}}";
+
+    std::lock_guard<std::mutex> g(registryMutex);
+    for (auto &buffer : registry) {
+        out << "," << std::endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+            << ", \"args\": {\"name\": " << Json::string(buffer->name) << "}}";
+
+        std::size_t n = buffer->count.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < n; i++) {
+            const Event &e = buffer->chunks[i / ThreadBuffer::CHUNK_EVENTS][i % ThreadBuffer::CHUNK_EVENTS];
+            out << "," << std::endl << "{\"name\": " << Json::string(e.name) << ", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                << buffer->tid << ", \"ts\": " << e.start / 1000.0 << ", \"dur\": " << (e.end - e.start) / 1000.0;
+            if (e.frame >= 0) {
+                out << ", \"args\": {\"frame\": " << e.frame << "}";
+            }
+            out << "}";
+        }
+        if (buffer->dropped.load() > 0) {
+            out << "," << std::endl << "{\"name\": \"dropped spans\", \"ph\": \"C\", \"pid\": 1, \"ts\": 0"
+                << ", \"args\": {" << Json::string(buffer->name) << ": " << buffer->dropped.load() << "}}";
+        }
+    }
+    out << std::endl << "]}" << std::endl;
+    if (!out) {
+        throw std::runtime_error("Could not write trace " + path);
+    }
+}
+
+/* Cycles, IPC and the memory traffic the LLC misses imply for a span of time, and per pixel if perPixel is
+ * set; n/a per pixel without pixels */
+static void counterColumns(std::ostream &out, const PerfCounters::Values &counters, std::uint64_t ns,
+                           bool perPixel, double pixels) {
+    auto column = [&](bool available, double value, int width) {
+        if (available) {
+            out << std::setw(width) << value;
+        } else {
+            out << std::setw(width) << "n/a";
+        }
+    };
+    bool cycles = PerfCounters::available(PerfCounters::CYCLES);
+    bool instructions = PerfCounters::available(PerfCounters::INSTRUCTIONS);
+    bool misses = PerfCounters::available(PerfCounters::LLC_MISSES);
+    double bytes = static_cast<double>(counters[PerfCounters::LLC_MISSES]) * PerfCounters::LINE_SIZE;
+
+    column(cycles, counters[PerfCounters::CYCLES] / 1e6, 12);
+    column(cycles && instructions && counters[PerfCounters::CYCLES] > 0,
+           static_cast<double>(counters[PerfCounters::INSTRUCTIONS]) / counters[PerfCounters::CYCLES], 8);
+    column(misses && ns > 0, bytes / ns, 10);
+    if (perPixel) {
+        column(cycles && pixels > 0, counters[PerfCounters::CYCLES] / pixels, 14);
+        column(misses && pixels > 0, bytes / pixels, 12);
+    }
+}
+
+std::string Trace::summary() {
+    std::map<std::string, StageTotals> stages;
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+
+    std::string reason = PerfCounters::unavailableReason();
+    if (!reason.empty()) {
+        out << "Hardware counters not available (" << reason << "), missing values are n/a" << std::endl;
+    }
+    out << "Memory traffic is estimated as " << PerfCounters::LINE_SIZE << " bytes per LLC miss. "
+        << "Nested stages are included in the stages around them" << std::endl;
+
+    std::lock_guard<std::mutex> g(registryMutex);
+    for (auto &buffer : registry) {
+        std::lock_guard<std::mutex> t(buffer->totalsMutex);
+        for (auto &stage : buffer->stages) {
+            StageTotals &total = stages[stage.first];
+            total.spans += stage.second.spans;
+            total.frames += stage.second.frames;
+            total.ns += stage.second.ns;
+            for (int c = 0; c < PerfCounters::NUM_COUNTERS; c++) {
+                total.counters[c] += stage.second.counters[c];
+            }
+        }
+    }
+
+    out << std::left << std::setw(24) << "STAGE" << std::right << std::setw(10) << "SPANS" << std::setw(12) << "MS"
+        << std::setw(12) << "MCYCLES" << std::setw(8) << "IPC" << std::setw(10) << "GB/S"
+        << std::setw(14) << "CYCLES/PIXEL" << std::setw(12) << "BYTES/PIXEL" << std::endl;
+    for (auto &stage : stages) {
+        const StageTotals &total = stage.second;
+        // Per pixel only for stages that work on single frames
+        double pixels = total.frames == total.spans ? static_cast<double>(total.frames) * framePixels.load() : 0;
+        out << std::left << std::setw(24) << stage.first << std::right << std::setw(10) << total.spans
+            << std::setw(12) << total.ns / 1e6;
+        counterColumns(out, total.counters, total.ns, true, pixels);
+        out << std::endl;
+    }
+
+    out << std::left << std::setw(24) << "THREAD" << std::right << std::setw(10) << "" << std::setw(12) << "MS"
+        << std::setw(12) << "MCYCLES" << std::setw(8) << "IPC" << std::setw(10) << "GB/S" << std::endl;
+    for (auto &buffer : registry) {
+        std::lock_guard<std::mutex> t(buffer->totalsMutex);
+        if (!buffer->sampled)
+            continue;
+        PerfCounters::Values counters;
+        for (int c = 0; c < PerfCounters::NUM_COUNTERS; c++) {
+            counters[c] = buffer->last[c] - buffer->first[c];
+        }
+        std::uint64_t ns = buffer->lastTime - buffer->firstTime;
+        out << std::left << std::setw(24) << buffer->name << std::right << std::setw(10) << ""
+            << std::setw(12) << ns / 1e6;
+        counterColumns(out, counters, ns, false, 0);
+        out << std::endl;
+    }
+    return out.str();
+}
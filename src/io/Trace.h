@@ -0,0 +1,107 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Trace_h
+#define Trace_h
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "PerfCounters.h"
+
+
+/*
+ * Spans of named stages on every thread, written as a Chrome trace that chrome://tracing and
+ * ui.perfetto.dev open, and/or summed up per stage together with hardware counters. Each thread appends
+ * to a buffer of its own without locking. While tracing is off, a span costs one relaxed atomic load.
+ */
+class Trace {
+public:
+    /* Spans started from now on are recorded as events for write(), and with counters for summary().
+     * With totals only the time per stage is summed up, for stageNanoseconds() */
+    static void enable(bool events, bool counters, bool totals = false);
+
+    static bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    };
+
+    /* Name shown for the calling thread */
+    static void setThreadName(const std::string &name);
+
+    /* Pixels of a frame, counters of spans of a single frame are also given per pixel */
+    static void setFramePixels(std::uint64_t pixels);
+
+    /* Writes the spans recorded so far as Chrome trace JSON */
+    static void write(const std::string &path);
+
+    /* Table of time and counters per stage and per thread. Nested spans are included in their parent's */
+    static std::string summary();
+
+    /* Time spent in each stage on all threads together since enable() or resetTotals() */
+    static std::map<std::string, std::uint64_t> stageNanoseconds();
+
+    static void resetTotals();
+
+    /* Nanoseconds since enable() */
+    static std::uint64_t now();
+
+    /* name must outlive the trace, such as a string literal. frame is -1 for spans of no single frame.
+     * counters are those at start, if counters are enabled */
+    static void record(const char *name, std::uint64_t start, std::uint64_t end, long frame,
+                       const PerfCounters::Values &counters);
+
+    static bool countersEnabled() {
+        return withCounters.load(std::memory_order_relaxed);
+    };
+
+    static bool eventsEnabled();
+
+private:
+    static std::atomic<bool> active;
+    static std::atomic<bool> withCounters;
+};
+
+/* Records the time from construction to destruction as a span of stage name */
+class TraceSpan {
+public:
+    TraceSpan(const char *name, long frame = -1)
+            : name(name), frame(frame), recording(Trace::enabled()), start(0) {
+        if (recording) {
+            begin();
+        }
+    };
+
+    ~TraceSpan() {
+        if (recording) {
+            Trace::record(name, start, Trace::now(), frame, counters);
+        }
+    };
+
+private:
+    const char *name;
+    long frame;
+    bool recording;
+    std::uint64_t start;
+    PerfCounters::Values counters;
+
+    void begin();
+};
+
+#endif //Trace_h
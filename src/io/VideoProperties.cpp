@@ -19,16 +19,16 @@
 #include "VideoProperties.h"
 
 const ResolutionInfo VideoProperties::resolutionInfo[] = {
-        {640, 480}, // VGA
-        {768, 480}, // WVGA
-        {1920, 1080}, // FHD
-        {1280, 720}, //HD
-        {960, 540}, // qHD
-        {2560, 1440}, // QHD,
-        {3840, 2160}, //UHD4K
-        {5120, 2160}, //UHD5K
-        {352, 288},  // CIF
-        {176, 144}   // QCIF
+        {640, 480, "vga"}, // VGA
+        {768, 480, "wvga"}, // WVGA
+        {1920, 1080, "1080p"}, // FHD
+        {1280, 720, "720p"}, //HD
+        {960, 540, "qhd"}, // qHD
+        {2560, 1440, "1440p"}, // QHD,
+        {3840, 2160, "4k"}, //UHD4K
+        {5120, 2160, "5k"}, //UHD5K
+        {352, 288, "cif"},  // CIF
+        {176, 144, "qcif"}   // QCIF
 };
 
 ResolutionID VideoProperties::identifyResolution(int width, int height) {
@@ -39,3 +39,20 @@ ResolutionID VideoProperties::identifyResolution(int width, int height) {
     }
     return RES_UNSUPPORTED;
 }
+
+ResolutionID VideoProperties::resolutionByName(const std::string &name) {
+    for (int i = 0; i != RES_UNSUPPORTED; i++) {
+        if (name == VideoProperties::resolutionInfo[i].name) {
+            return static_cast<ResolutionID>(i);
+        }
+    }
+    return RES_UNSUPPORTED;
+}
+
+std::string VideoProperties::resolutionNames() {
+    std::string names;
+    for (int i = 0; i != RES_UNSUPPORTED; i++) {
+        names += (i ? "," : "") + std::string(VideoProperties::resolutionInfo[i].name);
+    }
+    return names;
+}
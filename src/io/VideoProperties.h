@@ -19,6 +19,7 @@
 #ifndef __VIDEOPROPERTIES_H
 #define __VIDEOPROPERTIES_H
 
+#include <string>
 #include <vector>
 
 enum ResolutionID {
@@ -38,6 +39,7 @@ enum ResolutionID {
 struct ResolutionInfo {
     int width;
     int height;
+    const char *name;
 };
 
 class VideoProperties {
@@ -45,6 +47,12 @@ public:
     static const ResolutionInfo resolutionInfo[];
 
     static ResolutionID identifyResolution(int width, int height);
+
+    /* Resolution of a name such as vga or 1080p, RES_UNSUPPORTED if there is none */
+    static ResolutionID resolutionByName(const std::string &name);
+
+    /* Names accepted by resolutionByName(), comma separated */
+    static std::string resolutionNames();
 };
 
 #endif // __VIDEOPROPERTIES_H
\ No newline at end of file
@@ -16,7 +16,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <io/ContentHash.h>
 #include <io/FileWriter.h>
+#include <io/FrameRing.h>
+#include <io/Trace.h>
 #include <sstream>
 #include "config.h"
 #include "VideoSequence.h"
@@ -125,6 +128,49 @@ bool Decoder::getNextFrame(AVPacket *packet, AVFrame *frame, bool *isLastFrame)
     return true;
 }
 
+std::uint64_t Decoder::packetHash(const std::string &url) {
+    AVFormatContext *context = NULL;
+    if (avformat_open_input(&context, url.c_str(), NULL, NULL) < 0) {
+        throw std::runtime_error("Could not open file " + url);
+    }
+    if (avformat_find_stream_info(context, NULL) < 0) {
+        avformat_close_input(&context);
+        throw std::runtime_error("couldn't find stream info for file " + url);
+    }
+
+    int stream = -1;
+    for (unsigned int i = 0; i < context->nb_streams; i++) {
+        if (context->streams[i]->codec->codec_type == AVMEDIA_TYPE_VIDEO) {
+            stream = i;
+            break;
+        }
+    }
+    if (stream == -1) {
+        avformat_close_input(&context);
+        throw std::runtime_error("Didn't find video stream in file " + url);
+    }
+
+    // Packets alone don't identify the video, e.g. H.264 in MP4 keeps its parameter sets in extradata
+    AVCodecContext *codec = context->streams[stream]->codec;
+    ContentHash hash;
+    int parameters[4] = {codec->codec_id, codec->width, codec->height, codec->pix_fmt};
+    hash.update(parameters, sizeof(parameters));
+    if (codec->extradata_size > 0) {
+        hash.update(codec->extradata, codec->extradata_size);
+    }
+
+    AVPacket packet;
+    av_init_packet(&packet);
+    while (!av_read_frame(context, &packet)) {
+        if (packet.stream_index == stream && packet.size > 0) {
+            hash.update(packet.data, packet.size);
+        }
+        av_free_packet(&packet);
+    }
+    avformat_close_input(&context);
+    return hash.digest();
+}
+
 void Decoder::rewindAndFlushDecoder() {
     av_seek_frame(formatContext, videoStream, 0, AVSEEK_FLAG_BACKWARD);
     avcodec_flush_buffers(codecContext);
@@ -142,6 +188,9 @@ VideoSequence::~VideoSequence() {
 }
 
 VideoInfo VideoSequence::init(std::string &url, int maxFrames, AVPixelFormat pixelFormat) {
+    if (url.compare(0, 4, "shm:") == 0) {
+        return init(FrameRing::attach(url.substr(4)), maxFrames);
+    }
     this->maxFrames = maxFrames;
     this->pixelFormat = pixelFormat;
     frameCounter = 0;
@@ -149,14 +198,33 @@ VideoInfo VideoSequence::init(std::string &url, int maxFrames, AVPixelFormat pix
     return decoder.getVideoInfo();
 }
 
+VideoInfo VideoSequence::init(std::shared_ptr<FrameSource> source, int maxFrames) {
+    this->source = source;
+    this->maxFrames = maxFrames;
+    frameCounter = 0;
+    return source->getVideoInfo();
+}
+
 std::shared_ptr<Frame> VideoSequence::nextFrame() {
+    if (source) {
+        TraceSpan span("read", frameCounter);
+        std::shared_ptr<Frame> frame = source->nextFrame();
+        if (frame && ++frameCounter == maxFrames)
+            logger(DEBUG) << "Read max number of frames (" << maxFrames << ")";
+        return frame;
+    }
+
     AVPacket packet;
     AVFrame *frame;
     frame = AVFRAME_ALLOC();
 
     bool isLastFrame = false;
 
-    bool noError = decoder.getNextFrame(&packet, frame, &isLastFrame);
+    bool noError;
+    {
+        TraceSpan span("decode", frameCounter);
+        noError = decoder.getNextFrame(&packet, frame, &isLastFrame);
+    }
 
     if (!noError || isLastFrame) {
         AVFRAME_FREE(&frame);
@@ -166,6 +234,7 @@ std::shared_ptr<Frame> VideoSequence::nextFrame() {
         return NULL;
     }
 
+    TraceSpan span("sws_scale", frameCounter);
     SwsContext *ctxt = sws_getContext(frame->width, frame->height, (AVPixelFormat) frame->format,
                                       frame->width, frame->height, pixelFormat, SWS_X, nullptr, nullptr, nullptr);
 
@@ -188,13 +257,18 @@ std::shared_ptr<Frame> VideoSequence::nextFrame() {
     if (++frameCounter == maxFrames)
         logger(DEBUG) << "Read max number of frames (" << maxFrames << ")";
 
-    return std::make_shared<Frame>(y, u, v);
+    std::shared_ptr<Frame> decoded = std::make_shared<Frame>(y, u, v);
+    decoded->account(MemoryAccounting::FRAMES);
+    return decoded;
 }
 
 void VideoSequence::rewind() {
     if (frameCounter > 0) {
         frameCounter = 0;
-        decoder.rewindAndFlushDecoder();
+        if (source)
+            source->rewind();
+        else
+            decoder.rewindAndFlushDecoder();
     }
 }
 
@@ -19,6 +19,7 @@
 #ifndef VideoSequence_h__
 #define VideoSequence_h__
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <memory>
@@ -52,6 +53,9 @@ public:
 
     void rewindAndFlushDecoder();
 
+    /* Hash of the video stream's codec parameters and packets, computed without decoding */
+    static std::uint64_t packetHash(const std::string &url);
+
 private:
     AVFormatContext *formatContext;
     AVCodecContext *codecContext;
@@ -67,10 +71,28 @@ private:
 };
 
 
+/* Frames that come from somewhere else than a decoder, e.g. a cache of already decoded frames */
+class FrameSource {
+public:
+    virtual ~FrameSource() {
+    };
+
+    virtual VideoInfo getVideoInfo() = 0;
+
+    /* NULL at the end of the sequence */
+    virtual std::shared_ptr<Frame> nextFrame() = 0;
+
+    virtual void rewind() = 0;
+};
+
+
 class VideoSequence {
 public:
     VideoInfo init(std::string &url, int maxFrames, AVPixelFormat pixelFormat);
 
+    /* Reads frames from source instead of decoding them */
+    VideoInfo init(std::shared_ptr<FrameSource> source, int maxFrames);
+
     ~VideoSequence();
 
     std::shared_ptr<Frame> nextFrame();
@@ -79,6 +101,7 @@ public:
 
 private:
     Decoder decoder;
+    std::shared_ptr<FrameSource> source;
     int maxFrames;
     int frameCounter;
     AVPixelFormat pixelFormat;
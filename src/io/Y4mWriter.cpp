@@ -0,0 +1,58 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+
+#include "Y4mWriter.h"
+
+
+Y4mWriter::Y4mWriter(const std::string &path, int width, int height, int framerate, bool chroma420)
+        : path(path), out(path, std::ios::binary | std::ios::trunc), width(width), height(height),
+          chroma420(chroma420) {
+    if (!out) {
+        throw std::runtime_error("Could not write " + path);
+    }
+    out << "YUV4MPEG2 W" << width << " H" << height << " F" << framerate << ":1 Ip A1:1 "
+        << (chroma420 ? "C420jpeg" : "C444") << "\n";
+}
+
+void Y4mWriter::write(const Frame &frame) {
+    if (frame.Y.cols != width || frame.Y.rows != height) {
+        throw std::runtime_error("Frame size doesn't match " + path);
+    }
+    out << "FRAME\n";
+    for (int y = 0; y < height; y++) {
+        out.write(reinterpret_cast<const char *>(frame.Y.ptr<std::uint8_t>(y)), width);
+    }
+    for (const cv::Mat *plane : {&frame.U, &frame.V}) {
+        cv::Mat written = *plane;
+        if (chroma420) {
+            cv::resize(*plane, written, cv::Size((width + 1) / 2, (height + 1) / 2), 0, 0, cv::INTER_AREA);
+        }
+        for (int y = 0; y < written.rows; y++) {
+            out.write(reinterpret_cast<const char *>(written.ptr<std::uint8_t>(y)), written.cols);
+        }
+    }
+}
+
+void Y4mWriter::close() {
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Could not write " + path);
+    }
+}
@@ -0,0 +1,47 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef Y4mWriter_h
+#define Y4mWriter_h
+
+#include <fstream>
+#include <string>
+
+#include "Frame.h"
+
+
+/* Writes 8 bit frames as a YUV4MPEG2 file, which the decoder reads like any other input */
+class Y4mWriter {
+public:
+    /* With chroma420 the chroma planes are averaged over 2x2 pixels, otherwise written 4:4:4 as they are */
+    Y4mWriter(const std::string &path, int width, int height, int framerate, bool chroma420);
+
+    void write(const Frame &frame);
+
+    /* Throws if anything could not be written */
+    void close();
+
+private:
+    std::string path;
+    std::ofstream out;
+    int width;
+    int height;
+    bool chroma420;
+};
+
+#endif //Y4mWriter_h
@@ -19,6 +19,8 @@
 #include <string>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <vector>
 
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/parsers.hpp>
@@ -29,6 +31,8 @@ extern "C" {
 };
 
 #include "io/Logger.h"
+#include "io/MemoryAccounting.h"
+#include "io/Trace.h"
 #include "metrics/Metrics.h"
 
 Logger mainLogger("OpenVQ");
@@ -36,11 +40,31 @@ Logger mainLogger("OpenVQ");
 namespace opts = boost::program_options;
 
 
+/* Index of the command in argv, the first token that is neither a global option nor its value */
+static int commandIndex(int argc, const char *argv[], const opts::options_description &globalOptions) {
+    for (int i = 1; i < argc; i++) {
+        std::string token = argv[i];
+        if (token.size() < 2 || token[0] != '-')
+            return i;
+        std::string name = token.substr(token.find_first_not_of('-'));
+        if (name.find('=') != std::string::npos)
+            continue;
+        const opts::option_description *option = globalOptions.find_nothrow(name, false);
+        if (option && option->semantic()->max_tokens() > 0)
+            i++;
+    }
+    return argc;
+}
+
 int main(int argc, const char *argv[]) {
     opts::options_description globalOptions("Global options");
     globalOptions.add_options()
             ("help,h", "Print help message")
-            ("log-level", opts::value<std::string>(), "Set log level threshold {trace,debug,info,warn,error}");
+            ("log-level", opts::value<std::string>(), "Set log level threshold {trace,debug,info,warn,error}")
+            ("trace", opts::value<std::string>(),
+             "Write the time spent in each stage, per thread and frame, to this file as Chrome trace JSON")
+            ("perf-counters", "Print cycles, instructions and LLC misses per stage and thread at the end")
+            ("estimate-memory", "Print the expected peak memory for the given sequences and options, and exit without running");
 
     opts::options_description fullDesc("All options");
     fullDesc.add(globalOptions);
@@ -98,14 +122,46 @@ int main(int argc, const char *argv[]) {
     /* Initialize Libav */
     av_register_all();
 
+    if (vars.count("trace") || vars.count("perf-counters")) {
+        Trace::enable(vars.count("trace") > 0, vars.count("perf-counters") > 0);
+    }
+
     /* Run selected algorithm */
     try {
-        algorithm->init(argc, argv);
+        /* The command gets its own arguments only, so global options can't be mistaken for them */
+        std::vector<const char *> args(1, argv[0]);
+        args.insert(args.end(), argv + std::min(commandIndex(argc, argv, globalOptions) + 1, argc), argv + argc);
+        algorithm->init(static_cast<int>(args.size()), args.data());
     } catch (std::runtime_error e) {
         mainLogger(ERROR) << e.what();
         exit(1);
     }
+    if (vars.count("estimate-memory")) {
+        if (algorithm->memoryEstimate() == 0) {
+            mainLogger(ERROR) << "No memory estimate for " << vars["command"].as<std::string>();
+            exit(1);
+        }
+        mainLogger(INFO) << "Memory estimate" << std::endl << MemoryAccounting::estimate(algorithm->memoryEstimateByCategory());
+        exit(0);
+    }
     int ret = algorithm->run();
+    algorithm->flushResults();
+
+    if (vars.count("trace")) {
+        try {
+            Trace::write(vars["trace"].as<std::string>());
+        } catch (std::runtime_error &e) {
+            mainLogger(ERROR) << e.what();
+        }
+    }
+    if (vars.count("perf-counters")) {
+        mainLogger(INFO) << "Stages and threads" << std::endl << Trace::summary();
+    }
+
+    mainLogger(DEBUG) << "Memory" << std::endl << MemoryAccounting::summary();
+    std::size_t peakRss = MemoryAccounting::peakRss();
+    mainLogger(INFO) << "Peak memory: " << MemoryAccounting::formatBytes(MemoryAccounting::peakTotal()) << " tracked, "
+            << (peakRss ? MemoryAccounting::formatBytes(peakRss) : "unknown") << " resident";
 
     /* Cleanup */
     exit(ret);
@@ -18,56 +18,57 @@
 
 #include <boost/program_options/variables_map.hpp>
 #include <boost/program_options/parsers.hpp>
+#include <boost/algorithm/string/join.hpp>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <sstream>
-#include <fstream>
-#include <iomanip>
+#include <cmath>
+
+#include <io/ContentHash.h>
+#include <io/Json.h>
+#include <io/Trace.h>
+#include <metrics/common/pooling/SlidingWindow.h>
+#include <metrics/common/results/ResultStore.h>
+#include <metrics/common/results/SqliteSink.h>
 
 #include "Algorithm.h"
 
 
 Algorithm::Algorithm(std::string algorithmName)
-        : logger(algorithmName),
+        : name(algorithmName),
+          logger(algorithmName),
           options("Allowed options for algorithm " + algorithmName) {
     options.add_options()
             ("max-frames,t", opts::value<int>(&maxFrames), "Set frame limit")
             ("help,h", "Print help message")
             ("csv", opts::value<std::string>(&csvDbURL),
-             "Path to csv file to which the indicators will be added as a new line");
+             "Path to csv file to which the indicators will be added as a new line")
+            ("json", opts::value<std::string>(&jsonURL),
+             "Path to file to which the named results will be appended as a JSON object on its own line")
+            ("sqlite", opts::value<std::string>(&sqliteURL),
+             "Path to SQLite database to which the results and per-frame values will be added")
+            ("result-cache", opts::value<std::string>(&resultCacheDir),
+             "Directory of stored results. Inputs already scored with the same options are not analysed again");
+    neutralOptions = {"help", "csv", "json", "sqlite", "result-cache"};
 }
 
-void Algorithm::writeCSV(const std::string &identifier, const std::vector<double> &values) {
-    if (csvDbURL.empty())
-        return;
-
-    std::ofstream db(csvDbURL, std::ofstream::app);
-    if (!db) {
-        logger(ERROR) << "Could not write to database file: " << csvDbURL;
-    }
-    db << std::setprecision(std::numeric_limits<double>::digits10 + 1);
-    db << identifier;
-    for (unsigned i = 0; i < values.size(); i++) {
-        db << "," << values[i];
+Algorithm::~Algorithm() {
+    try {
+        flushResults();
+    } catch (std::exception &e) {
+        logger(ERROR) << e.what();
     }
-    db << std::endl;
-    db.close();
-    logger(DEBUG) << "Wrote values to database " << csvDbURL;
-}
-
-FullReferenceAlgorithm::FullReferenceAlgorithm(std::string algorithmName)
-        : Algorithm(algorithmName) {
-    options.add_options()
-            ("src,s", opts::value<std::string>(&srcURL)->required(), "Path to source video sequence (required)")
-            ("pvs,p", opts::value<std::string>(&pvsURL)->required(), "Path to processed video sequence (required)");
 }
 
-void FullReferenceAlgorithm::init(int argc, const char **argv) {
+void Algorithm::parseOptions(int argc, const char **argv) {
     opts::variables_map vm;
-    opts::parsed_options parsed = opts::command_line_parser(argc, argv).
-            options(options).
-            allow_unregistered().
-            run();
+    opts::command_line_parser parser(argc, argv);
+    parser.options(options).allow_unregistered();
+    if (positional.max_total_count() > 0) {
+        parser.positional(positional);
+    }
+    opts::parsed_options parsed = parser.run();
     opts::store(parsed, vm);
 
     if (vm.count("help")) {
@@ -84,17 +85,352 @@ void FullReferenceAlgorithm::init(int argc, const char **argv) {
         throw std::runtime_error(what.str().c_str());
     }
 
-    VideoInfo srcInfo = src.init(srcURL, maxFrames, pixelFormat);
-    VideoInfo pvsInfo = pvs.init(pvsURL, maxFrames, pixelFormat);
-    validateInput(srcInfo, pvsInfo);
+    std::vector<std::string> settings;
+    for (auto &option : parsed.options) {
+        if (!option.unregistered && !option.string_key.empty() && !neutralOptions.count(option.string_key)) {
+            settings.push_back(option.string_key + "=" + boost::algorithm::join(option.value, ","));
+        }
+    }
+    std::sort(settings.begin(), settings.end());
+    settings.insert(settings.begin(), name);
+    optionsKey = boost::algorithm::join(settings, " ");
+
+    /* Opened up front, so an unwritable output fails before the analysis rather than after it */
+    sinks.clear();
+    if (!csvDbURL.empty())
+        sinks.emplace_back(new CsvSink(csvDbURL));
+    if (!jsonURL.empty())
+        sinks.emplace_back(new JsonSink(jsonURL));
+    if (!sqliteURL.empty()) {
+#ifdef OPENVQ_SQLITE
+        sinks.emplace_back(new SqliteSink(sqliteURL));
+#else
+        throw std::runtime_error("openvq was built without SQLite, --sqlite is not available");
+#endif
+    }
 
-    sequenceLength = srcInfo.frame_count;
+    configure(vm);
 }
 
-void FullReferenceAlgorithm::validateInput(VideoInfo &srcInfo, VideoInfo &pvsInfo) {
+void Algorithm::setResultListener(ResultListener listener) {
+    resultListener = listener;
+}
+
+void Algorithm::flushResults() {
+    for (auto &sink : sinks) {
+        sink->flush();
+    }
+}
+
+std::size_t Algorithm::memoryEstimate() const {
+    std::size_t total = 0;
+    for (std::size_t bytes : memoryEstimateByCategory()) {
+        total += bytes;
+    }
+    return total;
+}
+
+void Algorithm::writeResult(const std::string &identifier, const std::vector<std::string> &names,
+                            const std::vector<double> &values, const std::vector<std::string> &frameNames,
+                            const std::vector<std::vector<double> > &frameValues) {
+    writeRecord({name, identifier, names, values, frameNames, frameValues});
+}
+
+void Algorithm::writeRecord(const ResultRecord &record) {
+    for (auto &sink : sinks) {
+        sink->write(record);
+    }
+    if (resultListener) {
+        resultListener(record);
+    }
+}
+
+FullReferenceAlgorithm::FullReferenceAlgorithm(std::string algorithmName)
+        : Algorithm(algorithmName), multiplePvs(false), srcHash(0), srcHashed(false), windowStepSeconds(0) {
+    options.add_options()
+            ("src,s", opts::value<std::string>(&srcURL)->required(), "Path to source video sequence (required)")
+            ("pvs,p", opts::value<std::vector<std::string> >(&pvsURLs)->required(),
+             "Path to processed video sequence (required)")
+            ("frame-table", opts::value<std::string>(&frameTableURL),
+             "Path to binary file to which the per-frame values are written, with several PVS suffixed .1, .2, ...")
+            ("window", opts::value<std::vector<double> >(&windowSeconds),
+             "Also write the values of every window of this many seconds, may be given several times")
+            ("window-step", opts::value<double>(&windowStepSeconds),
+             "Seconds between the starts of windows, defaults to the window length")
+            ("frame-stats", opts::value<std::string>(&frameStatisticsList),
+             "Pool the per-frame values into these statistics too, e.g. p1,p5,median,hmean");
+    neutralOptions.insert({"src", "pvs", "frame-table", "window", "window-step"});
+}
+
+void FullReferenceAlgorithm::configure(const opts::variables_map &vm) {
+    Algorithm::configure(vm);
+
+    pvsURL = pvsURLs.front();
+    for (double seconds : windowSeconds) {
+        if (!(seconds > 0))
+            throw std::runtime_error("Window length must be positive");
+    }
+    if (windowStepSeconds < 0)
+        throw std::runtime_error("Window step must be positive");
+    frameStatistics = FramePooling::parse(frameStatisticsList);
+
+    frameTablePaths.clear();
+    if (!frameTableURL.empty()) {
+        for (unsigned i = 0; i < pvsURLs.size(); i++) {
+            frameTablePaths[pvsURLs[i]] =
+                    pvsURLs.size() > 1 ? frameTableURL + "." + std::to_string(i + 1) : frameTableURL;
+        }
+    }
+}
+
+void FullReferenceAlgorithm::init(int argc, const char **argv) {
+    parseOptions(argc, argv);
+    openSequences();
+}
+
+void FullReferenceAlgorithm::openSequences() {
+    if (pvsURLs.size() > 1 && !multiplePvs) {
+        throw std::runtime_error("Only one processed video sequence can be given");
+    }
+
+    /* Only the sequence values are stored, windows and frame tables need the pair analysed again */
+    if (!resultCacheDir.empty() && windowSeconds.empty() && frameTablePaths.empty()) {
+        ResultStore store(resultCacheDir);
+        std::vector<std::string> remaining;
+        for (auto &url : pvsURLs) {
+            StoredResult result;
+            result.pvsURL = url;
+            if (store.lookup(resultKey(url), result.names, result.values)) {
+                storedResults.push_back(result);
+            } else {
+                remaining.push_back(url);
+            }
+        }
+        pvsURLs = remaining;
+        if (pvsURLs.empty())
+            return;
+        pvsURL = pvsURLs.front();
+    }
+
+    srcInfo = openSource();
+    pvsInfo = pvs.init(pvsURL, maxFrames, pixelFormat);
     logVideoInfo(srcInfo, "SRC");
     logVideoInfo(pvsInfo, "PVS");
+    validateInput(srcInfo, pvsInfo);
+
+    sequenceLength = srcInfo.frame_count;
+    spatialAlignment = std::make_shared<SpatialAlignment>(sequenceLength);
+    Trace::setFramePixels(static_cast<std::uint64_t>(srcInfo.width) * srcInfo.height);
+}
+
+void FullReferenceAlgorithm::attach(const FullReferenceAlgorithm &driver, unsigned pvsIndex) {
+    srcURL = driver.srcURL;
+    pvsURL = driver.pvsURLs.at(pvsIndex);
+    pvsURLs = {pvsURL};
+    srcInfo = driver.srcInfo;
+    pvsInfo = driver.pvsInfo;
+    validateInput(srcInfo, pvsInfo);
+
+    sequenceLength = driver.sequenceLength;
+    if (pvsIndex == 0) {
+        spatialAlignment = driver.spatialAlignment;
+    } else {
+        spatialAlignment = std::make_shared<SpatialAlignment>(sequenceLength);
+    }
+}
+
+void FullReferenceAlgorithm::attach(VideoInfo info) {
+    srcInfo = info;
+    pvsInfo = info;
+    validateInput(srcInfo, pvsInfo);
+
+    sequenceLength = srcInfo.frame_count;
+    spatialAlignment = std::make_shared<SpatialAlignment>(sequenceLength);
+}
+
+std::uint64_t FullReferenceAlgorithm::resultKey(const std::string &pvs) {
+    auto known = resultKeys.find(pvs);
+    if (known != resultKeys.end())
+        return known->second;
+
+    if (!srcHashed) {
+        srcHash = Decoder::packetHash(srcURL);
+        srcHashed = true;
+    }
+    std::uint64_t pvsHash = Decoder::packetHash(pvs);
+
+    ContentHash key;
+    key.update(optionsKey.data(), optionsKey.size());
+    key.update(&srcHash, sizeof(srcHash));
+    key.update(&pvsHash, sizeof(pvsHash));
+    return resultKeys[pvs] = key.digest();
+}
+
+void FullReferenceAlgorithm::writeStoredResults() {
+    for (auto &result : storedResults) {
+        logger(INFO) << "Stored result for " << result.pvsURL;
+        for (unsigned i = 0; i < result.values.size(); i++) {
+            logger(INFO) << " - " << result.names[i] << ": " << result.values[i];
+        }
+        writeResult(result.pvsURL, result.names, result.values);
+    }
+}
+
+void FullReferenceAlgorithm::storeResult(const std::string &pvs, const std::vector<std::string> &names,
+                                         const std::vector<double> &values) {
+    if (!resultCacheDir.empty()) {
+        ResultStore(resultCacheDir).store(resultKey(pvs), names, values);
+    }
+}
 
+void FullReferenceAlgorithm::writeWindows(const std::string &pvs, const FullReferenceAlgorithm &analysis) {
+    unsigned frames = analysis.length();
+    if (windowSeconds.empty() || frames == 0)
+        return;
+    unsigned termCount = static_cast<unsigned>(analysis.poolingTerms(0).size());
+    if (termCount == 0) {
+        logger(WARN) << "No windowed values for " << pvs;
+        return;
+    }
+    double fps = pvsInfo.avg_framerate;
+    if (!(fps > 0))
+        throw std::runtime_error("Frame rate of " + pvs + " is unknown, windows can't be formed");
+
+    auto terms = [&](unsigned t) { return analysis.poolingTerms(t); };
+    for (double seconds : windowSeconds) {
+        unsigned size = static_cast<unsigned>(std::max(1l, std::lround(seconds * fps)));
+        unsigned step = size;
+        if (windowStepSeconds > 0) {
+            step = static_cast<unsigned>(std::max(1l, std::lround(windowStepSeconds * fps)));
+        }
+
+        /* Windows start every step frames until one reaches the end, so the last may be shorter */
+        SlidingWindow window(termCount);
+        for (unsigned begin = 0; begin < frames; begin += step) {
+            unsigned end = std::min(begin + size, frames);
+            window.moveTo(begin, end, terms);
+            std::ostringstream identifier;
+            identifier << pvs << "#t=" << begin / fps << "," << end / fps;
+            writeResult(identifier.str(), analysis.valueNames(), analysis.windowValues(window.means()));
+            if (end == frames)
+                break;
+        }
+    }
+}
+
+std::unique_ptr<FramePooling> FullReferenceAlgorithm::openFramePooling(const FullReferenceAlgorithm &analysis) const {
+    std::vector<std::string> names = analysis.frameValueNames();
+    if (frameStatistics.empty() || names.empty())
+        return nullptr;
+    return std::unique_ptr<FramePooling>(new FramePooling(names, frameStatistics,
+                                                          std::thread::hardware_concurrency()));
+}
+
+std::unique_ptr<FrameTableWriter> FullReferenceAlgorithm::openFrameTable(const std::string &pvs,
+                                                                         const FullReferenceAlgorithm &analysis) const {
+    auto path = frameTablePaths.find(pvs);
+    std::vector<std::string> columns = analysis.frameRowNames();
+    if (path == frameTablePaths.end() || columns.empty())
+        return nullptr;
+    return std::unique_ptr<FrameTableWriter>(new FrameTableWriter(path->second, name, pvs, columns));
+}
+
+std::vector<double> FullReferenceAlgorithm::frameRow(unsigned t) const {
+    std::vector<double> row = frameValues(t);
+    if (spatialAlignmentCrop() > 0) {
+        cv::Point2i offset;
+        if (spatialAlignment && spatialAlignment->determinedOffset(t, offset)) {
+            row.insert(row.end(), {static_cast<double>(offset.x), static_cast<double>(offset.y)});
+        } else {
+            row.insert(row.end(), 2, std::numeric_limits<double>::quiet_NaN());
+        }
+    }
+    return row;
+}
+
+std::vector<std::string> FullReferenceAlgorithm::frameRowNames() const {
+    std::vector<std::string> names = frameValueNames();
+    if (spatialAlignmentCrop() > 0) {
+        names.insert(names.end(), {"offset_x", "offset_y"});
+    }
+    return names;
+}
+
+MemoryAccounting::Bytes FullReferenceAlgorithm::memoryEstimateByCategory() const {
+    const std::size_t pixels = static_cast<std::size_t>(srcInfo.width) * srcInfo.height;
+    MemoryAccounting::Bytes bytes = MemoryAccounting::Bytes();
+    /* A frame pair in flight holds a decoded SRC and PVS frame, both 4:4:4 at 8 bits */
+    bytes[MemoryAccounting::FRAMES] = framesInFlight() * 2 * 3 * pixels;
+    bytes[MemoryAccounting::SCRATCH] = framesAnalysedAtOnce() * scratchBytesPerPixel() * pixels;
+    bytes[MemoryAccounting::PER_FRAME] = sequenceLength * perFrameBytes();
+    return bytes;
+}
+
+int FullReferenceAlgorithm::run() {
+    writeStoredResults();
+    if (pvsURLs.empty())
+        return 0;
+
+    initAnalysis();
+
+    int passCount = 0;
+    if (hasPreparationPass()) {
+        logger(INFO) << "Pass " << ++passCount;
+        makePass([&](std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr, unsigned tCurr) {
+            TraceSpan span("preparation", tCurr);
+            preparationFrame(view(srcCurr), view(pvsCurr), tCurr);
+        });
+        finishPreparation();
+    }
+
+    std::unique_ptr<FrameTableWriter> frameTable = openFrameTable(pvsURL, *this);
+    std::unique_ptr<FramePooling> framePooling = openFramePooling(*this);
+    logger(INFO) << "Pass " << ++passCount;
+    makePassWithPrev([&](std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                         std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned tCurr) {
+        TraceSpan span("analysis", tCurr);
+        analysisFrame(view(srcCurr), view(pvsCurr), view(srcPrev), view(pvsPrev), tCurr);
+        if (frameTable) {
+            frameTable->add(tCurr, frameRow(tCurr));
+        }
+        if (framePooling) {
+            framePooling->add(frameValues(tCurr));
+        }
+    });
+
+    std::vector<double> values = finishAnalysis();
+    std::vector<std::string> names = valueNames();
+    if (frameTable) {
+        frameTable->close();
+    }
+    if (framePooling) {
+        framePooling->append(names, values);
+    }
+    std::vector<std::vector<double> > frames;
+    if (!frameValueNames().empty()) {
+        for (unsigned t = 0; t < sequenceLength; t++) {
+            frames.push_back(frameValues(t));
+        }
+    }
+    writeResult(pvsURL, names, values, frameValueNames(), frames);
+    writeWindows(pvsURL, *this);
+    storeResult(pvsURL, names, values);
+    return 0;
+}
+
+VideoInfo FullReferenceAlgorithm::openSource() {
+    return src.init(srcURL, maxFrames, pixelFormat);
+}
+
+std::shared_ptr<Frame> FullReferenceAlgorithm::view(const std::shared_ptr<Frame> &frame) {
+    if (!frame)
+        return frame;
+    std::shared_ptr<Frame> view = std::make_shared<Frame>(frame->Y, frame->U, frame->V);
+    view->allocation = frame->allocation;
+    return view;
+}
+
+void FullReferenceAlgorithm::validateInput(VideoInfo &srcInfo, VideoInfo &pvsInfo) {
     srcInfo.frame_count = std::min(srcInfo.frame_count, maxFrames);
     pvsInfo.frame_count = std::min(pvsInfo.frame_count, maxFrames);
 
@@ -163,19 +499,15 @@ ParallelFullReferenceAlgorithm::ParallelFullReferenceAlgorithm(std::string algor
         : FullReferenceAlgorithm(algorithmName) {
     options.add_options()("num_threads,j", opts::value<unsigned>(&jFactor), "Number of threads wanted. "
             "If no value is given, the algorithm tries to determine the number of threads supported by the hardware.");
+    neutralOptions.insert("num_threads");
 }
 
-void ParallelFullReferenceAlgorithm::init(int argc, const char **argv) {
-    FullReferenceAlgorithm::init(argc, argv);
+void ParallelFullReferenceAlgorithm::configure(const opts::variables_map &vm) {
+    FullReferenceAlgorithm::configure(vm);
 
-    opts::variables_map vm;
-    opts::parsed_options parsed = opts::command_line_parser(argc, argv).
-            options(options).
-            allow_unregistered().
-            run();
-    opts::store(parsed, vm);
-
-    if (!vm.count("num_threads")) {
+    if (!vm.count("num_threads") && sharedPool) {
+        jFactor = sharedPool->size();
+    } else if (!vm.count("num_threads")) {
         jFactor = std::thread::hardware_concurrency();
         if (jFactor <= 0) {
             jFactor = 1;
@@ -195,11 +527,7 @@ void ParallelFullReferenceAlgorithm::makePass(IntraFrameFunction body) {
     src.rewind();
     pvs.rewind();
 
-    auto jobQueue = std::make_shared<JobQueue>(jFactor);
-
-    std::vector<std::thread> workers;
-    for (unsigned i = 0; i < jFactor; ++i)
-        workers.push_back(std::thread(worker, jobQueue));
+    PassWorkers workers(jFactor);
 
     std::shared_ptr<Frame> srcCurr, pvsCurr;
     unsigned int t = 0;
@@ -211,15 +539,12 @@ void ParallelFullReferenceAlgorithm::makePass(IntraFrameFunction body) {
             break;
         assert(pvsCurr);
 
-        jobQueue->push(std::make_shared<IntraFrameJob>(body, srcCurr, pvsCurr, t));
+        workers.push(std::make_shared<IntraFrameJob>(body, srcCurr, pvsCurr, t));
 
         t++;
         Logger::logProgress(t, sequenceLength);
     }
-    jobQueue->close();
-    std::for_each(workers.begin(), workers.end(), [](std::thread &worker) {
-        worker.join();
-    });
+    workers.finish();
     Logger::resetProgress();
 }
 
@@ -233,11 +558,7 @@ void ParallelFullReferenceAlgorithm::makePassWithPrev(InterFrameFunction body) {
     src.rewind();
     pvs.rewind();
 
-    auto jobQueue = std::make_shared<JobQueue>(jFactor);
-
-    std::vector<std::thread> workers;
-    for (unsigned i = 0; i < jFactor; ++i)
-        workers.push_back(std::thread(worker, jobQueue));
+    PassWorkers workers(jFactor);
 
     std::shared_ptr<Frame> srcCurr, srcPrev, pvsCurr, pvsPrev;
     unsigned int t = 0;
@@ -249,18 +570,57 @@ void ParallelFullReferenceAlgorithm::makePassWithPrev(InterFrameFunction body) {
             break;
         assert(pvsCurr);
 
-        jobQueue->push(std::make_shared<InterFrameJob>(body, srcCurr, pvsCurr, srcPrev, pvsPrev, t));
+        workers.push(std::make_shared<InterFrameJob>(body, srcCurr, pvsCurr, srcPrev, pvsPrev, t));
 
         srcPrev = srcCurr;
         pvsPrev = pvsCurr;
         t++;
         Logger::logProgress(t, sequenceLength);
     }
+    workers.finish();
+    Logger::resetProgress();
+}
+
+std::shared_ptr<WorkerPool> ParallelFullReferenceAlgorithm::sharedPool;
+
+void ParallelFullReferenceAlgorithm::useSharedPool(std::shared_ptr<WorkerPool> pool) {
+    sharedPool = pool;
+}
+
+ParallelFullReferenceAlgorithm::PassWorkers::PassWorkers(unsigned jFactor) {
+    if (sharedPool) {
+        group.reset(new WorkerPool::Group(*sharedPool, jFactor));
+        return;
+    }
+    jobQueue = std::make_shared<JobQueue>(jFactor);
+    for (unsigned i = 0; i < jFactor; ++i)
+        workers.push_back(std::thread(worker, jobQueue));
+}
+
+ParallelFullReferenceAlgorithm::PassWorkers::~PassWorkers() {
+    /* The group drains itself on destruction without throwing, finish() would rethrow a job's exception */
+    if (!group)
+        finish();
+}
+
+void ParallelFullReferenceAlgorithm::PassWorkers::push(std::shared_ptr<Job> job) {
+    if (group) {
+        group->submit([job]() { job->run(); });
+    } else {
+        jobQueue->push(job);
+    }
+}
+
+void ParallelFullReferenceAlgorithm::PassWorkers::finish() {
+    if (group) {
+        group->wait();
+        return;
+    }
     jobQueue->close();
     std::for_each(workers.begin(), workers.end(), [](std::thread &worker) {
         worker.join();
     });
-    Logger::resetProgress();
+    workers.clear();
 }
 
 #define SCOPED_GUARDED_RETURN_IF(__mutex__, __bool_expr__, __retval__) { std::lock_guard<std::mutex> __g__(__mutex__); if (__bool_expr__) return __retval__; }
@@ -271,7 +631,10 @@ bool ParallelFullReferenceAlgorithm::JobQueue::push(std::shared_ptr<Job> job) {
     SCOPED_GUARDED_RETURN_IF(cm, closed, false);
 
     std::unique_lock<std::mutex> l(qm);
-    cv.wait(l, [&] { return q.size() < cap; });
+    if (q.size() >= cap) {
+        TraceSpan span("queue full");
+        cv.wait(l, [&] { return q.size() < cap; });
+    }
     q.push(job);
     l.unlock();
     cv.notify_all();
@@ -282,6 +645,7 @@ std::shared_ptr<ParallelFullReferenceAlgorithm::Job> ParallelFullReferenceAlgori
     std::unique_lock<std::mutex> l(qm);
     while (q.empty()) {
         SCOPED_GUARDED_RETURN_IF(cm, closed, std::make_shared<StopJob>());
+        TraceSpan span("idle");
         cv.wait(l);
     }
     std::shared_ptr<Job> j = q.front();
@@ -304,6 +668,14 @@ ParallelFullReferenceAlgorithm::IntraFrameJob::IntraFrameJob(
 ) : body(body), srcFrame(srcFrame), pvsFrame(pvsFrame), t(t) {
 }
 
+ParallelFullReferenceAlgorithm::TaskJob::TaskJob(std::function<void()> task) : task(task) {
+}
+
+bool ParallelFullReferenceAlgorithm::TaskJob::run() {
+    task();
+    return true;
+}
+
 bool ParallelFullReferenceAlgorithm::IntraFrameJob::run() {
     body(srcFrame, pvsFrame, t);
     return true;
@@ -321,5 +693,6 @@ bool ParallelFullReferenceAlgorithm::InterFrameJob::run() {
 }
 
 void ParallelFullReferenceAlgorithm::worker(std::shared_ptr<JobQueue> q) {
+    Trace::setThreadName("worker");
     while (q->pop()->run()) { }
 }
\ No newline at end of file
@@ -19,38 +19,94 @@
 #ifndef __OPENVQ_ALGORITHM_H
 #define __OPENVQ_ALGORITHM_H
 
+#include <functional>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
 
 #include <boost/program_options/options_description.hpp>
+#include <boost/program_options/positional_options.hpp>
+#include <boost/program_options/variables_map.hpp>
 #include <io/config.h> // Libav-related imports
+#include <io/MemoryAccounting.h>
 #include <io/VideoSequence.h>
+#include <metrics/common/alignment/SpatialAlignment.h>
+#include <metrics/common/pool/WorkerPool.h>
+#include <metrics/common/pooling/FramePooling.h>
+#include <metrics/common/results/FrameTable.h>
+#include <metrics/common/results/ResultSink.h>
 
 
 namespace opts = boost::program_options;
 
+typedef std::function<void(const ResultRecord &record)> ResultListener;
+
 class Algorithm {
 protected:
     int maxFrames = std::numeric_limits<int>::max();
     AVPixelFormat pixelFormat = AV_PIX_FMT_YUV444P;
+    std::string name;
     Logger logger;
     opts::options_description options;
+    /* Options given without their name, such as the manifest of batch */
+    opts::positional_options_description positional;
     std::string csvDbURL;
+    std::string jsonURL;
+    std::string sqliteURL;
+    std::string resultCacheDir;
+    std::vector<std::unique_ptr<ResultSink> > sinks;
+
+    /* Options that don't change the result values, all others given on the command line are part of optionsKey */
+    std::set<std::string> neutralOptions;
+    std::string optionsKey;
+    ResultListener resultListener;
 
     Algorithm(std::string algorithmName);
 
+    /* Picks up algorithm specific options once the command line has been parsed */
+    virtual void configure(const opts::variables_map &vm) {
+    };
+
 public:
-    virtual ~Algorithm() {
+    virtual ~Algorithm();
+
+    void parseOptions(int argc, const char **argv);
+
+    /* Algorithm name and the options that affect its results, canonically ordered */
+    const std::string &resultOptions() const {
+        return optionsKey;
     };
 
+    /* argv[0] is the program and the rest are the command's own arguments, without the command itself */
     virtual void init(int argc, const char **argv) = 0;
 
     virtual int run() = 0;
 
-    virtual void writeCSV(const std::string &identifier, const std::vector<double> &values);
+    /* Called with every result besides writing it to the result sinks */
+    void setResultListener(ResultListener listener);
+
+    /* Writes out results the sinks still buffer. Also done on destruction, which exit() skips */
+    void flushResults();
+
+    /* Rough upper bound of the memory run() needs per category, in bytes, all 0 if unknown */
+    virtual MemoryAccounting::Bytes memoryEstimateByCategory() const {
+        return MemoryAccounting::Bytes();
+    };
+
+    /* Sum over the categories */
+    std::size_t memoryEstimate() const;
+
+protected:
+    void writeResult(const std::string &identifier, const std::vector<std::string> &names,
+                     const std::vector<double> &values, const std::vector<std::string> &frameNames = {},
+                     const std::vector<std::vector<double> > &frameValues = {});
+
+    /* Same for a record that is complete already, such as one passed on from another algorithm */
+    void writeRecord(const ResultRecord &record);
 };
 
 
@@ -66,24 +122,165 @@ typedef std::function<void(std::shared_ptr<Frame> srcCurr,
 
 class FullReferenceAlgorithm : public Algorithm {
 protected:
+    struct StoredResult {
+        std::string pvsURL;
+        std::vector<std::string> names;
+        std::vector<double> values;
+    };
+
     std::string srcURL;
     std::string pvsURL;
+    std::vector<std::string> pvsURLs;
+    bool multiplePvs;
     VideoSequence src;
     VideoSequence pvs;
+    VideoInfo srcInfo;
+    VideoInfo pvsInfo;
     unsigned int sequenceLength;
+    std::shared_ptr<SpatialAlignment> spatialAlignment;
+    std::vector<StoredResult> storedResults;
+    std::map<std::string, std::uint64_t> resultKeys;
+    std::uint64_t srcHash;
+    bool srcHashed;
+    std::string frameTableURL;
+    std::map<std::string, std::string> frameTablePaths;
+    std::vector<double> windowSeconds;
+    double windowStepSeconds;
+    std::string frameStatisticsList;
+    std::vector<FramePooling::Statistic> frameStatistics;
 
     FullReferenceAlgorithm(std::string algorithmName);
 
+    /* The part of init() after option parsing. With --result-cache, PVS that already have a stored result
+     * are moved from pvsURLs to storedResults; SRC and PVS are only opened if some PVS are left. */
+    void openSequences();
+
+    /* Key of the result for SRC against pvs with the current options, from the packets of both */
+    std::uint64_t resultKey(const std::string &pvs);
+
+    void writeStoredResults();
+
+    void storeResult(const std::string &pvs, const std::vector<std::string> &names, const std::vector<double> &values);
+
+    /* Writes the values of every --window of analysis, each identified as pvs#t=<start>,<end> in seconds */
+    void writeWindows(const std::string &pvs, const FullReferenceAlgorithm &analysis);
+
+    /* Pooling of the frame values of analysis, null without --frame-stats */
+    std::unique_ptr<FramePooling> openFramePooling(const FullReferenceAlgorithm &analysis) const;
+
+    /* Frame table of pvs with the frame rows of analysis, null without --frame-table */
+    std::unique_ptr<FrameTableWriter> openFrameTable(const std::string &pvs,
+                                                     const FullReferenceAlgorithm &analysis) const;
+
+    virtual void configure(const opts::variables_map &vm) override;
+
     virtual void validateInput(VideoInfo &srcInfo, VideoInfo &pvsInfo);
 
+    /* Opens the SRC sequence, decoding srcURL unless overridden */
+    virtual VideoInfo openSource();
+
     virtual void logVideoInfo(VideoInfo &info, std::string sequenceIdentifier);
 
     virtual void makePass(IntraFrameFunction body);
 
     virtual void makePassWithPrev(InterFrameFunction body);
 
+    /* Frame pairs decoded and not yet released during a pass */
+    virtual unsigned framesInFlight() const {
+        return 2;
+    };
+
+    /* Frame pairs analysed at the same time, each with its own scratch planes */
+    virtual unsigned framesAnalysedAtOnce() const {
+        return 1;
+    };
+
 public:
+    /* Private Frame headers sharing the pixel data, so ROI changes made by one analysis don't leak into another */
+    static std::shared_ptr<Frame> view(const std::shared_ptr<Frame> &frame);
+
     virtual void init(int argc, const char **argv) override;
+
+    /* Takes the sequences, offset table and output identifier from an initialized driver instead of
+     * opening SRC and PVS itself. The analysis steps below can then be fed from the driver's passes.
+     * A driver given several PVS hands out one of them; all but the first get their own offset table. */
+    void attach(const FullReferenceAlgorithm &driver, unsigned pvsIndex = 0);
+
+    /* Same for frames that are handed to the analysis steps directly, such as by FrameStream */
+    void attach(VideoInfo info);
+
+    int run() override;
+
+    MemoryAccounting::Bytes memoryEstimateByCategory() const override;
+
+    /* Scratch planes the analysis of one frame pair allocates, per SRC pixel */
+    virtual std::size_t scratchBytesPerPixel() const {
+        return 48;
+    };
+
+    /* Values kept for the whole sequence, per frame */
+    virtual std::size_t perFrameBytes() const {
+        return 64;
+    };
+
+    /* Number of frames analysed, known once the sequences are opened or attached */
+    unsigned int length() const {
+        return sequenceLength;
+    };
+
+    /*
+     * Analysis steps, run() drives them over SRC and PVS: initAnalysis(), an optional preparation pass
+     * over every frame pair followed by finishPreparation(), the analysis pass, and finishAnalysis()
+     * which logs and returns the result values. Frames are private views (see view()) whose pixel data
+     * must not be modified; previous frames are handed over unaligned.
+     */
+    virtual void initAnalysis() = 0;
+
+    virtual bool hasPreparationPass() const {
+        return false;
+    };
+
+    virtual void preparationFrame(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, unsigned t) {
+    };
+
+    virtual void finishPreparation() {
+    };
+
+    virtual void analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                               std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) = 0;
+
+    virtual std::vector<double> finishAnalysis() = 0;
+
+    virtual std::vector<std::string> valueNames() const = 0;
+
+    /* Values of frame t once analysisFrame() is done with it, empty if there are only sequence values */
+    virtual std::vector<double> frameValues(unsigned t) const {
+        return {};
+    };
+
+    virtual std::vector<std::string> frameValueNames() const {
+        return {};
+    };
+
+    /* Per-frame terms whose means over a window windowValues() maps to the values of that window, in the
+     * order of valueNames(). NaN where frame t has no term; empty if the algorithm has no windowed values */
+    virtual std::vector<double> poolingTerms(unsigned t) const {
+        return {};
+    };
+
+    virtual std::vector<double> windowValues(const std::vector<double> &termMeans) const {
+        return {};
+    };
+
+    /* Frame values followed by the spatial offset of frame t, as written to frame tables */
+    std::vector<double> frameRow(unsigned t) const;
+
+    std::vector<std::string> frameRowNames() const;
+
+    /* Crop used when determining spatial offsets, 0 if the algorithm doesn't align */
+    virtual int spatialAlignmentCrop() const {
+        return 0;
+    };
 };
 
 class ParallelFullReferenceAlgorithm : public FullReferenceAlgorithm {
@@ -104,6 +301,15 @@ protected:
         bool run();
     };
 
+    class TaskJob : public Job {
+        std::function<void()> task;
+
+    public:
+        TaskJob(std::function<void()> task);
+
+        bool run();
+    };
+
     class InterFrameJob : public Job {
         InterFrameFunction body;
         std::shared_ptr<Frame> srcCurr, srcPrev, pvsCurr, pvsPrev;
@@ -139,16 +345,46 @@ protected:
 
     static void worker(std::shared_ptr<JobQueue> q);
 
+    /* Runs the jobs of one pass, at most jFactor at a time, on threads of its own or on the shared pool */
+    class PassWorkers {
+        std::shared_ptr<JobQueue> jobQueue;
+        std::vector<std::thread> workers;
+        std::unique_ptr<WorkerPool::Group> group;
+
+    public:
+        PassWorkers(unsigned jFactor);
+
+        ~PassWorkers();
+
+        void push(std::shared_ptr<Job> job);
+
+        /* Returns once all pushed jobs have run, rethrowing the first exception of a job on the shared pool */
+        void finish();
+    };
+
+    static std::shared_ptr<WorkerPool> sharedPool;
+
     unsigned jFactor;
 
     ParallelFullReferenceAlgorithm(std::string algorithmName);
 
+    virtual void configure(const opts::variables_map &vm) override;
+
     void makePass(IntraFrameFunction body) override;
 
     void makePassWithPrev(InterFrameFunction body) override;
 
+    unsigned framesInFlight() const override {
+        return 2 * jFactor + 2;
+    };
+
+    unsigned framesAnalysedAtOnce() const override {
+        return jFactor;
+    };
+
 public:
-    virtual void init(int argc, const char **argv) override;
+    /* Run the passes of all algorithms created from now on on pool instead of starting threads per pass */
+    static void useSharedPool(std::shared_ptr<WorkerPool> pool);
 };
 
 #endif //__OPENVQ_ALGORITHM_H
\ No newline at end of file
@@ -19,15 +19,37 @@
 #include <iomanip>
 #include "Metrics.h"
 #include "opvq/OPVQ.h"
+#include "opvq/OPVQLadder.h"
+#include "opvq/OPVQSignature.h"
+#include "opvq/OPVQReduced.h"
 #include "psnr/PSNR.h"
 #include "ssim/SSIM.h"
+#include "msssim/MSSSIM.h"
+#include "vif/VIF.h"
+#include "multi/MultiMetric.h"
+#include <batch/Batch.h>
+#include <bench/Bench.h>
+#include <equivalence/Equivalence.h>
+#include <generate/Generate.h>
+#include <server/Server.h>
 
 #define NEW_INSTANCE(__alg__) []() -> std::unique_ptr<__alg__> { return std::unique_ptr<__alg__>(new __alg__()); }
 
 std::vector<Metric> Metrics::metrics = {
         {"opvq", "Open Perceptual Video Quality metric", NEW_INSTANCE(OPVQ)},
+        {"opvq-ladder", "OPVQ of several renditions against one SRC", NEW_INSTANCE(OPVQLadder)},
+        {"opvq-signature", "Compact SRC signature for reduced reference OPVQ", NEW_INSTANCE(OPVQSignature)},
+        {"opvq-rr", "Reduced reference OPVQ of a PVS against a SRC signature", NEW_INSTANCE(OPVQReduced)},
         {"psnr", "Peak Signal-to-Noise Ratio", NEW_INSTANCE(PSNR)},
-        {"ssim", "Structural Similarity Index", NEW_INSTANCE(SSIM)}
+        {"ssim", "Structural Similarity Index", NEW_INSTANCE(SSIM)},
+        {"msssim", "Multi-Scale Structural Similarity Index", NEW_INSTANCE(MSSSIM)},
+        {"vif", "Visual Information Fidelity (pixel domain)", NEW_INSTANCE(VIF)},
+        {"multi", "Several full reference metrics from a single decode", NEW_INSTANCE(MultiMetric)},
+        {"batch", "Score the pairs of a manifest on one thread pool", NEW_INSTANCE(Batch)},
+        {"serve", "Run scoring jobs sent over a Unix socket", NEW_INSTANCE(Server)},
+        {"bench", "Throughput and thread scaling of the metrics end to end", NEW_INSTANCE(Bench)},
+        {"generate", "Write synthetic SRC and distorted PVS sequences for testing", NEW_INSTANCE(Generate)},
+        {"equivalence", "Compare the OPVQ kernels with their frozen reference implementations", NEW_INSTANCE(Equivalence)}
 };
 
 std::unique_ptr<Algorithm> Metrics::getAlgorithm(const std::string &command) {
@@ -21,6 +21,7 @@
 
 ColourAlignment::ColourAlignment(unsigned int sequenceLength)
         : logger("ColourAlignment"),
+          histogramBytes(MemoryAccounting::PER_FRAME, sequenceLength * 3 * (256 * sizeof(float) + sizeof(cv::Mat))),
           rawHistY(sequenceLength),
           rawHistU(sequenceLength),
           rawHistV(sequenceLength),
@@ -135,18 +136,26 @@ void ColourAlignment::calculateLumaCorrectionCurve(cv::Mat hsIn, cv::Mat hpIn,
 }
 
 void ColourAlignment::analyzeFrame(std::shared_ptr<const Frame> f, int t) {
-    rawHistY[t] = cv::Mat(256, 1, CV_32FC1, cv::Scalar(0));
-    rawHistU[t] = cv::Mat(256, 1, CV_32FC1, cv::Scalar(0));
-    rawHistV[t] = cv::Mat(256, 1, CV_32FC1, cv::Scalar(0));
+    setFrameHistograms(t, frameHistograms(*f));
+}
+
+void ColourAlignment::setFrameHistograms(int t, const std::array<cv::Mat, 3> &histograms) {
+    rawHistY[t] = histograms[0].clone();
+    rawHistU[t] = histograms[1].clone();
+    rawHistV[t] = histograms[2].clone();
+}
 
+std::array<cv::Mat, 3> ColourAlignment::frameHistograms(const Frame &f) {
     static int sizes[] = {256};
     static int channels[] = {0};
     static float range[] = {0, 256};
     static const float *ranges[] = {range};
 
-    cv::calcHist(&f->Y, 1, channels, cv::Mat(), rawHistY[t], 1, sizes, ranges, true, false);
-    cv::calcHist(&f->U, 1, channels, cv::Mat(), rawHistU[t], 1, sizes, ranges, true, false);
-    cv::calcHist(&f->V, 1, channels, cv::Mat(), rawHistV[t], 1, sizes, ranges, true, false);
+    std::array<cv::Mat, 3> histograms;
+    cv::calcHist(&f.Y, 1, channels, cv::Mat(), histograms[0], 1, sizes, ranges, true, false);
+    cv::calcHist(&f.U, 1, channels, cv::Mat(), histograms[1], 1, sizes, ranges, true, false);
+    cv::calcHist(&f.V, 1, channels, cv::Mat(), histograms[2], 1, sizes, ranges, true, false);
+    return histograms;
 }
 
 void ColourAlignment::calculateChromaCorrectionCurve(cv::Mat hsIn, cv::Mat hpIn,
@@ -276,6 +285,16 @@ void ColourAlignment::applyCorrectionCurve(std::shared_ptr<Frame> f, std::vector
     }
 }
 
+std::shared_ptr<Frame> ColourAlignment::createCorrectedFrame(std::shared_ptr<const Frame> f,
+                                                             const std::vector<cv::Mat> &curve) {
+    std::shared_ptr<Frame> corrected = std::make_shared<Frame>(cv::Mat(), cv::Mat(), cv::Mat());
+    cv::LUT(f->Y, curve[0], corrected->Y);
+    cv::LUT(f->U, curve[1], corrected->U);
+    cv::LUT(f->V, curve[2], corrected->V);
+    corrected->account(MemoryAccounting::SCRATCH);
+    return corrected;
+}
+
 void ColourAlignment::createCumulative(int width, int height) {
     rawHistY[0].copyTo(histY);
     rawHistU[0].copyTo(histU);
@@ -19,6 +19,7 @@
 #ifndef CoarseLuminanceAlignment_h
 #define CoarseLuminanceAlignment_h
 
+#include <array>
 #include <memory>
 #include <vector>
 #include <opencv2/opencv.hpp>
@@ -33,6 +34,12 @@ public:
 
     void analyzeFrame(std::shared_ptr<const Frame> f, int t);
 
+    /* Takes the histograms of frame t from elsewhere instead of analyzing the frame */
+    void setFrameHistograms(int t, const std::array<cv::Mat, 3> &histograms);
+
+    /* Y, U and V histograms of one frame, 256x1 CV_32FC1 each */
+    static std::array<cv::Mat, 3> frameHistograms(const Frame &f);
+
     void createCumulative(int width, int height);
 
     static std::vector<cv::Mat> createCorrectionCurves(ColourAlignment &srcCA, ColourAlignment &pvsCA);
@@ -43,9 +50,12 @@ public:
 
     static void applyCorrectionCurve(std::shared_ptr<Frame> f, std::vector<cv::Mat> &curve);
 
+    static std::shared_ptr<Frame> createCorrectedFrame(std::shared_ptr<const Frame> f, const std::vector<cv::Mat> &curve);
+
 private:
     Logger logger;
 
+    MemoryAccounting::Allocation histogramBytes;
     std::vector<cv::Mat> rawHistY;
     std::vector<cv::Mat> rawHistU;
     std::vector<cv::Mat> rawHistV;
@@ -16,11 +16,37 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cassert>
+
+#include <io/Trace.h>
+
 #include "SpatialAlignment.h"
 
 
 Logger SpatialAlignment::logger = Logger("SpatialAlignment");
 
+SpatialAlignment::SpatialAlignment(unsigned int sequenceLength)
+        : offsets(sequenceLength, cv::Point2i(0, 0)), determined(sequenceLength, 0) {
+}
+
+cv::Point2i SpatialAlignment::frameOffset(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame,
+                                          int crop, unsigned t) {
+    assert(t < offsets.size());
+    if (!determined[t]) {
+        TraceSpan span("spatial offset", t);
+        offsets[t] = spatialOffsetDetermination(srcFrame, pvsFrame, crop);
+        determined[t] = 1;
+    }
+    return offsets[t];
+}
+
+bool SpatialAlignment::determinedOffset(unsigned t, cv::Point2i &offset) const {
+    if (t >= offsets.size() || !determined[t])
+        return false;
+    offset = offsets[t];
+    return true;
+}
+
 cv::Point2i SpatialAlignment::spatialOffsetDetermination(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, int crop) {
     double minimizedError = std::numeric_limits<double>::max();
 
@@ -20,6 +20,7 @@
 #define SpatialAlignment_h
 
 #include <memory>
+#include <vector>
 #include <io/Frame.h>
 #include <io/Logger.h>
 
@@ -27,7 +28,19 @@
 class SpatialAlignment {
     static Logger logger;
 
+    std::vector<cv::Point2i> offsets;
+    std::vector<char> determined;
+
 public:
+    SpatialAlignment(unsigned int sequenceLength = 0);
+
+    /* Offset of frame t, determined on first request and reused afterwards. Slot t must only be
+     * touched by whoever handles frame t, so concurrent passes over different frames are safe. */
+    cv::Point2i frameOffset(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, int crop, unsigned t);
+
+    /* False if the offset of frame t hasn't been determined yet */
+    bool determinedOffset(unsigned t, cv::Point2i &offset) const;
+
     cv::Point2i spatialOffsetDetermination(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, int crop);
 
     void cropAndAlign(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, int crop, cv::Point2i offset);
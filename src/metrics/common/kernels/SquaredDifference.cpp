@@ -0,0 +1,86 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "SquaredDifference.h"
+
+
+std::int64_t SquaredDifference::row(const std::uint8_t *a, const std::uint8_t *b, int n) {
+    std::int64_t sum = 0;
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc64 = _mm_setzero_si128();
+    while (i + 16 <= n) {
+        /* Each 32-bit lane grows by at most 4 * 255^2 per 16 pixels, flush well before it can overflow */
+        __m128i acc32 = _mm_setzero_si128();
+        int blockEnd = std::min(n, i + 16 * 2048);
+        for (; i + 16 <= blockEnd; i += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            __m128i dlo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+            __m128i dhi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+            acc32 = _mm_add_epi32(acc32, _mm_madd_epi16(dlo, dlo));
+            acc32 = _mm_add_epi32(acc32, _mm_madd_epi16(dhi, dhi));
+        }
+        acc64 = _mm_add_epi64(acc64, _mm_unpacklo_epi32(acc32, zero));
+        acc64 = _mm_add_epi64(acc64, _mm_unpackhi_epi32(acc32, zero));
+    }
+    std::int64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc64);
+    sum = lanes[0] + lanes[1];
+#endif
+    for (; i < n; i++) {
+        int d = static_cast<int>(a[i]) - static_cast<int>(b[i]);
+        sum += d * d;
+    }
+    return sum;
+}
+
+std::int64_t SquaredDifference::plane(const cv::Mat &a, const cv::Mat &b) {
+    assert(a.type() == CV_8UC1 && b.type() == CV_8UC1);
+    assert(a.rows == b.rows && a.cols == b.cols);
+
+    std::int64_t sum = 0;
+    for (int r = 0; r < a.rows; r++) {
+        sum += row(a.ptr<std::uint8_t>(r), b.ptr<std::uint8_t>(r), a.cols);
+    }
+    return sum;
+}
+
+std::array<std::int64_t, 3> SquaredDifference::frame(const Frame &a, const Frame &b) {
+    const cv::Mat *planesA[] = {&a.Y, &a.U, &a.V};
+    const cv::Mat *planesB[] = {&b.Y, &b.U, &b.V};
+    std::array<std::int64_t, 3> sums = {{0, 0, 0}};
+
+    int rows = std::max(a.Y.rows, std::max(a.U.rows, a.V.rows));
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < 3; c++) {
+            if (r < planesA[c]->rows) {
+                assert(planesA[c]->cols == planesB[c]->cols && planesA[c]->rows == planesB[c]->rows);
+                sums[c] += row(planesA[c]->ptr<std::uint8_t>(r), planesB[c]->ptr<std::uint8_t>(r), planesA[c]->cols);
+            }
+        }
+    }
+    return sums;
+}
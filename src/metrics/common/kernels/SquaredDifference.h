@@ -0,0 +1,40 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SquaredDifference_h
+#define SquaredDifference_h
+
+#include <array>
+#include <cstdint>
+#include <io/Frame.h>
+
+
+/* Exact sums of squared differences between 8-bit planes. Differences are widened to 16 bits
+ * before squaring, so unlike cv::subtract on CV_8U data nothing saturates. */
+class SquaredDifference {
+public:
+    static std::int64_t plane(const cv::Mat &a, const cv::Mat &b);
+
+    /* Y, U and V in one sweep over the rows of both frames */
+    static std::array<std::int64_t, 3> frame(const Frame &a, const Frame &b);
+
+private:
+    static std::int64_t row(const std::uint8_t *a, const std::uint8_t *b, int n);
+};
+
+#endif //SquaredDifference_h
@@ -0,0 +1,42 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "MemoryBudget.h"
+
+
+MemoryBudget::MemoryBudget(std::size_t bytes)
+        : total(bytes), available(bytes) {
+}
+
+std::size_t MemoryBudget::acquire(std::size_t bytes) {
+    bytes = std::min(bytes, total);
+    std::unique_lock<std::mutex> l(m);
+    cv.wait(l, [&] { return available >= bytes; });
+    available -= bytes;
+    return bytes;
+}
+
+void MemoryBudget::release(std::size_t bytes) {
+    {
+        std::lock_guard<std::mutex> g(m);
+        available += bytes;
+    }
+    cv.notify_all();
+}
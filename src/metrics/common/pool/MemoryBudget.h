@@ -0,0 +1,45 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MemoryBudget_h
+#define MemoryBudget_h
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+
+/* Memory shared by concurrently running jobs. acquire() waits until the bytes asked for are available;
+ * requests larger than the whole budget are clamped to it, so such a job runs once it is alone */
+class MemoryBudget {
+public:
+    MemoryBudget(std::size_t bytes);
+
+    /* Returns the bytes actually reserved, to be handed back to release() */
+    std::size_t acquire(std::size_t bytes);
+
+    void release(std::size_t bytes);
+
+private:
+    std::size_t total;
+    std::size_t available;
+    std::mutex m;
+    std::condition_variable cv;
+};
+
+#endif //MemoryBudget_h
@@ -0,0 +1,122 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <io/Trace.h>
+
+#include "WorkerPool.h"
+
+
+WorkerPool::WorkerPool(unsigned threads)
+        : stopping(false) {
+    for (unsigned i = 0; i < std::max(threads, 1u); i++) {
+        this->threads.push_back(std::thread(&WorkerPool::work, this));
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> g(m);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+unsigned WorkerPool::size() const {
+    return static_cast<unsigned>(threads.size());
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> g(m);
+        tasks.push_back(task);
+    }
+    cv.notify_one();
+}
+
+void WorkerPool::work() {
+    Trace::setThreadName("pool worker");
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> l(m);
+            TraceSpan span("idle");
+            cv.wait(l, [&] { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return;
+            task = tasks.front();
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+WorkerPool::Group::Group(WorkerPool &pool, unsigned limit)
+        : pool(pool), limit(std::max(limit, 1u)), pending(0) {
+}
+
+WorkerPool::Group::~Group() {
+    /* Not rethrowing here, a destructor can't */
+    std::unique_lock<std::mutex> l(m);
+    cv.wait(l, [&] { return pending == 0; });
+}
+
+void WorkerPool::Group::submit(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> l(m);
+        if (pending >= limit) {
+            TraceSpan span("queue full");
+            cv.wait(l, [&] { return pending < limit; });
+        }
+        pending++;
+    }
+    pool.submit([this, task]() {
+        /* An exception must not escape into the pool thread, and pending has to drop either way */
+        try {
+            bool failed;
+            {
+                std::lock_guard<std::mutex> g(m);
+                failed = static_cast<bool>(error);
+            }
+            if (!failed)
+                task();
+        } catch (...) {
+            std::lock_guard<std::mutex> g(m);
+            if (!error)
+                error = std::current_exception();
+        }
+        // Notified under the lock, wait() may return and the group go away as soon as it is released
+        std::lock_guard<std::mutex> g(m);
+        pending--;
+        cv.notify_all();
+    });
+}
+
+void WorkerPool::Group::wait() {
+    std::unique_lock<std::mutex> l(m);
+    cv.wait(l, [&] { return pending == 0; });
+    if (error) {
+        std::exception_ptr first = error;
+        error = nullptr;
+        std::rethrow_exception(first);
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WorkerPool_h
+#define WorkerPool_h
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/* Threads shared by concurrently running algorithms, each pass feeds it through a Group */
+class WorkerPool {
+public:
+    /* Tasks of one pass. submit() blocks while limit of them are queued or running, so a pass can't
+     * flood the pool or decode far ahead of it */
+    class Group {
+    public:
+        Group(WorkerPool &pool, unsigned limit);
+
+        ~Group();
+
+        void submit(std::function<void()> task);
+
+        /* Returns once all submitted tasks have run, then rethrows the first exception one of them threw.
+         * Tasks submitted after it are skipped */
+        void wait();
+
+    private:
+        WorkerPool &pool;
+        unsigned limit;
+        unsigned pending;
+        std::exception_ptr error;
+        std::mutex m;
+        std::condition_variable cv;
+    };
+
+    WorkerPool(unsigned threads);
+
+    ~WorkerPool();
+
+    void submit(std::function<void()> task);
+
+    unsigned size() const;
+
+private:
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()> > tasks;
+    bool stopping;
+    std::mutex m;
+    std::condition_variable cv;
+
+    void work();
+};
+
+#endif //WorkerPool_h
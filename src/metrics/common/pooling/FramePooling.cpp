@@ -0,0 +1,115 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include "FramePooling.h"
+
+
+std::vector<FramePooling::Statistic> FramePooling::parse(const std::string &list) {
+    std::vector<std::string> tokens;
+    boost::algorithm::split(tokens, list, boost::algorithm::is_any_of(","), boost::algorithm::token_compress_on);
+
+    std::vector<Statistic> statistics;
+    for (auto &token : tokens) {
+        if (token.empty())
+            continue;
+        if (token == "hmean") {
+            statistics.push_back({token, std::numeric_limits<double>::quiet_NaN()});
+        } else if (token == "median") {
+            statistics.push_back({token, 0.5});
+        } else {
+            char *end = nullptr;
+            double percentile = token[0] == 'p' ? std::strtod(token.c_str() + 1, &end) : -1;
+            if (!end || *end != '\0' || !(percentile >= 0 && percentile <= 100)) {
+                throw std::runtime_error("Invalid frame statistic \"" + token + "\", expected pN, median or hmean");
+            }
+            statistics.push_back({token, percentile / 100});
+        }
+    }
+    return statistics;
+}
+
+FramePooling::FramePooling(const std::vector<std::string> &names, const std::vector<Statistic> &statistics,
+                           unsigned shardCount)
+        : names(names), statistics(statistics) {
+    for (unsigned i = 0; i < std::max(shardCount, 1u); i++) {
+        std::unique_ptr<Shard> shard(new Shard());
+        shard->sketches.resize(names.size());
+        shard->inverseSums.resize(names.size(), 0.0);
+        shard->counts.resize(names.size(), 0);
+        shard->zeros.resize(names.size(), 0);
+        shard->negatives.resize(names.size(), 0);
+        shards.push_back(std::move(shard));
+    }
+}
+
+void FramePooling::add(const std::vector<double> &values) {
+    Shard &shard = *shards[std::hash<std::thread::id>()(std::this_thread::get_id()) % shards.size()];
+    std::lock_guard<std::mutex> g(shard.m);
+    for (std::size_t i = 0; i < names.size() && i < values.size(); i++) {
+        double v = values[i];
+        if (std::isnan(v))
+            continue;
+        shard.sketches[i].add(v);
+        shard.counts[i]++;
+        if (v > 0) {
+            shard.inverseSums[i] += 1 / v;
+        } else if (v == 0) {
+            shard.zeros[i]++;
+        } else {
+            shard.negatives[i]++;
+        }
+    }
+}
+
+void FramePooling::append(std::vector<std::string> &outNames, std::vector<double> &outValues) const {
+    for (std::size_t i = 0; i < names.size(); i++) {
+        QuantileSketch sketch;
+        double inverseSum = 0;
+        std::uint64_t count = 0, zeros = 0, negatives = 0;
+        for (auto &shard : shards) {
+            std::lock_guard<std::mutex> g(shard->m);
+            sketch.merge(shard->sketches[i]);
+            inverseSum += shard->inverseSums[i];
+            count += shard->counts[i];
+            zeros += shard->zeros[i];
+            negatives += shard->negatives[i];
+        }
+
+        for (auto &statistic : statistics) {
+            double value = std::numeric_limits<double>::quiet_NaN();
+            if (!std::isnan(statistic.quantile)) {
+                value = sketch.quantile(statistic.quantile);
+            } else if (count > 0 && negatives == 0) {
+                // A single zero pulls the harmonic mean to zero
+                value = zeros > 0 ? 0.0 : count / inverseSum;
+            }
+            outNames.push_back(names[i] + "_" + statistic.name);
+            outValues.push_back(value);
+        }
+    }
+}
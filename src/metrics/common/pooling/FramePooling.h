@@ -0,0 +1,70 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FramePooling_h
+#define FramePooling_h
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "QuantileSketch.h"
+
+
+/*
+ * Statistics of the per-frame values of a sequence besides their mean: percentiles from quantile
+ * sketches and the harmonic mean. Frames can be added from any thread, each thread mostly on a shard
+ * of its own; the shards are merged once the sequence is done. Memory doesn't grow with the length
+ * of the sequence.
+ */
+class FramePooling {
+public:
+    struct Statistic {
+        std::string name;
+        double quantile; // NaN for the harmonic mean
+    };
+
+    /* Statistics such as "p1,p5,median,hmean" */
+    static std::vector<Statistic> parse(const std::string &list);
+
+    FramePooling(const std::vector<std::string> &names, const std::vector<Statistic> &statistics,
+                 unsigned shardCount);
+
+    void add(const std::vector<double> &values);
+
+    /* Appends <name>_<statistic> for every value name and statistic */
+    void append(std::vector<std::string> &names, std::vector<double> &values) const;
+
+private:
+    struct Shard {
+        std::mutex m;
+        std::vector<QuantileSketch> sketches;
+        std::vector<double> inverseSums;
+        std::vector<std::uint64_t> counts;
+        std::vector<std::uint64_t> zeros;
+        std::vector<std::uint64_t> negatives;
+    };
+
+    std::vector<std::string> names;
+    std::vector<Statistic> statistics;
+    std::vector<std::unique_ptr<Shard> > shards;
+};
+
+#endif //FramePooling_h
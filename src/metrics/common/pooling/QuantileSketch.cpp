@@ -0,0 +1,127 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "QuantileSketch.h"
+
+
+static const double PI = 3.14159265358979323846;
+
+QuantileSketch::QuantileSketch(double compression)
+        : compression(compression),
+          min(std::numeric_limits<double>::infinity()),
+          max(-std::numeric_limits<double>::infinity()),
+          total(0) {
+}
+
+void QuantileSketch::add(double x) {
+    if (std::isnan(x))
+        return;
+    buffer.push_back(x);
+    min = std::min(min, x);
+    max = std::max(max, x);
+    total++;
+    if (buffer.size() >= 5 * compression) {
+        compress();
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch &other) {
+    centroids.insert(centroids.end(), other.centroids.begin(), other.centroids.end());
+    buffer.insert(buffer.end(), other.buffer.begin(), other.buffer.end());
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    total += other.total;
+    compress();
+}
+
+std::uint64_t QuantileSketch::count() const {
+    return total;
+}
+
+double QuantileSketch::scale(double q) const {
+    return compression / (2 * PI) * std::asin(2 * q - 1);
+}
+
+double QuantileSketch::inverseScale(double k) const {
+    return (std::sin(k * 2 * PI / compression) + 1) / 2;
+}
+
+void QuantileSketch::compress() {
+    std::vector<Centroid> all(centroids);
+    for (double x : buffer) {
+        all.push_back({x, 1});
+    }
+    buffer.clear();
+    if (all.empty())
+        return;
+    std::sort(all.begin(), all.end(), [](const Centroid &a, const Centroid &b) { return a.mean < b.mean; });
+
+    double weight = 0;
+    for (auto &c : all) {
+        weight += c.weight;
+    }
+
+    centroids.clear();
+    Centroid current = all.front();
+    double before = 0;
+    double limit = weight * inverseScale(scale(0) + 1);
+    for (std::size_t i = 1; i < all.size(); i++) {
+        if (before + current.weight + all[i].weight <= limit) {
+            current.mean += (all[i].mean - current.mean) * all[i].weight / (current.weight + all[i].weight);
+            current.weight += all[i].weight;
+        } else {
+            centroids.push_back(current);
+            before += current.weight;
+            limit = weight * inverseScale(scale(before / weight) + 1);
+            current = all[i];
+        }
+    }
+    centroids.push_back(current);
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (total == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+
+    QuantileSketch compressed(*this);
+    compressed.compress();
+    const std::vector<Centroid> &c = compressed.centroids;
+    if (c.size() == 1)
+        return c.front().mean;
+
+    /* Interpolates between centroid centres, and towards min and max beyond the outer ones */
+    double weight = static_cast<double>(total);
+    double target = std::max(0.0, std::min(1.0, q)) * weight;
+    if (target < c.front().weight / 2) {
+        return min + (c.front().mean - min) * target / (c.front().weight / 2);
+    }
+    double centre = c.front().weight / 2;
+    for (std::size_t i = 1; i < c.size(); i++) {
+        double next = centre + (c[i - 1].weight + c[i].weight) / 2;
+        if (target <= next) {
+            return c[i - 1].mean + (c[i].mean - c[i - 1].mean) * (target - centre) / (next - centre);
+        }
+        centre = next;
+    }
+    double rest = weight - centre;
+    return rest > 0 ? c.back().mean + (max - c.back().mean) * (target - centre) / rest : max;
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QuantileSketch_h
+#define QuantileSketch_h
+
+#include <cstdint>
+#include <vector>
+
+
+/*
+ * Merging t-digest: quantiles of a stream of values in memory bounded by the compression (about
+ * compression centroids after compress()). Centroids are kept small near both tails, so the error of
+ * extreme quantiles such as p1 is much smaller than that of the median. Sketches of disjoint parts of
+ * a stream, such as per thread or per shard, can be merged.
+ */
+class QuantileSketch {
+public:
+    QuantileSketch(double compression = 100);
+
+    void add(double x);
+
+    void merge(const QuantileSketch &other);
+
+    /* q in [0, 1], NaN if nothing was added */
+    double quantile(double q) const;
+
+    std::uint64_t count() const;
+
+private:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+    double compression;
+    std::vector<Centroid> centroids;
+    std::vector<double> buffer;
+    double min, max;
+    std::uint64_t total;
+
+    /* Merges the buffer into the centroids */
+    void compress();
+
+    /* Scale function, centroids may span one unit of it */
+    double scale(double q) const;
+
+    double inverseScale(double k) const;
+};
+
+#endif //QuantileSketch_h
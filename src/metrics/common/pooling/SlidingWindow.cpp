@@ -0,0 +1,46 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <limits>
+
+#include "SlidingWindow.h"
+
+
+SlidingWindow::SlidingWindow(unsigned termCount)
+        : first(0), last(0), sums(termCount, 0.0), counts(termCount, 0) {
+}
+
+void SlidingWindow::add(const std::vector<double> &terms, int sign) {
+    for (unsigned i = 0; i < sums.size() && i < terms.size(); i++) {
+        if (std::isnan(terms[i]))
+            continue;
+        sums[i] += sign * terms[i];
+        counts[i] += sign;
+    }
+}
+
+std::vector<double> SlidingWindow::means() const {
+    std::vector<double> means(sums.size(), std::numeric_limits<double>::quiet_NaN());
+    for (unsigned i = 0; i < sums.size(); i++) {
+        if (counts[i] > 0) {
+            means[i] = sums[i] / counts[i];
+        }
+    }
+    return means;
+}
@@ -0,0 +1,58 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SlidingWindow_h
+#define SlidingWindow_h
+
+#include <vector>
+
+
+/*
+ * Means of per-frame terms over a window of frames that only ever moves forward. Frames entering the
+ * window are added to running sums and frames leaving it subtracted, so a whole sequence of windows
+ * costs one addition and at most one subtraction per frame and term. NaN terms are frames without a
+ * value for that term and don't count towards its mean.
+ */
+class SlidingWindow {
+public:
+    SlidingWindow(unsigned termCount);
+
+    /* Moves the window to frames [begin, end), terms(t) is asked for the frames entering it. Neither
+     * end may move backwards. */
+    template<typename Terms>
+    void moveTo(unsigned begin, unsigned end, Terms terms) {
+        for (; last < end; last++) {
+            add(terms(last), 1);
+        }
+        for (; first < begin; first++) {
+            add(terms(first), -1);
+        }
+    }
+
+    /* NaN for terms without a value in the window */
+    std::vector<double> means() const;
+
+private:
+    unsigned first, last;
+    std::vector<double> sums;
+    std::vector<long> counts;
+
+    void add(const std::vector<double> &terms, int sign);
+};
+
+#endif //SlidingWindow_h
@@ -0,0 +1,67 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "ImagePyramid.h"
+
+
+ImagePyramid::ImagePyramid(const cv::Mat &plane, int levels) : levels(levels) {
+    plane.convertTo(this->levels[0], CV_32F);
+    for (int l = 1; l < levels; l++) {
+        downsample(this->levels[l - 1], this->levels[l]);
+    }
+}
+
+int ImagePyramid::size() const {
+    return static_cast<int>(levels.size());
+}
+
+const cv::Mat &ImagePyramid::operator[](int level) const {
+    return levels[level];
+}
+
+void ImagePyramid::downsample(const cv::Mat &in, cv::Mat &out) {
+    assert(in.type() == CV_32FC1);
+    out.create(in.rows / 2, in.cols / 2, CV_32FC1);
+
+    for (int row = 0; row < out.rows; row++) {
+        const float *top = in.ptr<float>(2 * row);
+        const float *bottom = in.ptr<float>(2 * row + 1);
+        float *dst = out.ptr<float>(row);
+        int col = 0;
+#ifdef __SSE2__
+        const __m128 quarter = _mm_set1_ps(0.25f);
+        for (; col + 4 <= out.cols; col += 4) {
+            /* Sum the two input rows, then add horizontal neighbours pairwise */
+            __m128 lo = _mm_add_ps(_mm_loadu_ps(top + 2 * col), _mm_loadu_ps(bottom + 2 * col));
+            __m128 hi = _mm_add_ps(_mm_loadu_ps(top + 2 * col + 4), _mm_loadu_ps(bottom + 2 * col + 4));
+            __m128 even = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 odd = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(dst + col, _mm_mul_ps(_mm_add_ps(even, odd), quarter));
+        }
+#endif
+        for (; col < out.cols; col++) {
+            dst[col] = 0.25f * ((top[2 * col] + bottom[2 * col]) + (top[2 * col + 1] + bottom[2 * col + 1]));
+        }
+    }
+}
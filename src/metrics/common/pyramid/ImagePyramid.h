@@ -0,0 +1,42 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ImagePyramid_h
+#define ImagePyramid_h
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+
+/* Dyadic image pyramid: level 0 is the input plane converted to CV_32F, each following
+ * level is the 2x2 box average of the previous one (odd trailing rows/columns are dropped). */
+class ImagePyramid {
+public:
+    ImagePyramid(const cv::Mat &plane, int levels);
+
+    int size() const;
+
+    const cv::Mat &operator[](int level) const;
+
+    static void downsample(const cv::Mat &in, cv::Mat &out);
+
+private:
+    std::vector<cv::Mat> levels;
+};
+
+#endif //ImagePyramid_h
@@ -0,0 +1,131 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include <io/Json.h>
+
+#include "FrameTable.h"
+
+
+static const char MAGIC[8] = "OVQFRMS";
+static const std::uint64_t ALIGNMENT = 64;
+
+Logger FrameTableWriter::logger = Logger("FrameTable");
+
+FrameTableWriter::FrameTableWriter(const std::string &path, const std::string &algorithm,
+                                   const std::string &identifier, const std::vector<std::string> &columns,
+                                   std::uint32_t chunkFrames)
+        : path(path), out(path, std::ofstream::binary | std::ofstream::trunc), chunkStart(0), next(0),
+          closed(false) {
+    if (!out) {
+        throw std::runtime_error("Could not open frame table " + path);
+    }
+
+    std::ostringstream metadata;
+    metadata << "{" << Json::string("algorithm") << ": " << Json::string(algorithm)
+             << ", " << Json::string("identifier") << ": " << Json::string(identifier)
+             << ", " << Json::string("columns") << ": [";
+    for (unsigned c = 0; c < columns.size(); c++) {
+        metadata << (c ? ", " : "") << Json::string(columns[c]);
+    }
+    metadata << "]}";
+    std::string text = metadata.str();
+
+    std::memset(&head, 0, sizeof(head));
+    std::memcpy(head.magic, MAGIC, sizeof(MAGIC));
+    head.version = VERSION;
+    head.columns = static_cast<std::uint32_t>(columns.size());
+    head.chunkFrames = chunkFrames;
+    head.metadataSize = static_cast<std::uint32_t>(text.size());
+    head.dataOffset = (sizeof(head) + text.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    text.resize(head.dataOffset - sizeof(head), '\0');
+    out.write(reinterpret_cast<const char *>(&head), sizeof(head));
+    out.write(text.data(), text.size());
+
+    chunk.assign(static_cast<std::size_t>(head.columns) * chunkFrames, std::numeric_limits<double>::quiet_NaN());
+}
+
+FrameTableWriter::~FrameTableWriter() {
+    try {
+        close();
+    } catch (std::exception &e) {
+        logger(ERROR) << e.what();
+    }
+}
+
+void FrameTableWriter::add(unsigned t, const std::vector<double> &values) {
+    std::lock_guard<std::mutex> g(m);
+    if (t < next)
+        return;
+    if (t > next) {
+        pending[t] = values;
+        return;
+    }
+
+    place(next++, values);
+    for (auto it = pending.begin(); it != pending.end() && it->first == next; it = pending.erase(it)) {
+        place(next++, it->second);
+    }
+}
+
+void FrameTableWriter::place(std::uint64_t t, const std::vector<double> &values) {
+    while (t >= chunkStart + head.chunkFrames) {
+        writeChunk();
+    }
+    std::size_t row = static_cast<std::size_t>(t - chunkStart);
+    for (std::size_t c = 0; c < head.columns && c < values.size(); c++) {
+        chunk[c * head.chunkFrames + row] = values[c];
+    }
+    head.frameCount = std::max(head.frameCount, t + 1);
+}
+
+void FrameTableWriter::writeChunk() {
+    out.write(reinterpret_cast<const char *>(chunk.data()), chunk.size() * sizeof(double));
+    std::fill(chunk.begin(), chunk.end(), std::numeric_limits<double>::quiet_NaN());
+    chunkStart += head.chunkFrames;
+}
+
+void FrameTableWriter::close() {
+    std::lock_guard<std::mutex> g(m);
+    if (closed)
+        return;
+    closed = true;
+
+    /* Frames that never arrived, such as after an aborted pass, stay NaN */
+    for (auto &frame : pending) {
+        place(frame.first, frame.second);
+    }
+    pending.clear();
+    if (head.frameCount > chunkStart) {
+        writeChunk();
+    }
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&head), sizeof(head));
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Could not write frame table " + path);
+    }
+    logger(DEBUG) << "Wrote " << head.frameCount << " frames to " << path;
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FrameTable_h
+#define FrameTable_h
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <io/Logger.h>
+
+
+/*
+ * Per-frame values of one PVS in a binary file laid out for memory mapping:
+ *
+ *   Header      magic "OVQFRMS\0", version, column count, frames per chunk, metadata size,
+ *               frame count (written on close, 0 until then) and the offset of the first chunk
+ *   metadata    JSON object with algorithm, identifier and the column names, zero padded to 64 bytes
+ *   chunks      column after column, frames per chunk doubles each, the last chunk padded with NaN
+ *
+ * Value c of frame t is therefore at dataOffset + (t / chunkFrames) * chunkFrames * columns * 8
+ * + (c * chunkFrames + t % chunkFrames) * 8, in native byte order. Missing values are NaN.
+ */
+class FrameTableWriter {
+public:
+    static const std::uint32_t VERSION = 1;
+
+    FrameTableWriter(const std::string &path, const std::string &algorithm, const std::string &identifier,
+                     const std::vector<std::string> &columns, std::uint32_t chunkFrames = 4096);
+
+    ~FrameTableWriter();
+
+    /* Frames may be added from several threads and in any order, they are written out in frame order
+     * as soon as all frames before them are there */
+    void add(unsigned t, const std::vector<double> &values);
+
+    /* Writes the frames added so far, frames missing in between are left NaN */
+    void close();
+
+private:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t columns;
+        std::uint32_t chunkFrames;
+        std::uint32_t metadataSize;
+        std::uint64_t frameCount;
+        std::uint64_t dataOffset;
+    };
+
+    static Logger logger;
+
+    std::string path;
+    std::ofstream out;
+    Header head;
+    std::vector<double> chunk;
+    std::uint64_t chunkStart;
+    std::uint64_t next;
+    std::map<unsigned, std::vector<double> > pending;
+    std::mutex m;
+    bool closed;
+
+    void place(std::uint64_t t, const std::vector<double> &values);
+
+    void writeChunk();
+};
+
+#endif //FrameTable_h
@@ -0,0 +1,159 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <io/Json.h>
+
+#include "ResultSink.h"
+
+
+Logger LockedAppendSink::logger = Logger("ResultSink");
+
+LockedAppendSink::LockedAppendSink(const std::string &path)
+        : path(path), scanned(0) {
+    /* Read as well, to find the last header other processes wrote */
+    fd = open(path.c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open result file " + path + ": " + std::strerror(errno));
+    }
+}
+
+LockedAppendSink::~LockedAppendSink() {
+    close(fd);
+}
+
+void LockedAppendSink::append(const std::string &text, const std::string &header) {
+    std::lock_guard<std::mutex> g(m);
+    if (flock(fd, LOCK_EX) != 0) {
+        throw std::runtime_error("Could not lock result file " + path + ": " + std::strerror(errno));
+    }
+
+    std::string data = text;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        info.st_size = scanned;
+    }
+    if (!header.empty()) {
+        if (!scanHeaders(header.substr(0, header.find(',') + 1), info.st_size)) {
+            flock(fd, LOCK_UN);
+            throw std::runtime_error("Could not read result file " + path + ": " + std::strerror(errno));
+        }
+        if (header != lastHeader) {
+            data = header + text;
+            lastHeader = header;
+        }
+    }
+    std::size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            flock(fd, LOCK_UN);
+            throw std::runtime_error("Could not write to result file " + path + ": " + std::strerror(errno));
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    /* Nobody else appends while the file is locked */
+    scanned = info.st_size + static_cast<off_t>(data.size());
+    flock(fd, LOCK_UN);
+    logger(DEBUG) << "Wrote values to " << path;
+}
+
+bool LockedAppendSink::scanHeaders(const std::string &prefix, off_t size) {
+    /* Everything before scanned ends with a complete line, records are only ever appended whole */
+    char buffer[65536];
+    std::string line;
+    while (scanned < size) {
+        ssize_t n = pread(fd, buffer, static_cast<std::size_t>(std::min<off_t>(sizeof(buffer), size - scanned)), scanned);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        for (ssize_t i = 0; i < n; i++) {
+            line += buffer[i];
+            if (buffer[i] == '\n') {
+                if (line.compare(0, prefix.size(), prefix) == 0)
+                    lastHeader = line;
+                line.clear();
+            }
+        }
+        scanned += n;
+    }
+    return true;
+}
+
+static std::string csvField(const std::string &field) {
+    if (field.find_first_of(",\"\n") == std::string::npos)
+        return field;
+
+    std::string quoted = "\"";
+    for (char c : field) {
+        quoted += c == '"' ? "\"\"" : std::string(1, c);
+    }
+    return quoted + "\"";
+}
+
+CsvSink::CsvSink(const std::string &path)
+        : LockedAppendSink(path) {
+}
+
+void CsvSink::write(const ResultRecord &record) {
+    std::ostringstream header;
+    header << "algorithm,identifier";
+    for (unsigned i = 0; i < record.values.size(); i++) {
+        header << "," << csvField(i < record.names.size() ? record.names[i] : std::to_string(i));
+    }
+    header << "\n";
+
+    std::ostringstream line;
+    line << std::setprecision(std::numeric_limits<double>::digits10 + 1);
+    line << csvField(record.algorithm) << "," << csvField(record.identifier);
+    for (double value : record.values) {
+        line << "," << value;
+    }
+    line << "\n";
+    append(line.str(), header.str());
+}
+
+JsonSink::JsonSink(const std::string &path)
+        : LockedAppendSink(path) {
+}
+
+void JsonSink::write(const ResultRecord &record) {
+    std::ostringstream line;
+    line << "{" << Json::string("identifier") << ": " << Json::string(record.identifier);
+    for (unsigned i = 0; i < record.values.size(); i++) {
+        line << ", " << Json::string(i < record.names.size() ? record.names[i] : std::to_string(i)) << ": "
+             << Json::number(record.values[i]);
+    }
+    line << "}\n";
+    append(line.str());
+}
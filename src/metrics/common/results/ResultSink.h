@@ -0,0 +1,95 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ResultSink_h
+#define ResultSink_h
+
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include <io/Logger.h>
+
+
+/* The values of one scored sequence, and of each of its frames if the algorithm has per-frame values */
+struct ResultRecord {
+    std::string algorithm;
+    std::string identifier;
+    std::vector<std::string> names;
+    std::vector<double> values;
+    std::vector<std::string> frameNames;
+    std::vector<std::vector<double> > frameValues;
+};
+
+/* Destination of results, such as the --csv file. Sinks may be shared by several processes */
+class ResultSink {
+public:
+    virtual ~ResultSink() {
+    };
+
+    virtual void write(const ResultRecord &record) = 0;
+
+    /* Sinks may buffer records until then */
+    virtual void flush() {
+    };
+};
+
+/* File that is only ever appended to. Each append holds an exclusive flock and is a single write(), so
+ * records of concurrent processes don't interleave */
+class LockedAppendSink : public ResultSink {
+public:
+    LockedAppendSink(const std::string &path);
+
+    ~LockedAppendSink();
+
+protected:
+    /* header is written first unless it is the last header in the file already. Header lines are those that
+     * start with the header's first field */
+    void append(const std::string &text, const std::string &header = "");
+
+private:
+    std::string path;
+    int fd;
+    std::mutex m;
+    /* The file up to scanned was read or written by this sink, lastHeader is its last header */
+    off_t scanned;
+    std::string lastHeader;
+    static Logger logger;
+
+    /* Reads the lines up to size that weren't read yet, false if reading failed */
+    bool scanHeaders(const std::string &prefix, off_t size);
+};
+
+/* algorithm,identifier,value,... lines, below an algorithm,identifier,name,... header whenever the names change */
+class CsvSink : public LockedAppendSink {
+public:
+    CsvSink(const std::string &path);
+
+    void write(const ResultRecord &record) override;
+};
+
+/* One JSON object of identifier and named values per line */
+class JsonSink : public LockedAppendSink {
+public:
+    JsonSink(const std::string &path);
+
+    void write(const ResultRecord &record) override;
+};
+
+#endif //ResultSink_h
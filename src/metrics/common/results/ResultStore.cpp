@@ -0,0 +1,92 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <io/ContentHash.h>
+
+#include "ResultStore.h"
+
+
+static std::atomic<unsigned> temporaryCount(0);
+
+Logger ResultStore::logger = Logger("ResultStore");
+
+ResultStore::ResultStore(const std::string &directory)
+        : directory(directory) {
+}
+
+std::string ResultStore::path(std::uint64_t key) const {
+    return directory + "/" + ContentHash::hex(key) + ".result";
+}
+
+bool ResultStore::lookup(std::uint64_t key, std::vector<std::string> &names, std::vector<double> &values) const {
+    std::ifstream in(path(key));
+    if (!in)
+        return false;
+
+    // One "name value" line per value, value as written by operator<< so nan and inf come back
+    names.clear();
+    values.clear();
+    std::string name, value;
+    while (in >> name >> value) {
+        names.push_back(name);
+        values.push_back(std::strtod(value.c_str(), nullptr));
+    }
+    return !values.empty();
+}
+
+void ResultStore::store(std::uint64_t key, const std::vector<std::string> &names,
+                        const std::vector<double> &values) const {
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        logger(WARN) << "Could not create result directory " << directory << ": " << std::strerror(errno);
+        return;
+    }
+
+    // Written aside and renamed, concurrent runs never see half a result
+    std::string target = path(key);
+    std::string temporary = target + ".tmp." + std::to_string(getpid()) + "." + std::to_string(temporaryCount++);
+    {
+        std::ofstream out(temporary);
+        out << std::setprecision(std::numeric_limits<double>::digits10 + 2);
+        for (unsigned i = 0; i < values.size(); i++) {
+            out << (i < names.size() ? names[i] : std::to_string(i)) << " " << values[i] << "\n";
+        }
+        if (!out) {
+            logger(WARN) << "Could not write result to " << temporary;
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), target.c_str()) != 0) {
+        logger(WARN) << "Could not store result in " << target;
+        std::remove(temporary.c_str());
+        return;
+    }
+    logger(DEBUG) << "Stored result in " << target;
+}
@@ -0,0 +1,47 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ResultStore_h
+#define ResultStore_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <io/Logger.h>
+
+
+/* Directory of named result values, one small file per key */
+class ResultStore {
+public:
+    ResultStore(const std::string &directory);
+
+    /* False if there is no result for key */
+    bool lookup(std::uint64_t key, std::vector<std::string> &names, std::vector<double> &values) const;
+
+    void store(std::uint64_t key, const std::vector<std::string> &names, const std::vector<double> &values) const;
+
+private:
+    static Logger logger;
+
+    std::string directory;
+
+    std::string path(std::uint64_t key) const;
+};
+
+#endif //ResultStore_h
@@ -0,0 +1,173 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef OPENVQ_SQLITE
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+#include <sqlite3.h>
+
+#include "SqliteSink.h"
+
+
+static const char *SCHEMA =
+        "CREATE TABLE IF NOT EXISTS schema (name TEXT PRIMARY KEY, value TEXT);"
+        "CREATE TABLE IF NOT EXISTS results (id INTEGER PRIMARY KEY, algorithm TEXT NOT NULL,"
+        " identifier TEXT NOT NULL, created TEXT NOT NULL DEFAULT CURRENT_TIMESTAMP);"
+        "CREATE TABLE IF NOT EXISTS result_values (result INTEGER NOT NULL REFERENCES results(id),"
+        " name TEXT NOT NULL, value REAL, PRIMARY KEY (result, name));"
+        "CREATE TABLE IF NOT EXISTS frame_values (result INTEGER NOT NULL REFERENCES results(id),"
+        " frame INTEGER NOT NULL, name TEXT NOT NULL, value REAL, PRIMARY KEY (result, frame, name));";
+
+typedef std::unique_ptr<sqlite3_stmt, int (*)(sqlite3_stmt *)> Statement;
+
+Logger SqliteSink::logger = Logger("SqliteSink");
+
+SqliteSink::SqliteSink(const std::string &path, unsigned batchSize)
+        : path(path), db(nullptr), batchSize(std::max(batchSize, 1u)) {
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        std::string error = db ? sqlite3_errmsg(db) : "out of memory";
+        sqlite3_close(db);
+        throw std::runtime_error("Could not open result database " + path + ": " + error);
+    }
+    sqlite3_busy_timeout(db, 60000);
+
+    try {
+        // WAL lets readers look at the results while a batch run keeps writing
+        exec("PRAGMA journal_mode=WAL");
+        exec(std::string("BEGIN IMMEDIATE;") + SCHEMA +
+             "INSERT OR IGNORE INTO schema VALUES ('version', '" + std::to_string(SCHEMA_VERSION) + "');"
+             "COMMIT");
+
+        sqlite3_stmt *raw = nullptr;
+        sqlite3_prepare_v2(db, "SELECT value FROM schema WHERE name = 'version'", -1, &raw, nullptr);
+        Statement version(raw, sqlite3_finalize);
+        if (!version || sqlite3_step(version.get()) != SQLITE_ROW ||
+            sqlite3_column_int(version.get(), 0) != SCHEMA_VERSION) {
+            throw std::runtime_error("Result database " + path + " has an unsupported schema version");
+        }
+    } catch (...) {
+        sqlite3_close(db);
+        throw;
+    }
+}
+
+SqliteSink::~SqliteSink() {
+    try {
+        flush();
+    } catch (std::exception &e) {
+        logger(ERROR) << e.what();
+    }
+    sqlite3_close(db);
+}
+
+void SqliteSink::exec(const std::string &sql) {
+    char *error = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+        std::string message = error ? error : sqlite3_errmsg(db);
+        sqlite3_free(error);
+        throw std::runtime_error("Result database " + path + ": " + message);
+    }
+}
+
+void SqliteSink::write(const ResultRecord &record) {
+    std::lock_guard<std::mutex> g(m);
+    pending.push_back(record);
+    if (pending.size() >= batchSize) {
+        flushPending();
+    }
+}
+
+void SqliteSink::flush() {
+    std::lock_guard<std::mutex> g(m);
+    flushPending();
+}
+
+void SqliteSink::flushPending() {
+    if (pending.empty())
+        return;
+
+    exec("BEGIN IMMEDIATE");
+    try {
+        for (auto &record : pending) {
+            insert(record);
+        }
+        exec("COMMIT");
+    } catch (...) {
+        sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+        throw;
+    }
+    logger(DEBUG) << "Wrote " << pending.size() << " results to " << path;
+    pending.clear();
+}
+
+static Statement prepare(sqlite3 *db, const char *sql) {
+    sqlite3_stmt *raw = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &raw, nullptr) != SQLITE_OK) {
+        throw std::runtime_error(sqlite3_errmsg(db));
+    }
+    return Statement(raw, sqlite3_finalize);
+}
+
+static void bindValue(sqlite3_stmt *statement, int index, double value) {
+    if (std::isfinite(value)) {
+        sqlite3_bind_double(statement, index, value);
+    } else {
+        sqlite3_bind_null(statement, index);
+    }
+}
+
+static void step(sqlite3 *db, sqlite3_stmt *statement) {
+    if (sqlite3_step(statement) != SQLITE_DONE) {
+        throw std::runtime_error(sqlite3_errmsg(db));
+    }
+    sqlite3_reset(statement);
+}
+
+void SqliteSink::insert(const ResultRecord &record) {
+    Statement result = prepare(db, "INSERT INTO results (algorithm, identifier) VALUES (?, ?)");
+    sqlite3_bind_text(result.get(), 1, record.algorithm.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(result.get(), 2, record.identifier.c_str(), -1, SQLITE_TRANSIENT);
+    step(db, result.get());
+    sqlite3_int64 id = sqlite3_last_insert_rowid(db);
+
+    Statement value = prepare(db, "INSERT INTO result_values (result, name, value) VALUES (?, ?, ?)");
+    for (unsigned i = 0; i < record.values.size(); i++) {
+        std::string name = i < record.names.size() ? record.names[i] : std::to_string(i);
+        sqlite3_bind_int64(value.get(), 1, id);
+        sqlite3_bind_text(value.get(), 2, name.c_str(), -1, SQLITE_TRANSIENT);
+        bindValue(value.get(), 3, record.values[i]);
+        step(db, value.get());
+    }
+
+    Statement frameValue = prepare(db, "INSERT INTO frame_values (result, frame, name, value) VALUES (?, ?, ?, ?)");
+    for (unsigned t = 0; t < record.frameValues.size(); t++) {
+        for (unsigned i = 0; i < record.frameValues[t].size() && i < record.frameNames.size(); i++) {
+            sqlite3_bind_int64(frameValue.get(), 1, id);
+            sqlite3_bind_int(frameValue.get(), 2, static_cast<int>(t));
+            sqlite3_bind_text(frameValue.get(), 3, record.frameNames[i].c_str(), -1, SQLITE_STATIC);
+            bindValue(frameValue.get(), 4, record.frameValues[t][i]);
+            step(db, frameValue.get());
+        }
+    }
+}
+
+#endif //OPENVQ_SQLITE
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SqliteSink_h
+#define SqliteSink_h
+
+#ifdef OPENVQ_SQLITE
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ResultSink.h"
+
+struct sqlite3;
+
+/*
+ * Results in an SQLite database, sequence values in result_values and per-frame values in frame_values,
+ * both referring to a row of results. Records are buffered and inserted batchSize at a time in one
+ * transaction; concurrent processes wait for each other's transactions.
+ */
+class SqliteSink : public ResultSink {
+public:
+    static const int SCHEMA_VERSION = 1;
+
+    SqliteSink(const std::string &path, unsigned batchSize = 64);
+
+    ~SqliteSink();
+
+    void write(const ResultRecord &record) override;
+
+    void flush() override;
+
+private:
+    std::string path;
+    sqlite3 *db;
+    unsigned batchSize;
+    std::vector<ResultRecord> pending;
+    std::mutex m;
+    static Logger logger;
+
+    void exec(const std::string &sql);
+
+    void insert(const ResultRecord &record);
+
+    void flushPending();
+};
+
+#endif //OPENVQ_SQLITE
+
+#endif //SqliteSink_h
@@ -0,0 +1,160 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/program_options/variables_map.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <cmath>
+#include <numeric>
+#include <metrics/common/pyramid/ImagePyramid.h>
+
+#include "MSSSIM.h"
+
+/* Exponents from Wang, Simoncelli and Bovik, "Multi-scale structural similarity for image quality assessment" */
+const double MSSSIM::scaleWeights[NUM_SCALES] = {0.0448, 0.2856, 0.3001, 0.2363, 0.1333};
+
+MSSSIM::MSSSIM()
+        : ParallelFullReferenceAlgorithm("MSSSIM") {
+    options.add_options()("disable-spatial-alignment", "Disable spatial alignment");
+}
+
+void MSSSIM::configure(const opts::variables_map &vm) {
+    ParallelFullReferenceAlgorithm::configure(vm);
+
+    enableSpatialAlignment = !static_cast<bool>(vm.count("disable-spatial-alignment"));
+}
+
+int MSSSIM::spatialAlignmentCrop() const {
+    return enableSpatialAlignment ? 4 : 0;
+}
+
+void MSSSIM::validateInput(VideoInfo &srcInfo, VideoInfo &pvsInfo) {
+    FullReferenceAlgorithm::validateInput(srcInfo, pvsInfo);
+
+    int coarsest = std::min(srcInfo.width, srcInfo.height) >> (NUM_SCALES - 1);
+    if (coarsest < 11) {
+        logger(WARN) << "Coarsest scale is only " << coarsest << " pixels across, "
+                     << "smaller than the 11x11 SSIM window.";
+    }
+}
+
+void MSSSIM::initAnalysis() {
+    msssimValues.assign(sequenceLength, 0.0);
+    csValues.assign(sequenceLength, std::array<double, NUM_SCALES>());
+    lValues.assign(sequenceLength, 0.0);
+}
+
+void MSSSIM::analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                           std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) {
+    if (enableSpatialAlignment) {
+        int crop = 4;
+        cv::Point2i sptialOffset = spatialAlignment->frameOffset(srcCurr, pvsCurr, crop, t);
+        spatialAlignment->cropAndAlign(srcCurr, pvsCurr, crop, sptialOffset);
+    }
+
+    addFrame(srcCurr, pvsCurr, t);
+}
+
+std::vector<double> MSSSIM::finishAnalysis() {
+    /* Pool each scale over time; the values are MS-SSIM, cs per scale (finest first), l at the coarsest */
+    double frames = static_cast<double>(msssimValues.size());
+    std::vector<double> values(1, std::accumulate(msssimValues.begin(), msssimValues.end(), 0.0) / frames);
+    for (int s = 0; s < NUM_SCALES; s++) {
+        double csSum = 0.0;
+        for (auto &cs : csValues) {
+            csSum += cs[s];
+        }
+        values.push_back(csSum / frames);
+        logger(DEBUG) << "Scale " << s << " contrast-structure: " << values.back();
+    }
+    values.push_back(std::accumulate(lValues.begin(), lValues.end(), 0.0) / frames);
+    logger(DEBUG) << "Scale " << NUM_SCALES - 1 << " luminance: " << values.back();
+
+    logger(INFO) << "MS-SSIM: " << values[0];
+    return values;
+}
+
+std::vector<std::string> MSSSIM::valueNames() const {
+    std::vector<std::string> names(1, "msssim");
+    for (int s = 0; s < NUM_SCALES; s++) {
+        names.push_back("msssim_cs_" + std::to_string(s));
+    }
+    names.push_back("msssim_l_" + std::to_string(NUM_SCALES - 1));
+    return names;
+}
+
+void MSSSIM::addFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame, unsigned t) {
+    ImagePyramid srcPyramid(srcFrame->Y, NUM_SCALES);
+    ImagePyramid pvsPyramid(pvsFrame->Y, NUM_SCALES);
+
+    double msssim = 1.0;
+    for (int s = 0; s < NUM_SCALES; s++) {
+        double *l = (s == NUM_SCALES - 1) ? &lValues[t] : nullptr;
+        ssimTerms(srcPyramid[s], pvsPyramid[s], l, &csValues[t][s]);
+
+        /* Negative contrast-structure values are clipped, a fractional power of them is undefined */
+        msssim *= std::pow(std::max(csValues[t][s], 0.0), scaleWeights[s]);
+    }
+    msssimValues[t] = msssim * std::pow(std::max(lValues[t], 0.0), scaleWeights[NUM_SCALES - 1]);
+}
+
+void MSSSIM::ssimTerms(const cv::Mat &src, const cv::Mat &pvs, double *l, double *cs) {
+    //todo: (0.01*dynamic range)^2 and (0.03*dynamic range)^2, as in SSIM
+    const double c1 = 6.5025;
+    const double c2 = 58.5225;
+
+    const cv::Size window(11, 11);
+    const double sigma = 1.5;
+
+    cv::Mat srcSq, pvsSq, srcPvs;
+    cv::multiply(src, src, srcSq);
+    cv::multiply(pvs, pvs, pvsSq);
+    cv::multiply(src, pvs, srcPvs);
+
+    cv::Mat mu1, mu2, s11, s22, s12;
+    cv::GaussianBlur(src, mu1, window, sigma);
+    cv::GaussianBlur(pvs, mu2, window, sigma);
+    cv::GaussianBlur(srcSq, s11, window, sigma);
+    cv::GaussianBlur(pvsSq, s22, window, sigma);
+    cv::GaussianBlur(srcPvs, s12, window, sigma);
+
+    /* Local statistics and both similarity maps in a single sweep over the filtered planes */
+    double lSum = 0.0, csSum = 0.0;
+    for (int row = 0; row < src.rows; row++) {
+        const float *m1 = mu1.ptr<float>(row), *m2 = mu2.ptr<float>(row);
+        const float *e11 = s11.ptr<float>(row), *e22 = s22.ptr<float>(row), *e12 = s12.ptr<float>(row);
+        for (int col = 0; col < src.cols; col++) {
+            double mu1mu2 = static_cast<double>(m1[col]) * m2[col];
+            double mu1Sq = static_cast<double>(m1[col]) * m1[col];
+            double mu2Sq = static_cast<double>(m2[col]) * m2[col];
+            double sigma12 = e12[col] - mu1mu2;
+            double sigma1Sq = e11[col] - mu1Sq;
+            double sigma2Sq = e22[col] - mu2Sq;
+
+            csSum += (2.0 * sigma12 + c2) / (sigma1Sq + sigma2Sq + c2);
+            if (l) {
+                lSum += (2.0 * mu1mu2 + c1) / (mu1Sq + mu2Sq + c1);
+            }
+        }
+    }
+
+    double pixels = static_cast<double>(src.rows) * src.cols;
+    *cs = csSum / pixels;
+    if (l) {
+        *l = lSum / pixels;
+    }
+}
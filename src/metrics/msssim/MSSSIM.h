@@ -0,0 +1,63 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MSSSIM_H
+#define MSSSIM_H
+
+#include <array>
+#include <vector>
+
+#include <io/Frame.h>
+#include "metrics/Algorithm.h"
+
+class MSSSIM : public ParallelFullReferenceAlgorithm {
+public:
+    static const int NUM_SCALES = 5;
+
+    MSSSIM();
+
+    void initAnalysis() override;
+
+    void analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                       std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) override;
+
+    std::vector<double> finishAnalysis() override;
+
+    std::vector<std::string> valueNames() const override;
+
+    int spatialAlignmentCrop() const override;
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+private:
+    static const double scaleWeights[NUM_SCALES];
+
+    bool enableSpatialAlignment;
+    std::vector<double> msssimValues;
+    std::vector<std::array<double, NUM_SCALES> > csValues;
+    std::vector<double> lValues;
+
+    virtual void validateInput(VideoInfo &srcInfo, VideoInfo &pvsInfo) override;
+
+    void addFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame, unsigned t);
+
+    static void ssimTerms(const cv::Mat &src, const cv::Mat &pvs, double *l, double *cs);
+};
+
+#endif
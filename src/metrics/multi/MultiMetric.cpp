@@ -0,0 +1,210 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <boost/algorithm/string.hpp>
+
+#include <metrics/Metrics.h>
+#include "MultiMetric.h"
+
+
+MultiMetric::MultiMetric()
+        : ParallelFullReferenceAlgorithm("Multi") {
+    options.add_options()
+            ("metrics", opts::value<std::string>()->default_value("psnr,ssim,opvq"),
+             "Comma separated list of metrics computed from the same decode. "
+             "Options of the individual metrics are passed on to them");
+}
+
+void MultiMetric::configure(const opts::variables_map &vm) {
+    ParallelFullReferenceAlgorithm::configure(vm);
+
+    metricNames.clear();
+    std::vector<std::string> names;
+    boost::split(names, vm["metrics"].as<std::string>(), boost::is_any_of(","));
+    for (auto &name : names) {
+        boost::trim(name);
+        if (!name.empty() && std::find(metricNames.begin(), metricNames.end(), name) == metricNames.end()) {
+            metricNames.push_back(name);
+        }
+    }
+    if (metricNames.empty()) {
+        throw std::runtime_error("No metrics given");
+    }
+}
+
+void MultiMetric::init(int argc, const char **argv) {
+    parseOptions(argc, argv);
+
+    metrics.clear();
+    for (auto &name : metricNames) {
+        std::unique_ptr<Algorithm> algorithm = Metrics::getAlgorithm(name);
+        FullReferenceAlgorithm *metric = dynamic_cast<FullReferenceAlgorithm *>(algorithm.get());
+        if (!metric || dynamic_cast<MultiMetric *>(metric)) {
+            throw std::runtime_error("Metric can't be combined: " + name);
+        }
+        algorithm.release();
+        metrics.push_back(std::unique_ptr<FullReferenceAlgorithm>(metric));
+
+        metric->parseOptions(argc, argv);
+        optionsKey += " " + metric->resultOptions();
+        logger(DEBUG) << "Added metric " << name;
+    }
+
+    openSequences();
+    if (pvsURLs.empty())
+        return;
+    for (auto &metric : metrics) {
+        metric->attach(*this);
+    }
+}
+
+std::vector<double> MultiMetric::frameValues(unsigned t) const {
+    std::vector<double> values;
+    for (auto &metric : metrics) {
+        std::vector<double> metricValues = metric->frameValues(t);
+        values.insert(values.end(), metricValues.begin(), metricValues.end());
+    }
+    return values;
+}
+
+std::vector<std::string> MultiMetric::frameValueNames() const {
+    std::vector<std::string> names;
+    for (auto &metric : metrics) {
+        std::vector<std::string> metricNames = metric->frameValueNames();
+        names.insert(names.end(), metricNames.begin(), metricNames.end());
+    }
+    return names;
+}
+
+std::vector<double> MultiMetric::poolingTerms(unsigned t) const {
+    std::vector<double> terms;
+    for (auto &metric : metrics) {
+        std::vector<double> metricTerms = metric->poolingTerms(t);
+        terms.insert(terms.end(), metricTerms.begin(), metricTerms.end());
+    }
+    return terms;
+}
+
+/* Metrics without windowed values keep their columns, as NaN */
+std::vector<double> MultiMetric::windowValues(const std::vector<double> &termMeans) const {
+    std::vector<double> values;
+    std::size_t offset = 0;
+    for (auto &metric : metrics) {
+        std::size_t termCount = metric->poolingTerms(0).size();
+        std::vector<double> metricValues(metric->valueNames().size(), std::numeric_limits<double>::quiet_NaN());
+        if (termCount > 0) {
+            metricValues = metric->windowValues(std::vector<double>(termMeans.begin() + offset,
+                                                                    termMeans.begin() + offset + termCount));
+        }
+        values.insert(values.end(), metricValues.begin(), metricValues.end());
+        offset += termCount;
+    }
+    return values;
+}
+
+int MultiMetric::spatialAlignmentCrop() const {
+    int crop = 0;
+    for (auto &metric : metrics) {
+        crop = std::max(crop, metric->spatialAlignmentCrop());
+    }
+    return crop;
+}
+
+std::size_t MultiMetric::scratchBytesPerPixel() const {
+    std::size_t bytes = 0;
+    for (auto &metric : metrics) {
+        bytes += metric->scratchBytesPerPixel();
+    }
+    return bytes;
+}
+
+std::size_t MultiMetric::perFrameBytes() const {
+    std::size_t bytes = 0;
+    for (auto &metric : metrics) {
+        bytes += metric->perFrameBytes();
+    }
+    return bytes;
+}
+
+void MultiMetric::initAnalysis() {
+    for (auto &metric : metrics) {
+        metric->initAnalysis();
+    }
+}
+
+bool MultiMetric::hasPreparationPass() const {
+    for (auto &metric : metrics) {
+        if (metric->hasPreparationPass())
+            return true;
+    }
+    return false;
+}
+
+void MultiMetric::preparationFrame(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, unsigned t) {
+    /* One offset per frame, determined with the widest crop any of the metrics uses */
+    int crop = spatialAlignmentCrop();
+    if (crop > 0) {
+        spatialAlignment->frameOffset(srcFrame, pvsFrame, crop, t);
+    }
+
+    for (auto &metric : metrics) {
+        if (metric->hasPreparationPass()) {
+            metric->preparationFrame(view(srcFrame), view(pvsFrame), t);
+        }
+    }
+}
+
+void MultiMetric::finishPreparation() {
+    for (auto &metric : metrics) {
+        if (metric->hasPreparationPass()) {
+            metric->finishPreparation();
+        }
+    }
+}
+
+void MultiMetric::analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                                std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) {
+    int crop = spatialAlignmentCrop();
+    if (crop > 0) {
+        spatialAlignment->frameOffset(srcCurr, pvsCurr, crop, t);
+    }
+
+    for (auto &metric : metrics) {
+        metric->analysisFrame(view(srcCurr), view(pvsCurr), view(srcPrev), view(pvsPrev), t);
+    }
+}
+
+std::vector<double> MultiMetric::finishAnalysis() {
+    std::vector<double> values;
+    for (auto &metric : metrics) {
+        std::vector<double> metricValues = metric->finishAnalysis();
+        values.insert(values.end(), metricValues.begin(), metricValues.end());
+    }
+    return values;
+}
+
+std::vector<std::string> MultiMetric::valueNames() const {
+    std::vector<std::string> names;
+    for (auto &metric : metrics) {
+        std::vector<std::string> metricNames = metric->valueNames();
+        names.insert(names.end(), metricNames.begin(), metricNames.end());
+    }
+    return names;
+}
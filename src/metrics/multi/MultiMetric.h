@@ -0,0 +1,71 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MULTIMETRIC_H
+#define MULTIMETRIC_H
+
+#include <memory>
+#include <vector>
+
+#include "metrics/Algorithm.h"
+
+/* Decodes SRC and PVS once and fans every frame pair out to several full reference algorithms */
+class MultiMetric : public ParallelFullReferenceAlgorithm {
+public:
+    MultiMetric();
+
+    virtual void init(int argc, const char **argv) override;
+
+    void initAnalysis() override;
+
+    bool hasPreparationPass() const override;
+
+    void preparationFrame(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, unsigned t) override;
+
+    void finishPreparation() override;
+
+    void analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                       std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) override;
+
+    std::vector<double> finishAnalysis() override;
+
+    std::vector<std::string> valueNames() const override;
+
+    std::vector<double> frameValues(unsigned t) const override;
+
+    std::vector<std::string> frameValueNames() const override;
+
+    std::vector<double> poolingTerms(unsigned t) const override;
+
+    std::vector<double> windowValues(const std::vector<double> &termMeans) const override;
+
+    int spatialAlignmentCrop() const override;
+
+    std::size_t scratchBytesPerPixel() const override;
+
+    std::size_t perFrameBytes() const override;
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+private:
+    std::vector<std::string> metricNames;
+    std::vector<std::unique_ptr<FullReferenceAlgorithm> > metrics;
+};
+
+#endif //MULTIMETRIC_H
@@ -17,18 +17,16 @@
  */
 
 #include <boost/program_options/variables_map.hpp>
-#include <boost/program_options/parsers.hpp>
+#include <cmath>
 #include <fstream>
 #include <iomanip>
+#include <limits>
 
 #include <metrics/common/alignment/SpatialAlignment.h>
-#include <metrics/common/alignment/ColourAlignment.h>
+#include <io/ContentHash.h>
+#include <io/Trace.h>
 #include <io/VideoProperties.h>
 
-#include "analysis/LuminanceIndicator.h"
-#include "analysis/ChrominanceIndicator.h"
-#include "analysis/TemporalVariabilityIndicators.h"
-#include "score/DMOSMapper.h"
 #include "OPVQ.h"
 
 
@@ -36,19 +34,17 @@ OPVQ::OPVQ()
         : ParallelFullReferenceAlgorithm("OPVQ") {
     options.add_options()
             ("disable-spatial-alignment", "Disable spatial alignment")
-            ("disable-colour-correction", "Disable colour correction");
+            ("disable-colour-correction", "Disable colour correction")
+            ("feature-cache", opts::value<std::string>(&featureCacheDir),
+             "Directory of the SRC feature cache. A SRC found there is neither decoded nor analysed again")
+            ("feature-cache-size", opts::value<unsigned>(&featureCacheSize)->default_value(16384),
+             "Size limit of the SRC feature cache in MiB, least recently used entries are evicted");
+    neutralOptions.insert({"feature-cache", "feature-cache-size"});
     res.id = RES_UNSUPPORTED;
 }
 
-void OPVQ::init(int argc, const char **argv) {
-    ParallelFullReferenceAlgorithm::init(argc, argv);
-
-    opts::variables_map vm;
-    opts::parsed_options parsed = opts::command_line_parser(argc, argv).
-            options(options).
-            allow_unregistered().
-            run();
-    opts::store(parsed, vm);
+void OPVQ::configure(const opts::variables_map &vm) {
+    ParallelFullReferenceAlgorithm::configure(vm);
 
     enableSpatialAlignment = !static_cast<bool>(vm.count("disable-spatial-alignment"));
     enableColourCorrection = !static_cast<bool>(vm.count("disable-colour-correction"));
@@ -57,18 +53,46 @@ void OPVQ::init(int argc, const char **argv) {
 void OPVQ::validateInput(VideoInfo &srcInfo, VideoInfo &pvsInfo) {
     FullReferenceAlgorithm::validateInput(srcInfo, pvsInfo);
 
-    ResolutionID resolutionID = VideoProperties::identifyResolution(srcInfo.width, srcInfo.height);
-    for (auto resolutionData : supportedResolutions) {
-        if (resolutionData.id == resolutionID) {
-            res = resolutionData;
-        }
-    }
+    res = resolutionData(srcInfo);
     if (res.id == RES_UNSUPPORTED) {
         logger(WARN) << "Resolution is not supported, mapping to DMOS will not be accurate.";
         res = supportedResolutions.front();
     }
     croppedWidth = srcInfo.width - (2 * res.crop);
     croppedHeight = srcInfo.height - (2 * res.crop);
+
+    if (cachedSource && cachedSource->header().crop != res.crop) {
+        throw std::runtime_error("Cached SRC features were computed with a different crop");
+    }
+}
+
+OPVQ::ResolutionData OPVQ::resolutionData(const VideoInfo &info) {
+    ResolutionID resolutionID = VideoProperties::identifyResolution(info.width, info.height);
+    for (auto resolutionData : supportedResolutions) {
+        if (resolutionData.id == resolutionID) {
+            return resolutionData;
+        }
+    }
+    ResolutionData unsupported = supportedResolutions.front();
+    unsupported.id = RES_UNSUPPORTED;
+    return unsupported;
+}
+
+VideoInfo OPVQ::openSource() {
+    if (featureCacheDir.empty())
+        return FullReferenceAlgorithm::openSource();
+
+    SourceFeatureCache cache(featureCacheDir, static_cast<std::uint64_t>(featureCacheSize) << 20);
+    std::uint64_t contentHash = ContentHash::file(srcURL);
+    cachedSource = cache.lookup(contentHash, maxFrames);
+    if (cachedSource) {
+        logger(INFO) << "Using cached features of SRC " << srcURL;
+        return src.init(cachedSource, maxFrames);
+    }
+
+    VideoInfo info = FullReferenceAlgorithm::openSource();
+    cacheWriter = cache.create(contentHash, info, resolutionData(info).crop, maxFrames);
+    return info;
 }
 
 std::vector<OPVQ::ResolutionData> OPVQ::supportedResolutions = {
@@ -77,74 +101,222 @@ std::vector<OPVQ::ResolutionData> OPVQ::supportedResolutions = {
         {QCIF, 3,  DMOSMapper::QCIFcoeff}
 };
 
-int OPVQ::run() {
-    SpatialAlignment spatialAlignment;
-    std::vector<cv::Point2i> spatialOffset(sequenceLength, cv::Point2i(0, 0));
+int OPVQ::spatialAlignmentCrop() const {
+    return enableSpatialAlignment ? res.crop : 0;
+}
 
-    ColourAlignment srcColour(sequenceLength), pvsColour(sequenceLength);
-    std::vector<cv::Mat> correctionCurves;
+MemoryAccounting::Bytes OPVQ::memoryEstimateByCategory() const {
+    MemoryAccounting::Bytes bytes = ParallelFullReferenceAlgorithm::memoryEstimateByCategory();
+    /* The luminance and chrominance indicators' weights, one double per cropped pixel each for the whole run */
+    bytes[MemoryAccounting::SCRATCH] += 2 * sizeof(double) * static_cast<std::size_t>(croppedWidth) * croppedHeight;
+    if (cachedSource) {
+        bytes[MemoryAccounting::CACHE] = cachedSource->size();
+    }
+    return bytes;
+}
 
-    LuminanceIndicator luminanceIndicator(sequenceLength, croppedWidth, croppedHeight);
-    ChrominanceIndicator chrominanceIndicator(sequenceLength, croppedWidth, croppedHeight);
-    TemporalVariabilityIndicators temporalVariabilityIndicators(sequenceLength);
+std::size_t OPVQ::scratchBytesPerPixel() const {
+    /* SRC and PVS edginess images in doubles, the colour corrected current and previous PVS frame,
+     * both luma frame differences and the indicators' intermediate planes */
+    return 2 * 3 * sizeof(double) + 2 * 3 + 2 * sizeof(double) + 2 * sizeof(double);
+}
+
+std::size_t OPVQ::perFrameBytes() const {
+    /* SRC and PVS histograms as ColourAlignment keeps them, offsets and indicator values */
+    return 2 * 3 * (256 * sizeof(float) + sizeof(cv::Mat)) + sizeof(cv::Point2i) + 1 + 8 * sizeof(double);
+}
+
+void OPVQ::initAnalysis() {
+    srcColour = std::make_shared<ColourAlignment>(sequenceLength);
+    pvsColour.reset(new ColourAlignment(sequenceLength));
+    correctionCurves.clear();
+
+    luminanceIndicator.reset(new LuminanceIndicator(sequenceLength, croppedWidth, croppedHeight));
+    chrominanceIndicator.reset(new ChrominanceIndicator(sequenceLength, croppedWidth, croppedHeight));
+    temporalVariabilityIndicators.reset(new TemporalVariabilityIndicators(sequenceLength));
+}
 
-    /* Alignment and correction */
-    int passCount = 0;
-    if (enableSpatialAlignment || enableColourCorrection) {
-        logger(INFO) << "Pass " << ++passCount;
-        makePass([&](std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr, int tCurr) {
-            if (enableSpatialAlignment) {
-                spatialOffset[tCurr] = spatialAlignment.spatialOffsetDetermination(srcCurr, pvsCurr, res.crop);
-            }
-            spatialAlignment.cropAndAlign(srcCurr, pvsCurr, res.crop, spatialOffset[tCurr]);
+void OPVQ::shareSource(const OPVQ &owner) {
+    srcColour = owner.srcColour;
+}
 
-            if (enableColourCorrection) {
-                srcColour.analyzeFrame(srcCurr, tCurr);
-                pvsColour.analyzeFrame(pvsCurr, tCurr);
-            }
-        });
+void OPVQ::shareFeatureCache(const OPVQ &driver) {
+    cachedSource = driver.cachedSource;
+    cacheWriter = driver.cacheWriter;
+}
+
+cv::Point2i OPVQ::offset(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, unsigned t) {
+    if (enableSpatialAlignment) {
+        return spatialAlignment->frameOffset(srcFrame, pvsFrame, res.crop, t);
     }
+    return cv::Point2i(0, 0);
+}
 
-    /* If enabled, create colour correction curve from histograms */
+void OPVQ::cropSource(std::shared_ptr<Frame> srcFrame) const {
+    srcFrame->adjustROI(-res.crop, -res.crop, -res.crop, -res.crop);
+}
+
+/* Alignment and correction */
+bool OPVQ::hasPreparationPass() const {
+    return enableSpatialAlignment || enableColourCorrection;
+}
+
+void OPVQ::preparationFrame(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, unsigned t) {
+    sourcePreparationFrame(view(srcFrame), t);
+    renditionPreparationFrame(srcFrame, pvsFrame, t);
+}
+
+void OPVQ::sourcePreparationFrame(std::shared_ptr<Frame> srcFrame, unsigned t) {
     if (enableColourCorrection) {
-        srcColour.createCumulative(croppedWidth, croppedHeight);
-        pvsColour.createCumulative(croppedWidth, croppedHeight);
-        correctionCurves = ColourAlignment::createCorrectionCurves(srcColour, pvsColour);
-    }
-
-    /* Main analysis */
-    logger(INFO) << "Pass " << ++passCount;
-    makePassWithPrev([&](std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr, std::shared_ptr<Frame> srcPrev,
-                         std::shared_ptr<Frame> pvsPrev, int tCurr) {
-        spatialAlignment.cropAndAlign(srcCurr, pvsCurr, res.crop, spatialOffset[tCurr]);
-        if (enableColourCorrection) {
-            //applying correction curve to pvsraded signal.
-            ColourAlignment::applyCorrectionCurve(pvsCurr, correctionCurves);
+        if (cachedSource) {
+            srcColour->setFrameHistograms(t, cachedSource->histograms(t));
+            return;
         }
+        TraceSpan span("source histograms", t);
+        cropSource(srcFrame);
+        srcColour->analyzeFrame(srcFrame, t);
+    }
+}
 
-        std::shared_ptr<Frame> srcEdge = EdginessImage::createEdginessImage(srcCurr);
-        std::shared_ptr<Frame> pvsEdge = EdginessImage::createEdginessImage(pvsCurr);
+void OPVQ::renditionPreparationFrame(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, unsigned t) {
+    cv::Point2i pvsOffset = offset(srcFrame, pvsFrame, t);
+    if (enableColourCorrection) {
+        TraceSpan span("rendition histograms", t);
+        spatialAlignment->cropAndAlign(srcFrame, pvsFrame, res.crop, pvsOffset);
+        pvsColour->analyzeFrame(pvsFrame, t);
+    }
+}
 
-        luminanceIndicator.analyzeFrame(srcCurr, pvsCurr, srcEdge, pvsEdge, tCurr);
-        chrominanceIndicator.analyzeFrame(srcCurr, pvsCurr, srcEdge, pvsEdge, tCurr);
+/* If enabled, create colour correction curve from histograms */
+void OPVQ::finishPreparation() {
+    if (enableColourCorrection) {
+        srcColour->createCumulative(croppedWidth, croppedHeight);
+        pvsColour->createCumulative(croppedWidth, croppedHeight);
+        correctionCurves = ColourAlignment::createCorrectionCurves(*srcColour, *pvsColour);
+    }
+}
 
-        if (tCurr > 0) {
-            assert(srcPrev);
-            assert(pvsPrev);
-            temporalVariabilityIndicators.analyzeFrame(srcCurr, pvsCurr, srcPrev, pvsPrev, tCurr);
-        }
-    });
+std::shared_ptr<Frame> OPVQ::alignAndCorrect(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame,
+                                             unsigned t) {
+    TraceSpan span("align and correct", t);
+    spatialAlignment->cropAndAlign(view(srcFrame), pvsFrame, res.crop, offset(srcFrame, pvsFrame, t));
+
+    if (enableColourCorrection) {
+        //applying correction curve to pvsraded signal, the decoded pixels are shared and stay untouched
+        return ColourAlignment::createCorrectedFrame(pvsFrame, correctionCurves);
+    }
+    return pvsFrame;
+}
+
+std::shared_ptr<OPVQ::SourceFeatures> OPVQ::sourceFeatures(std::shared_ptr<Frame> srcCurr,
+                                                           std::shared_ptr<Frame> srcPrev, unsigned t) const {
+    TraceSpan span("source features", t);
+    std::shared_ptr<SourceFeatures> source = std::make_shared<SourceFeatures>();
+    source->frame = view(srcCurr);
+    cropSource(source->frame);
+    if (cachedSource) {
+        source->edge = cachedSource->edge(t);
+        source->temporalDifference = cachedSource->temporalDifference(t);
+        return source;
+    }
+
+    source->edge = EdginessImage::createEdginessImage(source->frame);
+    if (srcPrev) {
+        std::shared_ptr<Frame> prev = view(srcPrev);
+        cropSource(prev);
+        source->temporalDifference = TemporalVariabilityIndicators::frameDifference(source->frame, prev);
+    }
+
+    if (cacheWriter) {
+        cacheWriter->store(t, *srcCurr, *source->edge, source->temporalDifference);
+    }
+    return source;
+}
+
+/* Main analysis */
+void OPVQ::analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                         std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) {
+    renditionAnalysisFrame(*sourceFeatures(srcCurr, srcPrev, t), srcCurr, pvsCurr, srcPrev, pvsPrev, t);
+}
+
+void OPVQ::renditionAnalysisFrame(const SourceFeatures &source, std::shared_ptr<Frame> srcCurr,
+                                  std::shared_ptr<Frame> pvsCurr, std::shared_ptr<Frame> srcPrev,
+                                  std::shared_ptr<Frame> pvsPrev, unsigned t) {
+    pvsCurr = alignAndCorrect(srcCurr, pvsCurr, t);
+    std::shared_ptr<Frame> pvsEdge;
+    {
+        TraceSpan span("edginess", t);
+        pvsEdge = EdginessImage::createEdginessImage(pvsCurr);
+    }
 
-    /* Retrieve indicator values and map to score */
+    {
+        TraceSpan span("luminance indicator", t);
+        luminanceIndicator->analyzeFrame(source.frame, pvsCurr, source.edge, pvsEdge, t);
+    }
+    {
+        TraceSpan span("chrominance indicator", t);
+        chrominanceIndicator->analyzeFrame(source.frame, pvsCurr, source.edge, pvsEdge, t);
+    }
+
+    if (t > 0) {
+        assert(srcPrev);
+        assert(pvsPrev);
+        pvsPrev = alignAndCorrect(srcPrev, pvsPrev, t - 1);
+        TraceSpan span("temporal indicators", t);
+        temporalVariabilityIndicators->analyzeFrame(source.temporalDifference,
+                                                    TemporalVariabilityIndicators::frameDifference(pvsCurr, pvsPrev), t);
+    }
+}
+
+/* Retrieve indicator values and map to score */
+std::vector<double> OPVQ::finishAnalysis() {
     std::vector<double> indicators(NUM_IND);
-    indicators[LUMA_IND] = luminanceIndicator.getLuminanceIndicator();
-    indicators[CHROMA_IND] = chrominanceIndicator.getChrominanceIndicator();
-    indicators[INTRO_IND] = temporalVariabilityIndicators.getIntroducedComponentIndicator();
-    indicators[OMIT_IND] = temporalVariabilityIndicators.getOmittedComponentIndicator();
-    writeCSV(pvsURL, indicators);
+    indicators[LUMA_IND] = luminanceIndicator->getLuminanceIndicator();
+    indicators[CHROMA_IND] = chrominanceIndicator->getChrominanceIndicator();
+    indicators[INTRO_IND] = temporalVariabilityIndicators->getIntroducedComponentIndicator();
+    indicators[OMIT_IND] = temporalVariabilityIndicators->getOmittedComponentIndicator();
 
     double aggregateScore = DMOSMapper::calculateAggregateScore(indicators, res.coeff);
     logger(INFO) << "Aggregated final score: " << aggregateScore;
 
-    return 0;
-}
\ No newline at end of file
+    if (cacheWriter) {
+        cacheWriter->commit();
+        cacheWriter.reset();
+    }
+
+    indicators.push_back(aggregateScore);
+    return indicators;
+}
+
+std::vector<std::string> OPVQ::valueNames() const {
+    return {"opvq_luma", "opvq_chroma", "opvq_introduced", "opvq_omitted", "opvq_dmos"};
+}
+
+std::vector<double> OPVQ::frameValues(unsigned t) const {
+    return {luminanceIndicator->frameValue(t), chrominanceIndicator->frameValue(t),
+            temporalVariabilityIndicators->frameIntroduced(t), temporalVariabilityIndicators->frameOmitted(t)};
+}
+
+std::vector<std::string> OPVQ::frameValueNames() const {
+    return {"opvq_luma", "opvq_chroma", "opvq_introduced", "opvq_omitted"};
+}
+
+/* The introduced component is L2 pooled, so windows keep the mean of its squares */
+std::vector<double> OPVQ::poolingTerms(unsigned t) const {
+    std::vector<double> terms(NUM_IND, std::numeric_limits<double>::quiet_NaN());
+    terms[LUMA_IND] = luminanceIndicator->frameValue(t);
+    terms[CHROMA_IND] = chrominanceIndicator->frameValue(t);
+    if (t > 0) {
+        double introduced = temporalVariabilityIndicators->frameIntroduced(t);
+        terms[INTRO_IND] = introduced * introduced;
+        terms[OMIT_IND] = temporalVariabilityIndicators->frameOmitted(t);
+    }
+    return terms;
+}
+
+std::vector<double> OPVQ::windowValues(const std::vector<double> &termMeans) const {
+    std::vector<double> indicators(termMeans);
+    indicators[INTRO_IND] = std::sqrt(termMeans[INTRO_IND]);
+    indicators.push_back(DMOSMapper::score(indicators, res.coeff));
+    return indicators;
+}
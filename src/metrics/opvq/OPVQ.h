@@ -22,6 +22,13 @@
 #include <metrics/Algorithm.h>
 #include <io/VideoProperties.h>
 
+#include <metrics/common/alignment/ColourAlignment.h>
+
+#include "cache/SourceFeatureCache.h"
+
+#include "analysis/LuminanceIndicator.h"
+#include "analysis/ChrominanceIndicator.h"
+#include "analysis/TemporalVariabilityIndicators.h"
 #include "score/DMOSMapper.h"
 
 class OPVQ : public ParallelFullReferenceAlgorithm {
@@ -33,11 +40,76 @@ public:
         MappingCoefficients coeff;
     };
 
+    /* SRC side of one frame, independent of the PVS it is compared with */
+    struct SourceFeatures {
+        std::shared_ptr<Frame> frame;
+        std::shared_ptr<Frame> edge;
+        cv::Mat temporalDifference; // Empty for the first frame
+    };
+
     OPVQ();
 
-    virtual void init(int argc, const char **argv) override;
+    /* Supported resolution matching info, id is RES_UNSUPPORTED and the rest the VGA data if there is none */
+    static ResolutionData resolutionData(const VideoInfo &info);
+
+    void initAnalysis() override;
+
+    bool hasPreparationPass() const override;
+
+    void preparationFrame(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, unsigned t) override;
+
+    void finishPreparation() override;
+
+    void analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                       std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) override;
+
+    std::vector<double> finishAnalysis() override;
+
+    std::vector<std::string> valueNames() const override;
+
+    std::vector<double> frameValues(unsigned t) const override;
+
+    std::vector<std::string> frameValueNames() const override;
+
+    std::vector<double> poolingTerms(unsigned t) const override;
+
+    std::vector<double> windowValues(const std::vector<double> &termMeans) const override;
+
+    int spatialAlignmentCrop() const override;
+
+    MemoryAccounting::Bytes memoryEstimateByCategory() const override;
 
-    int run() override;
+    std::size_t scratchBytesPerPixel() const override;
+
+    std::size_t perFrameBytes() const override;
+
+    /*
+     * The per-frame steps split into their SRC and PVS halves, so one SRC can be compared against
+     * several renditions while its features are computed once. Renditions use the SRC histograms of
+     * the instance given to shareSource(); frames passed in must be uncropped.
+     */
+    void shareSource(const OPVQ &owner);
+
+    /* Takes over the SRC feature cache entry of the instance that opened SRC */
+    void shareFeatureCache(const OPVQ &driver);
+
+    void sourcePreparationFrame(std::shared_ptr<Frame> srcFrame, unsigned t);
+
+    void renditionPreparationFrame(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, unsigned t);
+
+    std::shared_ptr<SourceFeatures> sourceFeatures(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> srcPrev,
+                                                   unsigned t) const;
+
+    void renditionAnalysisFrame(const SourceFeatures &source, std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                                std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t);
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+    virtual void validateInput(VideoInfo &srcInfo, VideoInfo &pvsInfo) override;
+
+    /* With --feature-cache, SRC is read from the cache if it is there and added to it otherwise */
+    virtual VideoInfo openSource() override;
 
 private:
     static std::vector<ResolutionData> supportedResolutions;
@@ -47,8 +119,25 @@ private:
     ResolutionData res;
     int croppedWidth;
     int croppedHeight;
+    std::string featureCacheDir;
+    unsigned featureCacheSize;
 
-    virtual void validateInput(VideoInfo &srcInfo, VideoInfo &pvsInfo) override;
+    std::shared_ptr<SourceFeatureCache::Entry> cachedSource;
+    std::shared_ptr<SourceFeatureCache::Writer> cacheWriter;
+
+    std::shared_ptr<ColourAlignment> srcColour;
+    std::unique_ptr<ColourAlignment> pvsColour;
+    std::vector<cv::Mat> correctionCurves;
+    std::unique_ptr<LuminanceIndicator> luminanceIndicator;
+    std::unique_ptr<ChrominanceIndicator> chrominanceIndicator;
+    std::unique_ptr<TemporalVariabilityIndicators> temporalVariabilityIndicators;
+
+    cv::Point2i offset(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, unsigned t);
+
+    /* Crops and aligns the PVS the way the preparation pass did, and colour corrects it */
+    std::shared_ptr<Frame> alignAndCorrect(std::shared_ptr<Frame> srcFrame, std::shared_ptr<Frame> pvsFrame, unsigned t);
+
+    void cropSource(std::shared_ptr<Frame> srcFrame) const;
 };
 
 #endif //__OPVQ_H
\ No newline at end of file
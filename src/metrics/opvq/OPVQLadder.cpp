@@ -0,0 +1,183 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#include "OPVQLadder.h"
+
+
+OPVQLadder::OPVQLadder() {
+    multiplePvs = true;
+}
+
+void OPVQLadder::init(int argc, const char **argv) {
+    FullReferenceAlgorithm::init(argc, argv);
+    if (pvsURLs.empty())
+        return;
+
+    /* The first rendition is decoded by the inherited PVS sequence */
+    renditionSequences.clear();
+    for (unsigned i = 1; i < pvsURLs.size(); i++) {
+        std::unique_ptr<VideoSequence> sequence(new VideoSequence());
+        VideoInfo info = sequence->init(pvsURLs[i], maxFrames, pixelFormat);
+        logVideoInfo(info, "PVS");
+        validateInput(srcInfo, info);
+        renditionSequences.push_back(std::move(sequence));
+    }
+
+    renditions.clear();
+    for (unsigned i = 0; i < pvsURLs.size(); i++) {
+        std::unique_ptr<OPVQ> rendition(new OPVQ());
+        rendition->parseOptions(argc, argv);
+        rendition->attach(*this, i);
+        renditions.push_back(std::move(rendition));
+    }
+    renditions.front()->shareFeatureCache(*this);
+}
+
+MemoryAccounting::Bytes OPVQLadder::memoryEstimateByCategory() const {
+    MemoryAccounting::Bytes bytes = OPVQ::memoryEstimateByCategory();
+    const std::size_t pvsCount = renditionSequences.size() + 1;
+    bytes[MemoryAccounting::FRAMES] = bytes[MemoryAccounting::FRAMES] * (pvsCount + 1) / 2;
+    bytes[MemoryAccounting::SCRATCH] *= pvsCount;
+    bytes[MemoryAccounting::PER_FRAME] *= pvsCount;
+    return bytes;
+}
+
+int OPVQLadder::run() {
+    writeStoredResults();
+    if (pvsURLs.empty())
+        return 0;
+
+    for (auto &rendition : renditions) {
+        rendition->initAnalysis();
+    }
+    OPVQ &owner = *renditions.front();
+    for (auto &rendition : renditions) {
+        rendition->shareSource(owner);
+    }
+
+    int passCount = 0;
+    if (owner.hasPreparationPass()) {
+        logger(INFO) << "Pass " << ++passCount;
+        makeLadderPass([&](std::shared_ptr<Frame> srcCurr, const std::vector<std::shared_ptr<Frame> > &pvsCurr,
+                           std::shared_ptr<Frame> srcPrev, const std::vector<std::shared_ptr<Frame> > &pvsPrev,
+                           unsigned tCurr) {
+            owner.sourcePreparationFrame(view(srcCurr), tCurr);
+            for (unsigned i = 0; i < renditions.size(); i++) {
+                renditions[i]->renditionPreparationFrame(view(srcCurr), view(pvsCurr[i]), tCurr);
+            }
+        });
+        for (auto &rendition : renditions) {
+            rendition->finishPreparation();
+        }
+    }
+
+    std::vector<std::unique_ptr<FrameTableWriter> > frameTables;
+    std::vector<std::unique_ptr<FramePooling> > framePoolings;
+    for (unsigned i = 0; i < renditions.size(); i++) {
+        frameTables.push_back(openFrameTable(pvsURLs[i], *renditions[i]));
+        framePoolings.push_back(openFramePooling(*renditions[i]));
+    }
+
+    logger(INFO) << "Pass " << ++passCount;
+    makeLadderPass([&](std::shared_ptr<Frame> srcCurr, const std::vector<std::shared_ptr<Frame> > &pvsCurr,
+                       std::shared_ptr<Frame> srcPrev, const std::vector<std::shared_ptr<Frame> > &pvsPrev,
+                       unsigned tCurr) {
+        std::shared_ptr<SourceFeatures> source = owner.sourceFeatures(srcCurr, srcPrev, tCurr);
+        for (unsigned i = 0; i < renditions.size(); i++) {
+            renditions[i]->renditionAnalysisFrame(*source, view(srcCurr), view(pvsCurr[i]), view(srcPrev),
+                                                  pvsPrev.empty() ? nullptr : view(pvsPrev[i]), tCurr);
+            if (frameTables[i]) {
+                frameTables[i]->add(tCurr, renditions[i]->frameRow(tCurr));
+            }
+            if (framePoolings[i]) {
+                framePoolings[i]->add(renditions[i]->frameValues(tCurr));
+            }
+        }
+    });
+
+    for (unsigned i = 0; i < renditions.size(); i++) {
+        logger(INFO) << "Rendition " << pvsURLs[i];
+        std::vector<double> values = renditions[i]->finishAnalysis();
+        std::vector<std::string> names = renditions[i]->valueNames();
+        if (frameTables[i]) {
+            frameTables[i]->close();
+        }
+        if (framePoolings[i]) {
+            framePoolings[i]->append(names, values);
+        }
+        std::vector<std::vector<double> > frames;
+        for (unsigned t = 0; t < renditions[i]->length(); t++) {
+            frames.push_back(renditions[i]->frameValues(t));
+        }
+        writeResult(pvsURLs[i], names, values, renditions[i]->frameValueNames(), frames);
+        writeWindows(pvsURLs[i], *renditions[i]);
+        storeResult(pvsURLs[i], names, values);
+    }
+    return 0;
+}
+
+void OPVQLadder::makeLadderPass(LadderFunction body) {
+    src.rewind();
+    pvs.rewind();
+    for (auto &sequence : renditionSequences) {
+        sequence->rewind();
+    }
+
+    std::unique_ptr<PassWorkers> workers;
+    if (jFactor > 1) {
+        workers.reset(new PassWorkers(jFactor));
+    }
+
+    std::shared_ptr<Frame> srcCurr, srcPrev;
+    std::vector<std::shared_ptr<Frame> > pvsCurr, pvsPrev;
+    unsigned int t = 0;
+    Logger::initProgress();
+    while (t < sequenceLength) {
+        srcCurr = src.nextFrame();
+        pvsCurr.assign(1, pvs.nextFrame());
+        for (auto &sequence : renditionSequences) {
+            pvsCurr.push_back(sequence->nextFrame());
+        }
+        if (!srcCurr)
+            break;
+        assert(std::all_of(pvsCurr.begin(), pvsCurr.end(), [](const std::shared_ptr<Frame> &f) { return !!f; }));
+
+        /* Frames are captured by value, the job may run after the next frames have been decoded */
+        std::function<void()> task = [=]() {
+            body(srcCurr, pvsCurr, srcPrev, pvsPrev, t);
+        };
+        if (workers) {
+            workers->push(std::make_shared<TaskJob>(task));
+        } else {
+            task();
+        }
+
+        srcPrev = srcCurr;
+        pvsPrev = pvsCurr;
+        t++;
+        Logger::logProgress(t, sequenceLength);
+    }
+    if (workers) {
+        workers->finish();
+    }
+    Logger::resetProgress();
+}
@@ -0,0 +1,50 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __OPVQLADDER_H
+#define __OPVQLADDER_H
+
+#include "OPVQ.h"
+
+/* OPVQ of several renditions against one SRC. SRC is decoded once per pass and its features are
+ * computed once per frame, then every rendition of that frame is analysed in the same job. */
+class OPVQLadder : public OPVQ {
+public:
+    OPVQLadder();
+
+    virtual void init(int argc, const char **argv) override;
+
+    int run() override;
+
+    /* Every PVS frame in flight comes with one frame of each further rendition, analysed in the same job */
+    MemoryAccounting::Bytes memoryEstimateByCategory() const override;
+
+private:
+    typedef std::function<void(std::shared_ptr<Frame> srcCurr,
+                               const std::vector<std::shared_ptr<Frame> > &pvsCurr,
+                               std::shared_ptr<Frame> srcPrev,
+                               const std::vector<std::shared_ptr<Frame> > &pvsPrev,
+                               unsigned tCurr)> LadderFunction;
+
+    std::vector<std::unique_ptr<VideoSequence> > renditionSequences;
+    std::vector<std::unique_ptr<OPVQ> > renditions;
+
+    void makeLadderPass(LadderFunction body);
+};
+
+#endif //__OPVQLADDER_H
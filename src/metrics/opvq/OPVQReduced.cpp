@@ -0,0 +1,139 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <metrics/common/alignment/ColourAlignment.h>
+
+#include "analysis/EdginessImage.h"
+#include "analysis/TemporalVariabilityIndicators.h"
+#include "signature/ReducedReferenceIndicators.h"
+#include "OPVQReduced.h"
+
+
+OPVQReduced::OPVQReduced()
+        : Algorithm("OPVQ-RR") {
+    options.add_options()
+            ("signature,r", opts::value<std::string>(&signatureURL)->required(),
+             "Path to the SRC signature written by opvq-signature (required)")
+            ("pvs,p", opts::value<std::string>(&pvsURL)->required(), "Path to processed video sequence (required)")
+            ("disable-colour-correction", "Disable colour correction");
+}
+
+void OPVQReduced::configure(const opts::variables_map &vm) {
+    Algorithm::configure(vm);
+
+    enableColourCorrection = !static_cast<bool>(vm.count("disable-colour-correction"));
+}
+
+void OPVQReduced::init(int argc, const char **argv) {
+    parseOptions(argc, argv);
+
+    signature.reset(new ReferenceSignature(signatureURL));
+    pvsInfo = pvs.init(pvsURL, maxFrames, pixelFormat);
+    logger(INFO) << "PVS is " << pvsInfo.filename;
+
+    VideoInfo srcInfo = signature->videoInfo();
+    srcInfo.frame_count = std::min(srcInfo.frame_count, maxFrames);
+    pvsInfo.frame_count = std::min(pvsInfo.frame_count, maxFrames);
+    if (srcInfo.width != pvsInfo.width || srcInfo.height != pvsInfo.height
+        || srcInfo.avg_framerate != pvsInfo.avg_framerate
+        || srcInfo.frame_count != pvsInfo.frame_count) {
+        throw std::runtime_error("Signature and PVS dimensions don't match.");
+    }
+
+    res = OPVQ::resolutionData(pvsInfo);
+    if (res.id == RES_UNSUPPORTED) {
+        logger(WARN) << "Resolution is not supported, mapping to DMOS will not be accurate.";
+    }
+    if (res.crop != signature->crop()) {
+        throw std::runtime_error("Signature was computed with a different crop");
+    }
+    croppedWidth = pvsInfo.width - 2 * res.crop;
+    croppedHeight = pvsInfo.height - 2 * res.crop;
+}
+
+std::shared_ptr<Frame> OPVQReduced::cropped(std::shared_ptr<Frame> frame) const {
+    frame = FullReferenceAlgorithm::view(frame);
+    frame->adjustROI(-res.crop, -res.crop, -res.crop, -res.crop);
+    return frame;
+}
+
+/* Spatial alignment needs SRC pixels, PVS is compared with the SRC as it is */
+int OPVQReduced::run() {
+    unsigned sequenceLength = static_cast<unsigned>(pvsInfo.frame_count);
+    int passCount = 0;
+
+    /* The correction curves only depend on the histograms summed over the sequence, so they are
+     * the same as with the full reference */
+    std::vector<cv::Mat> correctionCurves;
+    if (enableColourCorrection) {
+        logger(INFO) << "Pass " << ++passCount;
+        ColourAlignment srcColour(1), pvsColour(sequenceLength);
+        srcColour.setFrameHistograms(0, signature->histograms());
+
+        pvs.rewind();
+        Logger::initProgress();
+        for (unsigned t = 0; t < sequenceLength; t++) {
+            std::shared_ptr<Frame> frame = pvs.nextFrame();
+            if (!frame)
+                break;
+            pvsColour.analyzeFrame(cropped(frame), t);
+            Logger::logProgress(t + 1, sequenceLength);
+        }
+        Logger::resetProgress();
+
+        srcColour.createCumulative(croppedWidth, croppedHeight);
+        pvsColour.createCumulative(croppedWidth, croppedHeight);
+        correctionCurves = ColourAlignment::createCorrectionCurves(srcColour, pvsColour);
+    }
+
+    logger(INFO) << "Pass " << ++passCount;
+    ReducedReferenceIndicators indicators(sequenceLength, croppedWidth, croppedHeight, signature->blockSize());
+    std::shared_ptr<Frame> prev;
+    pvs.rewind();
+    Logger::initProgress();
+    for (unsigned t = 0; t < sequenceLength; t++) {
+        std::shared_ptr<Frame> curr = pvs.nextFrame();
+        if (!curr)
+            break;
+        curr = cropped(curr);
+        if (enableColourCorrection) {
+            curr = ColourAlignment::createCorrectedFrame(curr, correctionCurves);
+        }
+
+        std::shared_ptr<Frame> edge = EdginessImage::createEdginessImage(curr);
+        cv::Mat difference;
+        if (prev) {
+            difference = TemporalVariabilityIndicators::frameDifference(curr, prev);
+        }
+        indicators.analyzeFrame(signature->frameStatistics(t),
+                                ReferenceSignature::blockStatistics(*curr, *edge, difference, signature->blockSize()), t);
+
+        prev = curr;
+        Logger::logProgress(t + 1, sequenceLength);
+    }
+    Logger::resetProgress();
+
+    std::vector<double> values = indicators.getIndicators();
+    double aggregateScore = DMOSMapper::calculateAggregateScore(values, res.coeff);
+    logger(INFO) << "Aggregated final score (reduced reference): " << aggregateScore;
+    values.push_back(aggregateScore);
+
+    writeResult(pvsURL, {"opvq_rr_luma", "opvq_rr_chroma", "opvq_rr_introduced", "opvq_rr_omitted", "opvq_rr_dmos"},
+              values);
+    return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __OPVQREDUCED_H
+#define __OPVQREDUCED_H
+
+#include <metrics/Algorithm.h>
+
+#include "signature/ReferenceSignature.h"
+#include "OPVQ.h"
+
+/* OPVQ of a PVS against the ReferenceSignature of its SRC instead of the SRC itself */
+class OPVQReduced : public Algorithm {
+public:
+    OPVQReduced();
+
+    virtual void init(int argc, const char **argv) override;
+
+    int run() override;
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+private:
+    std::string signatureURL;
+    std::string pvsURL;
+    bool enableColourCorrection;
+    std::unique_ptr<ReferenceSignature> signature;
+    VideoSequence pvs;
+    VideoInfo pvsInfo;
+    OPVQ::ResolutionData res;
+    int croppedWidth;
+    int croppedHeight;
+
+    std::shared_ptr<Frame> cropped(std::shared_ptr<Frame> frame) const;
+};
+
+#endif //__OPVQREDUCED_H
@@ -0,0 +1,92 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <metrics/common/alignment/ColourAlignment.h>
+
+#include "analysis/EdginessImage.h"
+#include "analysis/TemporalVariabilityIndicators.h"
+#include "signature/ReferenceSignature.h"
+#include "OPVQ.h"
+#include "OPVQSignature.h"
+
+
+OPVQSignature::OPVQSignature()
+        : Algorithm("OPVQ-Signature") {
+    options.add_options()
+            ("src,s", opts::value<std::string>(&srcURL)->required(), "Path to source video sequence (required)")
+            ("output,o", opts::value<std::string>(&signatureURL)->required(), "Path of the signature file (required)")
+            ("block-size", opts::value<int>(&blockSize)->default_value(16),
+             "Side of the square blocks the SRC statistics are pooled over");
+}
+
+void OPVQSignature::configure(const opts::variables_map &vm) {
+    Algorithm::configure(vm);
+
+    if (blockSize <= 0) {
+        throw std::runtime_error("Block size must be positive");
+    }
+}
+
+void OPVQSignature::init(int argc, const char **argv) {
+    parseOptions(argc, argv);
+
+    srcInfo = src.init(srcURL, maxFrames, pixelFormat);
+    srcInfo.frame_count = std::min(srcInfo.frame_count, maxFrames);
+    logger(INFO) << "SRC is " << srcInfo.filename;
+
+    OPVQ::ResolutionData res = OPVQ::resolutionData(srcInfo);
+    if (res.id == RES_UNSUPPORTED) {
+        logger(WARN) << "Resolution is not supported, mapping to DMOS will not be accurate.";
+    }
+    crop = res.crop;
+}
+
+int OPVQSignature::run() {
+    ReferenceSignature signature(srcInfo, crop, blockSize);
+
+    std::shared_ptr<Frame> prev;
+    Logger::initProgress();
+    for (int t = 0; t < srcInfo.frame_count; t++) {
+        std::shared_ptr<Frame> curr = src.nextFrame();
+        if (!curr)
+            break;
+        curr = FullReferenceAlgorithm::view(curr);
+        curr->adjustROI(-crop, -crop, -crop, -crop);
+
+        std::shared_ptr<Frame> edge = EdginessImage::createEdginessImage(curr);
+        cv::Mat difference;
+        if (prev) {
+            difference = TemporalVariabilityIndicators::frameDifference(curr, prev);
+        }
+        signature.addFrame(ReferenceSignature::blockStatistics(*curr, *edge, difference, blockSize),
+                           ColourAlignment::frameHistograms(*curr));
+
+        prev = curr;
+        Logger::logProgress(t + 1, srcInfo.frame_count);
+    }
+    Logger::resetProgress();
+
+    try {
+        signature.write(signatureURL);
+    } catch (std::runtime_error &e) {
+        logger(ERROR) << e.what();
+        return 1;
+    }
+    logger(INFO) << "Wrote signature of " << signature.frameCount() << " frames to " << signatureURL;
+    return 0;
+}
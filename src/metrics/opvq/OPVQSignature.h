@@ -0,0 +1,45 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __OPVQSIGNATURE_H
+#define __OPVQSIGNATURE_H
+
+#include <metrics/Algorithm.h>
+
+/* Reduces a SRC to the ReferenceSignature opvq-rr scores PVS against */
+class OPVQSignature : public Algorithm {
+public:
+    OPVQSignature();
+
+    virtual void init(int argc, const char **argv) override;
+
+    int run() override;
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+private:
+    std::string srcURL;
+    std::string signatureURL;
+    int blockSize;
+    VideoSequence src;
+    VideoInfo srcInfo;
+    int crop;
+};
+
+#endif //__OPVQSIGNATURE_H
@@ -23,8 +23,9 @@
 
 Logger ChrominanceIndicator::logger = Logger("ChrominanceIndicator");
 
-ChrominanceIndicator::ChrominanceIndicator(unsigned int sequenceLength, int width, int height) : eCbValues(
-        sequenceLength), eCrValues(sequenceLength) {
+ChrominanceIndicator::ChrominanceIndicator(unsigned int sequenceLength, int width, int height)
+        : weightBytes(MemoryAccounting::SCRATCH, static_cast<std::size_t>(width) * height * sizeof(double)),
+          eCbValues(sequenceLength), eCrValues(sequenceLength) {
     wij = cv::Mat(height, width, CV_64FC1);
     wijSum = 0;
     for (int x = 0; x < width; x++) {
@@ -37,6 +38,10 @@ ChrominanceIndicator::ChrominanceIndicator(unsigned int sequenceLength, int widt
     }
 }
 
+double ChrominanceIndicator::frameValue(unsigned t) const {
+    return 0.5 * (eCbValues[t] + eCrValues[t]);
+}
+
 double ChrominanceIndicator::getChrominanceIndicator() {
     double accumSum = 0.0;
     for (unsigned t = 0; t < eCbValues.size(); t++) {
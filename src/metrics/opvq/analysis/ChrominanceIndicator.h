@@ -21,6 +21,7 @@
 
 #include <memory>
 #include <io/Logger.h>
+#include <io/MemoryAccounting.h>
 #include <io/Frame.h>
 #include "EdginessImage.h"
 
@@ -34,12 +35,17 @@ public:
 
     double getChrominanceIndicator();
 
+    /* Contribution of frame t, the indicator is their mean */
+    double frameValue(unsigned t) const;
+
 
 private:
     static Logger logger;
 
+    /* Kept for the whole run, OPVQ::memoryEstimateByCategory() counts it */
     cv::Mat wij;
     double wijSum;
+    MemoryAccounting::Allocation weightBytes;
 
     std::vector<double> eCbValues;
     std::vector<double> eCrValues;
@@ -35,6 +35,7 @@ std::shared_ptr<Frame> EdginessImage::createEdginessImage(std::shared_ptr<Frame>
 	RunFilter(inputFrame->Y, retFrame->Y, Kh, Kv);
 	RunFilter(inputFrame->U, retFrame->U, Kh, Kv);
 	RunFilter(inputFrame->V, retFrame->V, Kh, Kv);
+	retFrame->account(MemoryAccounting::SCRATCH);
 
 	return retFrame;
 }
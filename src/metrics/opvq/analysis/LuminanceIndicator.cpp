@@ -22,7 +22,8 @@
 Logger LuminanceIndicator::logger = Logger("LuminanceIndicator");
 
 LuminanceIndicator::LuminanceIndicator(unsigned int sequenceLength, int width, int height)
-        : weightedL5NormValues(sequenceLength) {
+        : weightBytes(MemoryAccounting::SCRATCH, static_cast<std::size_t>(width) * height * sizeof(double)),
+          weightedL5NormValues(sequenceLength) {
     wij = cv::Mat(height, width, CV_64FC1);
     wijSum = 0;
     for (int x = 0; x < width; x++) {
@@ -78,6 +79,10 @@ void LuminanceIndicator::analyzeFrame(std::shared_ptr<const Frame> srcCurr, std:
     weightedL5NormValues[t] = cv::pow(finalSum / wijSum, 0.2);
 }
 
+double LuminanceIndicator::frameValue(unsigned t) const {
+    return weightedL5NormValues[t];
+}
+
 double LuminanceIndicator::getLuminanceIndicator() {
     double accumSum = std::accumulate(weightedL5NormValues.begin(), weightedL5NormValues.end(), 0.0);
     return (1.0 / static_cast<double>(weightedL5NormValues.size())) * accumSum;
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include <io/Logger.h>
+#include <io/MemoryAccounting.h>
 #include "EdginessImage.h"
 
 class LuminanceIndicator {
@@ -35,11 +36,16 @@ public:
 
     double getLuminanceIndicator();
 
+    /* Contribution of frame t, the indicator is their mean */
+    double frameValue(unsigned t) const;
+
 private:
     static Logger logger;
 
+    /* Kept for the whole run, OPVQ::memoryEstimateByCategory() counts it */
     cv::Mat wij;
     double wijSum;
+    MemoryAccounting::Allocation weightBytes;
 
     std::vector<double> weightedL5NormValues;
 };
@@ -16,6 +16,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <limits>
 #include <opencv2/opencv.hpp>
 
 #include "TemporalVariabilityIndicators.h"
@@ -31,9 +32,17 @@ void TemporalVariabilityIndicators::analyzeFrame(std::shared_ptr<const Frame> sr
                                                  std::shared_ptr<const Frame> pvsCurr,
                                                  std::shared_ptr<const Frame> srcPrev,
                                                  std::shared_ptr<const Frame> pvsPrev, int t) {
-    cv::Mat saDiff, paDiff;
-    cv::Mat(cv::abs(srcCurr->Y - srcPrev->Y)).convertTo(saDiff, CV_64F);
-    cv::Mat(cv::abs(pvsCurr->Y - pvsPrev->Y)).convertTo(paDiff, CV_64F);
+    analyzeFrame(frameDifference(srcCurr, srcPrev), frameDifference(pvsCurr, pvsPrev), t);
+}
+
+cv::Mat TemporalVariabilityIndicators::frameDifference(std::shared_ptr<const Frame> curr,
+                                                       std::shared_ptr<const Frame> prev) {
+    cv::Mat diff;
+    cv::Mat(cv::abs(curr->Y - prev->Y)).convertTo(diff, CV_64F);
+    return diff;
+}
+
+void TemporalVariabilityIndicators::analyzeFrame(const cv::Mat &saDiff, const cv::Mat &paDiff, int t) {
     cv::Mat d = saDiff - paDiff;
 
     /* L norm over space (== mean) */
@@ -49,6 +58,14 @@ void TemporalVariabilityIndicators::analyzeFrame(std::shared_ptr<const Frame> sr
     d_introduced.at<double>(t - 1) = di_t.at<double>(0);
 }
 
+double TemporalVariabilityIndicators::frameOmitted(unsigned t) const {
+    return t > 0 ? d_omitted.at<double>(t - 1) : std::numeric_limits<double>::quiet_NaN();
+}
+
+double TemporalVariabilityIndicators::frameIntroduced(unsigned t) const {
+    return t > 0 ? d_introduced.at<double>(t - 1) : std::numeric_limits<double>::quiet_NaN();
+}
+
 double TemporalVariabilityIndicators::getOmittedComponentIndicator() {
     return cv::mean(d_omitted)[0];
 }
@@ -31,10 +31,21 @@ public:
     void analyzeFrame(std::shared_ptr<const Frame> srcCurr, std::shared_ptr<const Frame> pvsCurr,
                       std::shared_ptr<const Frame> srcPrev, std::shared_ptr<const Frame> pvsPrev, int t);
 
+    /* Same as above with the frame differences already computed, so a SRC difference can be reused */
+    void analyzeFrame(const cv::Mat &saDiff, const cv::Mat &paDiff, int t);
+
+    /* Absolute luma difference between two frames, as CV_64F */
+    static cv::Mat frameDifference(std::shared_ptr<const Frame> curr, std::shared_ptr<const Frame> prev);
+
     double getOmittedComponentIndicator();
 
     double getIntroducedComponentIndicator();
 
+    /* Terms of frame t the indicators are pooled from, NaN for the first frame, which has none */
+    double frameOmitted(unsigned t) const;
+
+    double frameIntroduced(unsigned t) const;
+
 private:
     cv::Mat d_omitted;
     cv::Mat d_introduced;
@@ -0,0 +1,378 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <io/ContentHash.h>
+#include <metrics/common/alignment/ColourAlignment.h>
+
+#include "SourceFeatureCache.h"
+
+
+static const char MAGIC[8] = "OPVQSFC";
+static const std::uint32_t VERSION = 1;
+static const std::size_t HEADER_SPACE = 4096; // Keeps frame records page aligned
+static const std::size_t HISTOGRAM_SIZE = 3 * 256 * sizeof(float);
+static const char *SUFFIX = ".sfc";
+static std::atomic<unsigned> temporaryCount(0); // Concurrent jobs of one process may write the same entry
+
+Logger SourceFeatureCache::logger = Logger("SourceFeatureCache");
+
+/*
+ * Frame record layout: Y, U and V histograms as float, edginess images of the cropped frame, the
+ * uncropped Y, U and V planes, and the cropped luma difference to the previous frame.
+ *
+ * Edginess values are square roots of sums of squared filter responses, and those responses are
+ * multiples of 0.5 of at most 255 in magnitude. 4 * edge^2 is therefore an integer below 2^20 that
+ * identifies the double exactly, so it is stored in a 32 bit word instead of the double.
+ */
+struct Layout {
+    int croppedWidth, croppedHeight;
+    std::size_t edgeOffset, planeOffset, differenceOffset, size;
+
+    Layout(const SourceFeatureCache::Header &header)
+            : croppedWidth(header.width - 2 * header.crop),
+              croppedHeight(header.height - 2 * header.crop) {
+        std::size_t croppedArea = static_cast<std::size_t>(croppedWidth) * croppedHeight;
+        std::size_t area = static_cast<std::size_t>(header.width) * header.height;
+        edgeOffset = HISTOGRAM_SIZE;
+        planeOffset = edgeOffset + 3 * croppedArea * sizeof(std::uint32_t);
+        differenceOffset = planeOffset + 3 * area;
+        size = (differenceOffset + croppedArea + 63) & ~static_cast<std::size_t>(63);
+    }
+};
+
+std::size_t SourceFeatureCache::recordSize(const Header &header) {
+    return Layout(header).size;
+}
+
+std::size_t SourceFeatureCache::entrySize(const Header &header) {
+    return HEADER_SPACE + recordSize(header) * header.frameCount;
+}
+
+SourceFeatureCache::SourceFeatureCache(const std::string &directory, std::uint64_t sizeLimit)
+        : directory(directory), sizeLimit(sizeLimit) {
+}
+
+std::string SourceFeatureCache::entryPath(const std::string &directory, std::uint64_t contentHash) {
+    return directory + "/" + ContentHash::hex(contentHash) + SUFFIX;
+}
+
+std::shared_ptr<SourceFeatureCache::Entry> SourceFeatureCache::lookup(std::uint64_t contentHash, int maxFrames) {
+    std::string path = entryPath(directory, contentHash);
+    if (access(path.c_str(), R_OK) != 0)
+        return nullptr;
+
+    std::shared_ptr<Entry> entry;
+    try {
+        entry = std::make_shared<Entry>(path);
+    } catch (std::exception &e) {
+        logger(WARN) << "Ignoring cache entry: " << e.what();
+        return nullptr;
+    }
+    const Header &header = entry->header();
+    if (header.contentHash != contentHash || (!header.complete && header.frameCount < maxFrames)) {
+        return nullptr;
+    }
+
+    // The modification time is the entry's last use
+    utime(path.c_str(), nullptr);
+    return entry;
+}
+
+std::shared_ptr<SourceFeatureCache::Writer> SourceFeatureCache::create(std::uint64_t contentHash,
+                                                                       const VideoInfo &info, int crop,
+                                                                       int maxFrames) {
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.width = info.width;
+    header.height = info.height;
+    header.crop = crop;
+    header.frameCount = std::min(info.frame_count, maxFrames);
+    header.complete = info.frame_count <= maxFrames;
+    header.duration = info.duration;
+    header.avgFramerate = info.avg_framerate;
+    header.contentHash = contentHash;
+
+    if (entrySize(header) > sizeLimit) {
+        logger(INFO) << "SRC features need " << (entrySize(header) >> 20) << " MiB, more than the cache limit";
+        return nullptr;
+    }
+
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        logger(WARN) << "Could not create cache directory " << directory << ": " << std::strerror(errno);
+        return nullptr;
+    }
+    try {
+        return std::make_shared<Writer>(directory, sizeLimit, header);
+    } catch (std::exception &e) {
+        logger(WARN) << e.what();
+        return nullptr;
+    }
+}
+
+void SourceFeatureCache::evict(const std::string &directory, std::uint64_t sizeLimit, const std::string &keep) {
+    struct Candidate {
+        std::string path;
+        time_t lastUse;
+        std::uint64_t size;
+    };
+    std::vector<Candidate> entries;
+    std::uint64_t total = 0;
+
+    DIR *dir = opendir(directory.c_str());
+    if (!dir)
+        return;
+    while (struct dirent *d = readdir(dir)) {
+        std::string name(d->d_name);
+        if (name.size() <= std::strlen(SUFFIX) || name.compare(name.size() - std::strlen(SUFFIX), std::string::npos, SUFFIX) != 0)
+            continue;
+        struct stat st;
+        std::string path = directory + "/" + name;
+        if (stat(path.c_str(), &st) != 0)
+            continue;
+        entries.push_back({path, st.st_mtime, static_cast<std::uint64_t>(st.st_size)});
+        total += st.st_size;
+    }
+    closedir(dir);
+
+    std::sort(entries.begin(), entries.end(), [](const Candidate &a, const Candidate &b) {
+        return a.lastUse < b.lastUse;
+    });
+    for (auto &entry : entries) {
+        if (total <= sizeLimit)
+            break;
+        if (entry.path == keep)
+            continue;
+        // Runs still using the entry keep their mapping
+        if (unlink(entry.path.c_str()) == 0) {
+            logger(DEBUG) << "Evicted " << entry.path;
+            total -= entry.size;
+        }
+    }
+}
+
+SourceFeatureCache::Entry::Entry(const std::string &path)
+        : path(path), mapping(nullptr), mappingSize(0), mappedBytes(MemoryAccounting::CACHE), frameCounter(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Could not open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < HEADER_SPACE
+        || pread(fd, &head, sizeof(head), 0) != static_cast<ssize_t>(sizeof(head))) {
+        close(fd);
+        throw std::runtime_error(path + " is not a cache entry");
+    }
+    if (std::memcmp(head.magic, MAGIC, sizeof(MAGIC)) != 0 || head.version != VERSION
+        || head.width <= 2 * head.crop || head.height <= 2 * head.crop || head.frameCount < 0
+        || static_cast<std::size_t>(st.st_size) != entrySize(head)) {
+        close(fd);
+        throw std::runtime_error(path + " is not a cache entry of this version");
+    }
+
+    mappingSize = st.st_size;
+    void *p = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        throw std::runtime_error("Could not map " + path);
+    mapping = static_cast<unsigned char *>(p);
+    mappedBytes.resize(mappingSize);
+}
+
+SourceFeatureCache::Entry::~Entry() {
+    if (mapping)
+        munmap(mapping, mappingSize);
+}
+
+const SourceFeatureCache::Header &SourceFeatureCache::Entry::header() const {
+    return head;
+}
+
+std::size_t SourceFeatureCache::Entry::size() const {
+    return mappingSize;
+}
+
+const unsigned char *SourceFeatureCache::Entry::record(unsigned t) const {
+    assert(t < static_cast<unsigned>(head.frameCount));
+    return mapping + HEADER_SPACE + recordSize(head) * t;
+}
+
+VideoInfo SourceFeatureCache::Entry::getVideoInfo() {
+    VideoInfo info;
+    info.width = head.width;
+    info.height = head.height;
+    info.duration = head.duration;
+    info.frame_count = head.frameCount;
+    info.filename = path;
+    info.avg_framerate = head.avgFramerate;
+    return info;
+}
+
+std::shared_ptr<Frame> SourceFeatureCache::Entry::nextFrame() {
+    if (frameCounter >= head.frameCount)
+        return nullptr;
+
+    // The mapping is read-only, frames must not be written to
+    unsigned char *planes = const_cast<unsigned char *>(record(frameCounter++)) + Layout(head).planeOffset;
+    std::size_t area = static_cast<std::size_t>(head.width) * head.height;
+    return std::make_shared<Frame>(cv::Mat(head.height, head.width, CV_8UC1, planes),
+                                   cv::Mat(head.height, head.width, CV_8UC1, planes + area),
+                                   cv::Mat(head.height, head.width, CV_8UC1, planes + 2 * area));
+}
+
+void SourceFeatureCache::Entry::rewind() {
+    frameCounter = 0;
+}
+
+std::array<cv::Mat, 3> SourceFeatureCache::Entry::histograms(unsigned t) const {
+    float *h = reinterpret_cast<float *>(const_cast<unsigned char *>(record(t)));
+    return {{cv::Mat(256, 1, CV_32FC1, h), cv::Mat(256, 1, CV_32FC1, h + 256), cv::Mat(256, 1, CV_32FC1, h + 512)}};
+}
+
+std::shared_ptr<Frame> SourceFeatureCache::Entry::edge(unsigned t) const {
+    Layout layout(head);
+    const std::uint32_t *q = reinterpret_cast<const std::uint32_t *>(record(t) + layout.edgeOffset);
+
+    std::shared_ptr<Frame> edge = std::make_shared<Frame>(layout.croppedHeight, layout.croppedWidth, CV_64FC1);
+    for (cv::Mat *plane : {&edge->Y, &edge->U, &edge->V}) {
+        double *e = plane->ptr<double>(0);
+        for (int i = 0; i < layout.croppedWidth * layout.croppedHeight; i++) {
+            e[i] = std::sqrt(q[i] * 0.25);
+        }
+        q += layout.croppedWidth * layout.croppedHeight;
+    }
+    edge->account(MemoryAccounting::SCRATCH);
+    return edge;
+}
+
+cv::Mat SourceFeatureCache::Entry::temporalDifference(unsigned t) const {
+    cv::Mat diff;
+    if (t == 0)
+        return diff;
+
+    Layout layout(head);
+    unsigned char *d = const_cast<unsigned char *>(record(t)) + layout.differenceOffset;
+    cv::Mat(layout.croppedHeight, layout.croppedWidth, CV_8UC1, d).convertTo(diff, CV_64F);
+    return diff;
+}
+
+SourceFeatureCache::Writer::Writer(const std::string &directory, std::uint64_t sizeLimit, const Header &header)
+        : directory(directory), sizeLimit(sizeLimit), path(entryPath(directory, header.contentHash)),
+          head(header), stored(0), committed(false) {
+    temporaryPath = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(temporaryCount++);
+    fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Could not create cache entry " + temporaryPath);
+    if (ftruncate(fd, entrySize(head)) != 0) {
+        close(fd);
+        unlink(temporaryPath.c_str());
+        throw std::runtime_error("Could not allocate cache entry " + temporaryPath);
+    }
+}
+
+SourceFeatureCache::Writer::~Writer() {
+    if (!committed) {
+        close(fd);
+        unlink(temporaryPath.c_str());
+    }
+}
+
+void SourceFeatureCache::Writer::store(unsigned t, const Frame &src, const Frame &edge,
+                                       const cv::Mat &temporalDifference) {
+    if (t >= static_cast<unsigned>(head.frameCount))
+        return;
+
+    Layout layout(head);
+    std::vector<unsigned char> record(layout.size, 0);
+
+    Frame cropped(src);
+    cropped.adjustROI(-head.crop, -head.crop, -head.crop, -head.crop);
+    float *h = reinterpret_cast<float *>(record.data());
+    for (const cv::Mat &histogram : ColourAlignment::frameHistograms(cropped)) {
+        std::memcpy(h, histogram.ptr<float>(0), 256 * sizeof(float));
+        h += 256;
+    }
+
+    std::uint32_t *q = reinterpret_cast<std::uint32_t *>(record.data() + layout.edgeOffset);
+    for (const cv::Mat *plane : {&edge.Y, &edge.U, &edge.V}) {
+        for (int r = 0; r < layout.croppedHeight; r++) {
+            const double *e = plane->ptr<double>(r);
+            for (int c = 0; c < layout.croppedWidth; c++) {
+                *q++ = static_cast<std::uint32_t>(std::lround(4 * e[c] * e[c]));
+            }
+        }
+    }
+
+    unsigned char *p = record.data() + layout.planeOffset;
+    for (const cv::Mat *plane : {&src.Y, &src.U, &src.V}) {
+        for (int r = 0; r < head.height; r++, p += head.width) {
+            std::memcpy(p, plane->ptr<unsigned char>(r), head.width);
+        }
+    }
+
+    if (!temporalDifference.empty()) {
+        cv::Mat difference(layout.croppedHeight, layout.croppedWidth, CV_8UC1, record.data() + layout.differenceOffset);
+        temporalDifference.convertTo(difference, CV_8U);
+    }
+
+    // pwrite() doesn't move the file offset, so frames can be stored concurrently
+    off_t offset = HEADER_SPACE + layout.size * t;
+    for (std::size_t written = 0; written < record.size();) {
+        ssize_t n = pwrite(fd, record.data() + written, record.size() - written, offset + written);
+        if (n <= 0) {
+            logger(WARN) << "Could not write to cache entry " << temporaryPath;
+            return;
+        }
+        written += n;
+    }
+    stored++;
+}
+
+void SourceFeatureCache::Writer::commit() {
+    if (committed)
+        return;
+    committed = true;
+
+    bool complete = stored == static_cast<unsigned>(head.frameCount);
+    bool written = complete && pwrite(fd, &head, sizeof(head), 0) == static_cast<ssize_t>(sizeof(head));
+    close(fd);
+    if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        logger(WARN) << "SRC features were not cached";
+        unlink(temporaryPath.c_str());
+        return;
+    }
+    logger(INFO) << "Cached SRC features in " << path;
+    evict(directory, sizeLimit, path);
+}
@@ -0,0 +1,140 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SourceFeatureCache_h
+#define SourceFeatureCache_h
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <io/Frame.h>
+#include <io/Logger.h>
+#include <io/VideoSequence.h>
+
+
+/*
+ * On-disk cache of the SRC side of OPVQ, one file per SRC keyed by the hash of its contents. An entry
+ * holds for every frame the decoded planes, the edginess images and temporal difference of the cropped
+ * frame, and its colour histograms. Entries are memory mapped read-only, so a cached SRC is neither
+ * decoded nor analysed again. The least recently used entries are removed when the cache outgrows
+ * its size limit.
+ */
+class SourceFeatureCache {
+public:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::int32_t width;
+        std::int32_t height;
+        std::int32_t crop;
+        std::int32_t frameCount;
+        std::uint32_t complete; // Nonzero if frameCount is the whole sequence, not a --max-frames prefix
+        float duration;
+        float avgFramerate;
+        std::uint64_t contentHash;
+    };
+
+    /* A cached SRC, its frames point into the read-only mapping */
+    class Entry : public FrameSource {
+    public:
+        Entry(const std::string &path);
+
+        ~Entry();
+
+        const Header &header() const;
+
+        /* Bytes mapped */
+        std::size_t size() const;
+
+        VideoInfo getVideoInfo() override;
+
+        std::shared_ptr<Frame> nextFrame() override;
+
+        void rewind() override;
+
+        std::array<cv::Mat, 3> histograms(unsigned t) const;
+
+        /* Edginess images of the cropped frame, bit-exact with EdginessImage */
+        std::shared_ptr<Frame> edge(unsigned t) const;
+
+        /* Difference of the cropped luma to the previous frame, empty for frame 0 */
+        cv::Mat temporalDifference(unsigned t) const;
+
+    private:
+        std::string path;
+        Header head;
+        unsigned char *mapping;
+        std::size_t mappingSize;
+        MemoryAccounting::Allocation mappedBytes;
+        int frameCounter;
+
+        const unsigned char *record(unsigned t) const;
+    };
+
+    /* Fills a new entry while the SRC is analysed. Frames may be stored from several threads in any
+     * order; the entry becomes visible on commit() once all of them are there. */
+    class Writer {
+    public:
+        Writer(const std::string &directory, std::uint64_t sizeLimit, const Header &header);
+
+        ~Writer();
+
+        /* src uncropped, edge and temporalDifference as computed from the cropped frame */
+        void store(unsigned t, const Frame &src, const Frame &edge, const cv::Mat &temporalDifference);
+
+        void commit();
+
+    private:
+        std::string directory;
+        std::uint64_t sizeLimit;
+        std::string path;
+        std::string temporaryPath;
+        Header head;
+        int fd;
+        std::atomic<unsigned> stored;
+        bool committed;
+    };
+
+    SourceFeatureCache(const std::string &directory, std::uint64_t sizeLimit);
+
+    /* Entry for the SRC with the given hash holding at least maxFrames frames, or NULL */
+    std::shared_ptr<Entry> lookup(std::uint64_t contentHash, int maxFrames);
+
+    /* NULL if the entry would not fit in the cache */
+    std::shared_ptr<Writer> create(std::uint64_t contentHash, const VideoInfo &info, int crop, int maxFrames);
+
+private:
+    static Logger logger;
+
+    std::string directory;
+    std::uint64_t sizeLimit;
+
+    static std::string entryPath(const std::string &directory, std::uint64_t contentHash);
+
+    /* Removes least recently used entries until the cache fits its size limit, keep is never removed */
+    static void evict(const std::string &directory, std::uint64_t sizeLimit, const std::string &keep);
+
+    static std::size_t recordSize(const Header &header);
+
+    static std::size_t entrySize(const Header &header);
+};
+
+#endif //SourceFeatureCache_h
@@ -51,10 +51,28 @@ MappingCoefficients DMOSMapper::QCIFcoeff = {
 
 Logger DMOSMapper::logger = Logger("DMOSMapper");
 
+static double limited(const MappingCoefficients &coeff, unsigned i, double indicator) {
+    return std::max(std::min(indicator, coeff.Imax[i]), coeff.Imin[i]);
+}
+
+static double contribution(const MappingCoefficients &coeff, unsigned i, double indicator) {
+    return coeff.w[i] / (1 + std::exp(coeff.alpha[i] * limited(coeff, i, indicator) + coeff.beta[i]));
+}
+
+double DMOSMapper::score(const std::vector<double> &indicators, const MappingCoefficients &coeff) {
+    double score = coeff.LinearOffset;
+    for (unsigned i = 0; i < NUM_IND; i++) {
+        score += contribution(coeff, i, indicators[i]);
+    }
+    return std::max(std::min(score, 5.0), 1.0);
+}
+
 double DMOSMapper::calculateAggregateScore(std::vector<double> &indicators, MappingCoefficients coeff) {
     const char *shortnames[] = {"Luma", "Chroma", "Omitted", "Introduced"};
 
     double score = coeff.LinearOffset;
+    // The table goes to stdout directly, after what was logged before
+    Logger::flush();
     std::cout << "LINEAR OFFSET: " << coeff.LinearOffset << std::endl;
     std::cout << std::left << std::fixed << std::setw(15) << "INDICATOR";
     std::cout << std::fixed << std::setw(15) << "VALUE";
@@ -63,8 +81,8 @@ double DMOSMapper::calculateAggregateScore(std::vector<double> &indicators, Mapp
     std::cout << std::fixed << std::setw(12) << "CONTRIBUTION" << std::endl;
 
     for (unsigned i = 0; i < NUM_IND; i++) {
-        double Ilim = std::max(std::min(indicators[i], coeff.Imax[i]), coeff.Imin[i]);
-        double contrib = coeff.w[i] / (1 + std::exp(coeff.alpha[i] * Ilim + coeff.beta[i]));
+        double Ilim = limited(coeff, i, indicators[i]);
+        double contrib = contribution(coeff, i, indicators[i]);
         score += contrib;
         std::cout << std::left << std::fixed << std::setw(15) << shortnames[i];
         std::cout << std::fixed << std::setw(15) << Ilim;
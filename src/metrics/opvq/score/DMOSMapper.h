@@ -47,6 +47,9 @@ public:
 
     static double calculateAggregateScore(std::vector<double> &indicators, MappingCoefficients coeff);
 
+    /* Same without printing the contributions, for scoring many windows of a sequence */
+    static double score(const std::vector<double> &indicators, const MappingCoefficients &coeff);
+
     static Logger logger;
 };
 
@@ -0,0 +1,101 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+#include <metrics/opvq/score/DMOSMapper.h>
+
+#include "ReducedReferenceIndicators.h"
+
+
+typedef ReferenceSignature S;
+
+ReducedReferenceIndicators::ReducedReferenceIndicators(unsigned int sequenceLength, int width, int height,
+                                                       int blockSize)
+        : weightSum(0), pixelSum(0),
+          lumaValues(sequenceLength), chromaValues(sequenceLength),
+          introducedValues(sequenceLength > 1 ? sequenceLength - 1 : 0),
+          omittedValues(sequenceLength > 1 ? sequenceLength - 1 : 0) {
+    int blocksX = (width + blockSize - 1) / blockSize;
+    int blocksY = (height + blockSize - 1) / blockSize;
+    blockWeights.assign(static_cast<std::size_t>(blocksX) * blocksY, 0.0);
+    blockPixels.assign(blockWeights.size(), 0.0);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double sinw = std::sin(M_PI * ((double) x / (double) width));
+            double sinh = std::sin(M_PI * ((double) y / (double) height));
+            std::size_t b = static_cast<std::size_t>(y / blockSize) * blocksX + x / blockSize;
+            blockWeights[b] += std::abs(sinw * sinh);
+            blockPixels[b] += 1;
+        }
+    }
+    weightSum = std::accumulate(blockWeights.begin(), blockWeights.end(), 0.0);
+    pixelSum = std::accumulate(blockPixels.begin(), blockPixels.end(), 0.0);
+}
+
+static double clip(double v, double limit) {
+    return std::max(std::min(v, limit), -limit);
+}
+
+void ReducedReferenceIndicators::analyzeFrame(const std::vector<double> &src, const std::vector<double> &pvs, int t) {
+    assert(src.size() == blockWeights.size() * S::NUM_STATISTICS && pvs.size() == src.size());
+
+    double luma = 0, cb = 0, cr = 0, omitted = 0, introduced = 0;
+    for (std::size_t b = 0; b < blockWeights.size(); b++) {
+        const double *s = &src[b * S::NUM_STATISTICS];
+        const double *p = &pvs[b * S::NUM_STATISTICS];
+
+        double dev = std::max(std::abs(s[S::MEAN_Y] - 100.0), std::abs(p[S::MEAN_Y] - 100.0));
+        double eY = clip(80.0 * (p[S::EDGE_Y] - s[S::EDGE_Y]) / (s[S::EDGE_Y] + 80.0 + dev), 40.0);
+        luma += blockWeights[b] * std::pow(std::abs(eY), 5.0);
+
+        double devCbCr = 0.8 * std::max(s[S::CHROMA_MAGNITUDE], p[S::CHROMA_MAGNITUDE]);
+        cb += blockWeights[b] * std::abs(clip(40.0 * (p[S::EDGE_U] - s[S::EDGE_U]) / (s[S::EDGE_U] + 40.0 + devCbCr), 40.0));
+        cr += blockWeights[b] * std::abs(clip(40.0 * (p[S::EDGE_V] - s[S::EDGE_V]) / (s[S::EDGE_V] + 40.0 + devCbCr), 40.0));
+
+        double d = s[S::TEMPORAL_DIFFERENCE] - p[S::TEMPORAL_DIFFERENCE];
+        omitted += blockPixels[b] * std::max(d, 0.0);
+        introduced += blockPixels[b] * std::pow(std::max(-d, 0.0), 5.0);
+    }
+
+    lumaValues[t] = std::pow(luma / weightSum, 0.2);
+    chromaValues[t] = 0.5 * (cb + cr) / weightSum;
+    if (t > 0) {
+        omittedValues[t - 1] = omitted / pixelSum;
+        introducedValues[t - 1] = std::pow(introduced / pixelSum, 0.2);
+    }
+}
+
+std::vector<double> ReducedReferenceIndicators::getIndicators() const {
+    auto mean = [](const std::vector<double> &v) {
+        return v.empty() ? 0.0 : std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+    };
+    double introducedSquares = std::inner_product(introducedValues.begin(), introducedValues.end(),
+                                                  introducedValues.begin(), 0.0);
+
+    std::vector<double> indicators(NUM_IND);
+    indicators[LUMA_IND] = mean(lumaValues);
+    indicators[CHROMA_IND] = mean(chromaValues);
+    indicators[INTRO_IND] = introducedValues.empty() ? 0.0 : std::sqrt(introducedSquares / introducedValues.size());
+    indicators[OMIT_IND] = mean(omittedValues);
+    return indicators;
+}
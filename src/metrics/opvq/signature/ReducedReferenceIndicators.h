@@ -0,0 +1,53 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ReducedReferenceIndicators_h
+#define ReducedReferenceIndicators_h
+
+#include <vector>
+
+#include "ReferenceSignature.h"
+
+
+/*
+ * The four OPVQ indicators evaluated on block statistics instead of pixels. Every formula of
+ * LuminanceIndicator, ChrominanceIndicator and TemporalVariabilityIndicators is applied to block
+ * means, and blocks are weighted by their share of the pixel weights and pixel count.
+ */
+class ReducedReferenceIndicators {
+public:
+    ReducedReferenceIndicators(unsigned int sequenceLength, int width, int height, int blockSize);
+
+    void analyzeFrame(const std::vector<double> &src, const std::vector<double> &pvs, int t);
+
+    /* Indexed by LUMA_IND, CHROMA_IND, INTRO_IND and OMIT_IND */
+    std::vector<double> getIndicators() const;
+
+private:
+    std::vector<double> blockWeights; // Sum of the sine window over the block, as in LuminanceIndicator
+    std::vector<double> blockPixels;
+    double weightSum;
+    double pixelSum;
+
+    std::vector<double> lumaValues;
+    std::vector<double> chromaValues;
+    std::vector<double> introducedValues;
+    std::vector<double> omittedValues;
+};
+
+#endif //ReducedReferenceIndicators_h
@@ -0,0 +1,190 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "ReferenceSignature.h"
+
+
+static const char MAGIC[8] = "OPVQSIG";
+static const std::uint32_t VERSION = 1;
+
+/* Statistics are stored as 10.6 fixed point: all of them lie in [0, 362] and 1/64 is far below what
+ * block averaging loses anyway */
+static const double FIXED_POINT_SCALE = 64.0;
+
+static int blockCount(int length, int blockSize) {
+    return (length + blockSize - 1) / blockSize;
+}
+
+ReferenceSignature::ReferenceSignature(const VideoInfo &info, int crop, int blockSize) {
+    std::memset(&head, 0, sizeof(head));
+    std::memcpy(head.magic, MAGIC, sizeof(MAGIC));
+    head.version = VERSION;
+    head.width = info.width;
+    head.height = info.height;
+    head.crop = crop;
+    head.blockSize = blockSize;
+    head.frameCount = 0;
+    head.duration = info.duration;
+    head.avgFramerate = info.avg_framerate;
+    for (auto &sums : histogramSums) {
+        sums.assign(256, 0.0);
+    }
+}
+
+ReferenceSignature::ReferenceSignature(const std::string &path) {
+    std::ifstream in(path, std::ifstream::binary);
+    if (!in.read(reinterpret_cast<char *>(&head), sizeof(head))
+        || std::memcmp(head.magic, MAGIC, sizeof(MAGIC)) != 0 || head.version != VERSION
+        || head.blockSize <= 0 || head.frameCount < 0
+        || head.width <= 2 * head.crop || head.height <= 2 * head.crop) {
+        throw std::runtime_error(path + " is not an OPVQ signature");
+    }
+
+    for (auto &sums : histogramSums) {
+        sums.resize(256);
+        in.read(reinterpret_cast<char *>(sums.data()), 256 * sizeof(double));
+    }
+    values.resize(valuesPerFrame() * head.frameCount);
+    in.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(std::uint16_t));
+    if (!in) {
+        throw std::runtime_error("Signature " + path + " is truncated");
+    }
+}
+
+void ReferenceSignature::write(const std::string &path) const {
+    std::ofstream out(path, std::ofstream::binary | std::ofstream::trunc);
+    out.write(reinterpret_cast<const char *>(&head), sizeof(head));
+    for (auto &sums : histogramSums) {
+        out.write(reinterpret_cast<const char *>(sums.data()), 256 * sizeof(double));
+    }
+    out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(std::uint16_t));
+    if (!out) {
+        throw std::runtime_error("Could not write signature to " + path);
+    }
+}
+
+std::size_t ReferenceSignature::valuesPerFrame() const {
+    int croppedWidth = head.width - 2 * head.crop;
+    int croppedHeight = head.height - 2 * head.crop;
+    return static_cast<std::size_t>(blockCount(croppedWidth, head.blockSize)) *
+           blockCount(croppedHeight, head.blockSize) * NUM_STATISTICS;
+}
+
+VideoInfo ReferenceSignature::videoInfo() const {
+    VideoInfo info;
+    info.width = head.width;
+    info.height = head.height;
+    info.duration = head.duration;
+    info.frame_count = head.frameCount;
+    info.avg_framerate = head.avgFramerate;
+    return info;
+}
+
+int ReferenceSignature::crop() const {
+    return head.crop;
+}
+
+int ReferenceSignature::blockSize() const {
+    return head.blockSize;
+}
+
+unsigned ReferenceSignature::frameCount() const {
+    return static_cast<unsigned>(head.frameCount);
+}
+
+void ReferenceSignature::addFrame(const std::vector<double> &statistics, const std::array<cv::Mat, 3> &histograms) {
+    assert(statistics.size() == valuesPerFrame());
+    for (double v : statistics) {
+        values.push_back(static_cast<std::uint16_t>(std::min(65535.0, std::round(v * FIXED_POINT_SCALE))));
+    }
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < 256; i++) {
+            histogramSums[c][i] += histograms[c].at<float>(i);
+        }
+    }
+    head.frameCount++;
+}
+
+std::vector<double> ReferenceSignature::frameStatistics(unsigned t) const {
+    assert(t < frameCount());
+    auto begin = values.begin() + valuesPerFrame() * t;
+    std::vector<double> statistics(begin, begin + valuesPerFrame());
+    for (double &v : statistics) {
+        v /= FIXED_POINT_SCALE;
+    }
+    return statistics;
+}
+
+std::array<cv::Mat, 3> ReferenceSignature::histograms() const {
+    std::array<cv::Mat, 3> histograms;
+    for (int c = 0; c < 3; c++) {
+        histograms[c] = cv::Mat(256, 1, CV_32FC1);
+        for (int i = 0; i < 256; i++) {
+            histograms[c].at<float>(i) = static_cast<float>(histogramSums[c][i] / std::max(head.frameCount, 1));
+        }
+    }
+    return histograms;
+}
+
+std::vector<double> ReferenceSignature::blockStatistics(const Frame &frame, const Frame &edge,
+                                                        const cv::Mat &difference, int blockSize) {
+    int width = frame.Y.cols, height = frame.Y.rows;
+    int blocksX = blockCount(width, blockSize), blocksY = blockCount(height, blockSize);
+    std::vector<double> statistics(static_cast<std::size_t>(blocksX) * blocksY * NUM_STATISTICS, 0.0);
+
+    for (int y = 0; y < height; y++) {
+        const std::uint8_t *Y = frame.Y.ptr<std::uint8_t>(y);
+        const std::uint8_t *U = frame.U.ptr<std::uint8_t>(y);
+        const std::uint8_t *V = frame.V.ptr<std::uint8_t>(y);
+        const double *eY = edge.Y.ptr<double>(y);
+        const double *eU = edge.U.ptr<double>(y);
+        const double *eV = edge.V.ptr<double>(y);
+        const double *d = difference.empty() ? nullptr : difference.ptr<double>(y);
+
+        double *row = &statistics[static_cast<std::size_t>(y / blockSize) * blocksX * NUM_STATISTICS];
+        for (int x = 0; x < width; x++) {
+            double *block = row + (x / blockSize) * NUM_STATISTICS;
+            double u = U[x] - 128.0, v = V[x] - 128.0;
+            block[MEAN_Y] += Y[x];
+            block[EDGE_Y] += eY[x];
+            block[EDGE_U] += eU[x];
+            block[EDGE_V] += eV[x];
+            block[CHROMA_MAGNITUDE] += std::sqrt(u * u + v * v);
+            if (d)
+                block[TEMPORAL_DIFFERENCE] += d[x];
+        }
+    }
+
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            int pixels = (std::min(blockSize, width - bx * blockSize)) * (std::min(blockSize, height - by * blockSize));
+            double *block = &statistics[(static_cast<std::size_t>(by) * blocksX + bx) * NUM_STATISTICS];
+            for (int s = 0; s < NUM_STATISTICS; s++) {
+                block[s] /= pixels;
+            }
+        }
+    }
+    return statistics;
+}
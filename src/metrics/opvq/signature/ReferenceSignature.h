@@ -0,0 +1,96 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ReferenceSignature_h
+#define ReferenceSignature_h
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <io/Frame.h>
+#include <io/VideoSequence.h>
+
+
+/*
+ * Reduced reference for OPVQ: the SRC side of every frame pooled over square blocks of the cropped
+ * frame, and the colour histograms summed over the sequence. The same block statistics computed on a
+ * PVS can be compared with it without the SRC, see ReducedReferenceIndicators.
+ */
+class ReferenceSignature {
+public:
+    enum Statistic {
+        MEAN_Y = 0,
+        EDGE_Y,
+        EDGE_U,
+        EDGE_V,
+        CHROMA_MAGNITUDE, // sqrt((U - 128)^2 + (V - 128)^2)
+        TEMPORAL_DIFFERENCE, // |Y(t) - Y(t - 1)|, 0 for the first frame
+        NUM_STATISTICS
+    };
+
+    ReferenceSignature(const VideoInfo &info, int crop, int blockSize);
+
+    /* Reads a signature file */
+    ReferenceSignature(const std::string &path);
+
+    void write(const std::string &path) const;
+
+    VideoInfo videoInfo() const;
+
+    int crop() const;
+
+    int blockSize() const;
+
+    unsigned frameCount() const;
+
+    void addFrame(const std::vector<double> &statistics, const std::array<cv::Mat, 3> &histograms);
+
+    /* NUM_STATISTICS values per block, blocks in row-major order */
+    std::vector<double> frameStatistics(unsigned t) const;
+
+    /* Y, U and V histograms of the average frame, in the form ColourAlignment takes them */
+    std::array<cv::Mat, 3> histograms() const;
+
+    /* Block means of the statistics of a cropped frame, its edginess images and its luma difference
+     * to the previous frame (empty for the first frame) */
+    static std::vector<double> blockStatistics(const Frame &frame, const Frame &edge, const cv::Mat &difference,
+                                               int blockSize);
+
+private:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::int32_t width;
+        std::int32_t height;
+        std::int32_t crop;
+        std::int32_t blockSize;
+        std::int32_t frameCount;
+        float duration;
+        float avgFramerate;
+    };
+
+    Header head;
+    std::array<std::vector<double>, 3> histogramSums;
+    std::vector<std::uint16_t> values; // Fixed point, see write()
+
+    std::size_t valuesPerFrame() const;
+};
+
+#endif //ReferenceSignature_h
@@ -18,75 +18,131 @@
 
 #include <boost/program_options/variables_map.hpp>
 #include <boost/program_options/parsers.hpp>
-#include <fstream>
-#include <iomanip>
+#include <cmath>
 
-#include <opencv2/core/core.hpp>
 #include <metrics/common/alignment/SpatialAlignment.h>
+#include <metrics/common/kernels/SquaredDifference.h>
 #include "PSNR.h"
 
 
 PSNR::PSNR()
         : FullReferenceAlgorithm("PSNR"),
-          psnrAccum(0), framesCalculated(0) {
-    options.add_options()("disable-spatial-alignment", "Disable spatial alignment");
+          pooling(FRAME_AVERAGE) {
+    options.add_options()
+            ("disable-spatial-alignment", "Disable spatial alignment")
+            ("pooling", opts::value<std::string>()->default_value("frame"),
+             "Temporal pooling {frame,global}: average of per-frame PSNR, or PSNR of the sequence MSE");
 }
 
-void PSNR::init(int argc, const char **argv) {
-    FullReferenceAlgorithm::init(argc, argv);
-
-    opts::variables_map vm;
-    opts::parsed_options parsed = opts::command_line_parser(argc, argv).
-            options(options).
-            allow_unregistered().
-            run();
-    opts::store(parsed, vm);
+void PSNR::configure(const opts::variables_map &vm) {
+    FullReferenceAlgorithm::configure(vm);
 
     enableSpatialAlignment = !static_cast<bool>(vm.count("disable-spatial-alignment"));
+
+    std::string poolingName = vm["pooling"].as<std::string>();
+    if (poolingName == "frame")
+        pooling = FRAME_AVERAGE;
+    else if (poolingName == "global")
+        pooling = GLOBAL_MSE;
+    else
+        throw std::runtime_error("Invalid pooling \"" + poolingName + "\"");
 }
 
-int PSNR::run() {
-    SpatialAlignment spatialAlignment;
-    makePass([&](std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr, int tCurr) {
-        if (enableSpatialAlignment) {
-            int crop = 1;
-            cv::Point2i sptialOffset = spatialAlignment.spatialOffsetDetermination(srcCurr, pvsCurr, crop);
-            spatialAlignment.cropAndAlign(srcCurr, pvsCurr, crop, sptialOffset);
-        }
+int PSNR::spatialAlignmentCrop() const {
+    return enableSpatialAlignment ? 1 : 0;
+}
 
-        addFrame(srcCurr, pvsCurr);
-    });
+void PSNR::initAnalysis() {
+    mseValues.assign(sequenceLength, std::array<double, NUM_PLANES>());
+}
+
+void PSNR::analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                         std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) {
+    if (enableSpatialAlignment) {
+        int crop = 1;
+        cv::Point2i sptialOffset = spatialAlignment->frameOffset(srcCurr, pvsCurr, crop, t);
+        spatialAlignment->cropAndAlign(srcCurr, pvsCurr, crop, sptialOffset);
+    }
 
-    double psnr = calcPsnr();
-    logger(INFO) << "PSNR: " << psnr;
-    std::vector<double> values = {psnr};
-    writeCSV(pvsURL, values);
-    return 0;
+    mseValues[t] = calcMSEFrame(srcCurr, pvsCurr);
 }
 
+std::vector<double> PSNR::finishAnalysis() {
+    std::array<double, NUM_PLANES> psnr = calcPsnr();
+    double psnrYuv = weightedYuv(psnr);
+    logger(INFO) << "PSNR: " << psnr[PLANE_Y];
+    logger(INFO) << "PSNR-U: " << psnr[PLANE_U] << ", PSNR-V: " << psnr[PLANE_V] << ", PSNR-YUV: " << psnrYuv;
+    return {psnr[PLANE_Y], psnr[PLANE_U], psnr[PLANE_V], psnrYuv};
+}
 
-double PSNR::calcPsnr() {
-    return psnrAccum / framesCalculated;
+std::vector<std::string> PSNR::valueNames() const {
+    return {"psnr_y", "psnr_u", "psnr_v", "psnr_yuv"};
 }
 
+std::vector<double> PSNR::frameValues(unsigned t) const {
+    std::array<double, NUM_PLANES> psnr;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        psnr[p] = mseToPsnr(mseValues[t][p]);
+    }
+    return {psnr[PLANE_Y], psnr[PLANE_U], psnr[PLANE_V], weightedYuv(psnr)};
+}
 
-void PSNR::addFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame) {
-    psnrAccum += calcMSEFrame(srcFrame, pvsFrame);
+std::vector<std::string> PSNR::frameValueNames() const {
+    return valueNames();
 }
 
+/* Per-frame PSNR or MSE of each plane, depending on --pooling */
+std::vector<double> PSNR::poolingTerms(unsigned t) const {
+    std::vector<double> terms;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        terms.push_back(pooling == FRAME_AVERAGE ? mseToPsnr(mseValues[t][p]) : mseValues[t][p]);
+    }
+    return terms;
+}
 
-double PSNR::calcMSEFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame) {
-    cv::Mat res;
-    cv::subtract(srcFrame->Y, pvsFrame->Y, res);
-    cv::pow(res, 2, res);
-    double sumRes = static_cast<double>(cv::sum(res)[0]);
-    sumRes /= srcFrame->Y.cols * srcFrame->Y.rows;
+std::vector<double> PSNR::windowValues(const std::vector<double> &termMeans) const {
+    std::array<double, NUM_PLANES> psnr;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        psnr[p] = pooling == FRAME_AVERAGE ? termMeans[p] : mseToPsnr(termMeans[p]);
+    }
+    return {psnr[PLANE_Y], psnr[PLANE_U], psnr[PLANE_V], weightedYuv(psnr)};
+}
 
-    if (sumRes == 0.0) {
-        sumRes = 1e-10;
+double PSNR::mseToPsnr(double mse) {
+    if (mse == 0.0) {
+        mse = 1e-10;
     }
 
-    framesCalculated++;
     //todo either 255^2(65025) or 235^2 (55225), last aparently suggested by VQEG
-    return 10 * cv::log(65025 / sumRes) / cv::log(10);
+    return 10.0 * std::log10(65025.0 / mse);
+}
+
+double PSNR::weightedYuv(const std::array<double, NUM_PLANES> &planePsnr) {
+    return (6.0 * planePsnr[PLANE_Y] + planePsnr[PLANE_U] + planePsnr[PLANE_V]) / 8.0;
+}
+
+std::array<double, PSNR::NUM_PLANES> PSNR::calcPsnr() {
+    std::array<double, NUM_PLANES> result = {{0, 0, 0}};
+    for (int p = 0; p < NUM_PLANES; p++) {
+        double accum = 0.0;
+        for (auto &mse : mseValues) {
+            accum += (pooling == FRAME_AVERAGE) ? mseToPsnr(mse[p]) : mse[p];
+        }
+        accum /= mseValues.size();
+        result[p] = (pooling == FRAME_AVERAGE) ? accum : mseToPsnr(accum);
+    }
+    return result;
+}
+
+
+std::array<double, PSNR::NUM_PLANES> PSNR::calcMSEFrame(std::shared_ptr<const Frame> srcFrame,
+                                                        std::shared_ptr<const Frame> pvsFrame) {
+    std::array<std::int64_t, NUM_PLANES> ssd = SquaredDifference::frame(*srcFrame, *pvsFrame);
+    const cv::Mat *planes[] = {&srcFrame->Y, &srcFrame->U, &srcFrame->V};
+
+    std::array<double, NUM_PLANES> mse;
+    for (int p = 0; p < NUM_PLANES; p++) {
+        mse[p] = static_cast<double>(ssd[p]) / (static_cast<double>(planes[p]->cols) * planes[p]->rows);
+    }
+    return mse;
 }
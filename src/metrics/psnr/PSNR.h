@@ -19,29 +19,72 @@
 #ifndef PSNR_H
 #define PSNR_H
 
+#include <array>
 #include "io/Frame.h"
 #include "metrics/Algorithm.h"
 
 class PSNR : public FullReferenceAlgorithm {
 public:
+    enum Plane {
+        PLANE_Y = 0,
+        PLANE_U,
+        PLANE_V,
+        NUM_PLANES
+    };
+
+    enum Pooling {
+        FRAME_AVERAGE,
+        GLOBAL_MSE
+    };
+
     PSNR();
 
-    virtual void init(int argc, const char **argv) override;
+    void initAnalysis() override;
+
+    void analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                       std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) override;
+
+    std::vector<double> finishAnalysis() override;
+
+    std::vector<std::string> valueNames() const override;
+
+    std::vector<double> frameValues(unsigned t) const override;
+
+    std::vector<std::string> frameValueNames() const override;
+
+    std::vector<double> poolingTerms(unsigned t) const override;
 
-    int run() override;
+    std::vector<double> windowValues(const std::vector<double> &termMeans) const override;
+
+    int spatialAlignmentCrop() const override;
+
+    /* The squared differences are summed without intermediate planes */
+    std::size_t scratchBytesPerPixel() const override {
+        return 0;
+    };
+
+    std::size_t perFrameBytes() const override {
+        return NUM_PLANES * sizeof(double);
+    };
+
+    /* PSNR of a single mean squared error; a zero MSE is clamped to 1e-10 */
+    static double mseToPsnr(double mse);
+
+    /* Luma weighted 6:1:1 against the chroma planes */
+    static double weightedYuv(const std::array<double, NUM_PLANES> &planePsnr);
+
+protected:
+    void configure(const opts::variables_map &vm) override;
 
 private:
     bool enableSpatialAlignment;
-    double psnrAccum;
-    int framesCalculated;
-
-    //todo: equal src and pvs will return 0. Handle in the calling function to avoid division by zero.
-    //todo: alternatively return <double>::max value as per definition the result is "infinitely high".
-    double calcMSEFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame);
+    Pooling pooling;
+    std::vector<std::array<double, NUM_PLANES> > mseValues;
 
-    void addFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame);
+    std::array<double, NUM_PLANES> calcMSEFrame(std::shared_ptr<const Frame> srcFrame,
+                                                std::shared_ptr<const Frame> pvsFrame);
 
-    double calcPsnr();
+    std::array<double, NUM_PLANES> calcPsnr();
 };
 
 #endif
\ No newline at end of file
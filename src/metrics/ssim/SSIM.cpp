@@ -18,57 +18,74 @@
 
 #include <boost/program_options/variables_map.hpp>
 #include <boost/program_options/parsers.hpp>
+#include <numeric>
 #include <metrics/common/alignment/SpatialAlignment.h>
 
 #include "SSIM.h"
 
 
 SSIM::SSIM()
-        : FullReferenceAlgorithm("SSIM"),
-          ssimAccum(0), framesCalculated(0) {
+        : FullReferenceAlgorithm("SSIM") {
     options.add_options()("disable-spatial-alignment", "Disable spatial alignment");
 }
 
-void SSIM::init(int argc, const char **argv) {
-    FullReferenceAlgorithm::init(argc, argv);
-
-    opts::variables_map vm;
-    opts::parsed_options parsed = opts::command_line_parser(argc, argv).
-            options(options).
-            allow_unregistered().
-            run();
-    opts::store(parsed, vm);
+void SSIM::configure(const opts::variables_map &vm) {
+    FullReferenceAlgorithm::configure(vm);
 
     enableSpatialAlignment = !static_cast<bool>(vm.count("disable-spatial-alignment"));
 }
 
-int SSIM::run() {
+int SSIM::spatialAlignmentCrop() const {
+    return enableSpatialAlignment ? 4 : 0;
+}
 
-    SpatialAlignment spatialAlignment;
+void SSIM::initAnalysis() {
+    ssimValues.assign(sequenceLength, 0.0);
+}
 
-    makePass([&](std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr, int tCurr) {
-        if (enableSpatialAlignment) {
-            int crop = 4;
-            cv::Point2i sptialOffset = spatialAlignment.spatialOffsetDetermination(srcCurr, pvsCurr, crop);
-            spatialAlignment.cropAndAlign(srcCurr, pvsCurr, crop, sptialOffset);
-        }
+void SSIM::analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                         std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) {
+    if (enableSpatialAlignment) {
+        int crop = 4;
+        cv::Point2i sptialOffset = spatialAlignment->frameOffset(srcCurr, pvsCurr, crop, t);
+        spatialAlignment->cropAndAlign(srcCurr, pvsCurr, crop, sptialOffset);
+    }
 
-        addFrame(srcCurr, pvsCurr);
-    });
+    ssimValues[t] = frameSsim(srcCurr, pvsCurr);
+}
 
+std::vector<double> SSIM::finishAnalysis() {
     double ssim = calcSsim();
     logger(INFO) << "SSIM: " << ssim;
-    std::vector<double> values = {ssim};
-    writeCSV(pvsURL, values);
-    return 0;
+    return {ssim};
+}
+
+std::vector<std::string> SSIM::valueNames() const {
+    return {"ssim"};
+}
+
+std::vector<double> SSIM::frameValues(unsigned t) const {
+    return {ssimValues[t]};
+}
+
+std::vector<std::string> SSIM::frameValueNames() const {
+    return valueNames();
+}
+
+std::vector<double> SSIM::poolingTerms(unsigned t) const {
+    return {ssimValues[t]};
+}
+
+std::vector<double> SSIM::windowValues(const std::vector<double> &termMeans) const {
+    return termMeans;
 }
 
 double SSIM::calcSsim() {
-    return ssimAccum / framesCalculated;
+    return std::accumulate(ssimValues.begin(), ssimValues.end(), 0.0) / ssimValues.size();
 }
 
 
-void SSIM::addFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame) {
+double SSIM::frameSsim(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame) {
     double frameSsim = 0;
     int windowsCalculated = 0;
     cv::Mat srcY, pvsY;
@@ -92,8 +109,7 @@ void SSIM::addFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const
             windowsCalculated++;
         }
     }
-    ssimAccum += frameSsim / windowsCalculated;
-    framesCalculated++;
+    return frameSsim / windowsCalculated;
 }
 
 double SSIM::ssimWindow(cv::Mat &srcWindow, cv::Mat &pvsWindow) {
@@ -27,18 +27,44 @@ class SSIM : public FullReferenceAlgorithm {
 public:
     SSIM();
 
-    virtual void init(int argc, const char **argv) override;
+    void initAnalysis() override;
 
-    int run() override;
+    void analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                       std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) override;
+
+    std::vector<double> finishAnalysis() override;
+
+    std::vector<std::string> valueNames() const override;
+
+    std::vector<double> frameValues(unsigned t) const override;
+
+    std::vector<std::string> frameValueNames() const override;
+
+    std::vector<double> poolingTerms(unsigned t) const override;
+
+    std::vector<double> windowValues(const std::vector<double> &termMeans) const override;
+
+    int spatialAlignmentCrop() const override;
+
+    /* Copies of both luma planes, the windows are converted one at a time */
+    std::size_t scratchBytesPerPixel() const override {
+        return 2;
+    };
+
+    std::size_t perFrameBytes() const override {
+        return sizeof(double);
+    };
+
+protected:
+    void configure(const opts::variables_map &vm) override;
 
 private:
     bool enableSpatialAlignment;
-    double ssimAccum;
-    int framesCalculated;
+    std::vector<double> ssimValues;
 
     double ssimWindow(cv::Mat &src, cv::Mat &pvs);
 
-    void addFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame);
+    double frameSsim(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame);
 
     double calcSsim();
 };
@@ -0,0 +1,194 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/program_options/variables_map.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <cmath>
+#include <vector>
+
+#include "VIF.h"
+
+
+VIF::VIF()
+        : ParallelFullReferenceAlgorithm("VIF") {
+    options.add_options()("disable-spatial-alignment", "Disable spatial alignment");
+
+    /* Scale s uses an N x N Gaussian with N = 2^(NUM_SCALES - s) + 1 and sigma N / 5 */
+    for (int s = 0; s < NUM_SCALES; s++) {
+        int n = (1 << (NUM_SCALES - s)) + 1;
+        kernels[s] = cv::getGaussianKernel(n, n / 5.0, CV_32F);
+    }
+}
+
+void VIF::configure(const opts::variables_map &vm) {
+    ParallelFullReferenceAlgorithm::configure(vm);
+
+    enableSpatialAlignment = !static_cast<bool>(vm.count("disable-spatial-alignment"));
+}
+
+int VIF::spatialAlignmentCrop() const {
+    return enableSpatialAlignment ? 4 : 0;
+}
+
+void VIF::initAnalysis() {
+    frameTerms.assign(sequenceLength, ScaleTerms());
+}
+
+void VIF::analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                        std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) {
+    if (enableSpatialAlignment) {
+        int crop = 4;
+        cv::Point2i sptialOffset = spatialAlignment->frameOffset(srcCurr, pvsCurr, crop, t);
+        spatialAlignment->cropAndAlign(srcCurr, pvsCurr, crop, sptialOffset);
+    }
+
+    addFrame(srcCurr, pvsCurr, t);
+}
+
+std::vector<double> VIF::finishAnalysis() {
+    /* VIF, then numerator and denominator of every scale (finest first), averaged over frames */
+    double frames = static_cast<double>(frameTerms.size());
+    std::vector<double> values(1 + 2 * NUM_SCALES, 0.0);
+    for (auto &terms : frameTerms) {
+        double num = 0.0, den = 0.0;
+        for (int s = 0; s < NUM_SCALES; s++) {
+            num += terms.num[s];
+            den += terms.den[s];
+            values[1 + 2 * s] += terms.num[s] / frames;
+            values[2 + 2 * s] += terms.den[s] / frames;
+        }
+        values[0] += (den > 0.0 ? num / den : 1.0) / frames;
+    }
+    for (int s = 0; s < NUM_SCALES; s++) {
+        logger(DEBUG) << "Scale " << s << " numerator: " << values[1 + 2 * s]
+                      << ", denominator: " << values[2 + 2 * s];
+    }
+
+    logger(INFO) << "VIF: " << values[0];
+    return values;
+}
+
+std::vector<std::string> VIF::valueNames() const {
+    std::vector<std::string> names(1, "vif");
+    for (int s = 0; s < NUM_SCALES; s++) {
+        names.push_back("vif_num_" + std::to_string(s));
+        names.push_back("vif_den_" + std::to_string(s));
+    }
+    return names;
+}
+
+void VIF::addFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame, unsigned t) {
+    cv::Mat src, pvs;
+    srcFrame->Y.convertTo(src, CV_32F);
+    pvsFrame->Y.convertTo(pvs, CV_32F);
+
+    for (int s = 0; s < NUM_SCALES; s++) {
+        if (s > 0) {
+            cv::Mat srcFiltered, pvsFiltered;
+            filterValid(src, srcFiltered, kernels[s]);
+            filterValid(pvs, pvsFiltered, kernels[s]);
+            subsample(srcFiltered, src);
+            subsample(pvsFiltered, pvs);
+        }
+        accumulateScale(src, pvs, kernels[s], frameTerms[t].num[s], frameTerms[t].den[s]);
+    }
+}
+
+void VIF::filterValid(const cv::Mat &in, cv::Mat &out, const cv::Mat &kernel) {
+    int border = kernel.rows / 2;
+    cv::Mat filtered;
+    cv::sepFilter2D(in, filtered, CV_32F, kernel, kernel);
+    out = filtered(cv::Rect(border, border, in.cols - 2 * border, in.rows - 2 * border));
+}
+
+void VIF::subsample(const cv::Mat &in, cv::Mat &out) {
+    cv::Mat result((in.rows + 1) / 2, (in.cols + 1) / 2, CV_32F);
+    for (int row = 0; row < result.rows; row++) {
+        const float *src = in.ptr<float>(2 * row);
+        float *dst = result.ptr<float>(row);
+        for (int col = 0; col < result.cols; col++) {
+            dst[col] = src[2 * col];
+        }
+    }
+    out = result;
+}
+
+void VIF::accumulateScale(const cv::Mat &src, const cv::Mat &pvs, const cv::Mat &kernel, double &num, double &den) {
+    const float sigmaNsq = 2.0f;
+    const float eps = 1e-10f;
+
+    cv::Mat srcSq, pvsSq, srcPvs;
+    cv::multiply(src, src, srcSq);
+    cv::multiply(pvs, pvs, pvsSq);
+    cv::multiply(src, pvs, srcPvs);
+
+    cv::Mat mu1, mu2, e11, e22, e12;
+    filterValid(src, mu1, kernel);
+    filterValid(pvs, mu2, kernel);
+    filterValid(srcSq, e11, kernel);
+    filterValid(pvsSq, e22, kernel);
+    filterValid(srcPvs, e12, kernel);
+
+    /*
+     * Local variances, gain and residual noise variance are derived row by row without branches, so the
+     * compiler can vectorize them. Instead of two log1p per pixel, the factors 1 + x are multiplied up in
+     * doubles and the exponent is moved out whenever the product passes 2^500; a factor is at most FLT_MAX,
+     * so the product stays finite
+     */
+    const double renormalizeAbove = std::ldexp(1.0, 500);
+    std::vector<float> numTerms(mu1.cols), denTerms(mu1.cols);
+    double numProduct = 1.0, denProduct = 1.0;
+    int numExponent = 0, denExponent = 0;
+    for (int row = 0; row < mu1.rows; row++) {
+        const float *m1 = mu1.ptr<float>(row), *m2 = mu2.ptr<float>(row);
+        const float *s11 = e11.ptr<float>(row), *s22 = e22.ptr<float>(row), *s12 = e12.ptr<float>(row);
+        float *numRow = numTerms.data(), *denRow = denTerms.data();
+        for (int col = 0; col < mu1.cols; col++) {
+            float sigma1Sq = std::max(s11[col] - m1[col] * m1[col], 0.0f);
+            float sigma2Sq = std::max(s22[col] - m2[col] * m2[col], 0.0f);
+            float sigma12 = s12[col] - m1[col] * m2[col];
+            sigma1Sq = sigma1Sq < eps ? 0.0f : sigma1Sq;
+
+            /* Flat SRC or PVS, or a negative gain, leave no information in the PVS */
+            float g = sigma12 / (sigma1Sq + eps);
+            float svSq = std::max(sigma2Sq - g * sigma12, eps);
+            bool informative = sigma1Sq >= eps && sigma2Sq >= eps && g >= 0.0f;
+
+            numRow[col] = informative ? g * g * sigma1Sq / (svSq + sigmaNsq) : 0.0f;
+            denRow[col] = sigma1Sq / sigmaNsq;
+        }
+        for (int col = 0; col < mu1.cols; col++) {
+            numProduct *= 1.0 + numRow[col];
+            denProduct *= 1.0 + denRow[col];
+            if (numProduct > renormalizeAbove) {
+                int e;
+                numProduct = std::frexp(numProduct, &e);
+                numExponent += e;
+            }
+            if (denProduct > renormalizeAbove) {
+                int e;
+                denProduct = std::frexp(denProduct, &e);
+                denExponent += e;
+            }
+        }
+    }
+
+    /* log10(1 + x) summed, with the change of base applied once per scale */
+    num = (std::log(numProduct) + numExponent * std::log(2.0)) / std::log(10.0);
+    den = (std::log(denProduct) + denExponent * std::log(2.0)) / std::log(10.0);
+}
@@ -0,0 +1,69 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIF_H
+#define VIF_H
+
+#include <array>
+#include <vector>
+
+#include <io/Frame.h>
+#include "metrics/Algorithm.h"
+
+/* Pixel-domain Visual Information Fidelity (Sheikh and Bovik), multi-scale variant */
+class VIF : public ParallelFullReferenceAlgorithm {
+public:
+    static const int NUM_SCALES = 4;
+
+    VIF();
+
+    void initAnalysis() override;
+
+    void analysisFrame(std::shared_ptr<Frame> srcCurr, std::shared_ptr<Frame> pvsCurr,
+                       std::shared_ptr<Frame> srcPrev, std::shared_ptr<Frame> pvsPrev, unsigned t) override;
+
+    std::vector<double> finishAnalysis() override;
+
+    std::vector<std::string> valueNames() const override;
+
+    int spatialAlignmentCrop() const override;
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+private:
+    struct ScaleTerms {
+        std::array<double, NUM_SCALES> num;
+        std::array<double, NUM_SCALES> den;
+    };
+
+    bool enableSpatialAlignment;
+    std::vector<ScaleTerms> frameTerms;
+    std::array<cv::Mat, NUM_SCALES> kernels;
+
+    void addFrame(std::shared_ptr<const Frame> srcFrame, std::shared_ptr<const Frame> pvsFrame, unsigned t);
+
+    static void filterValid(const cv::Mat &in, cv::Mat &out, const cv::Mat &kernel);
+
+    static void subsample(const cv::Mat &in, cv::Mat &out);
+
+    static void accumulateScale(const cv::Mat &src, const cv::Mat &pvs, const cv::Mat &kernel,
+                                double &num, double &den);
+};
+
+#endif
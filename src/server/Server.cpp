@@ -0,0 +1,265 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/program_options/variables_map.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <boost/algorithm/string/join.hpp>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <io/Json.h>
+#include <metrics/Metrics.h>
+
+#include "Server.h"
+
+
+static std::string event(const std::string &id, const std::string &type, const std::string &fields = "") {
+    return "{" + Json::string("id") + ": " + Json::string(id) + ", " +
+           Json::string("event") + ": " + Json::string(type) + fields + "}\n";
+}
+
+Server::Server()
+        : Algorithm("Server") {
+    options.add_options()
+            ("socket", opts::value<std::string>(&socketPath)->required(), "Path of the Unix socket to listen on")
+            ("num_threads,j", opts::value<unsigned>(&threads)->default_value(std::thread::hardware_concurrency()),
+             "Number of worker threads shared by all jobs")
+            ("jobs", opts::value<unsigned>(&jobThreads)->default_value(2),
+             "Number of jobs set up and run at the same time")
+            ("max-queued", opts::value<unsigned>(&maxQueued)->default_value(64),
+             "Requests waiting for a job thread at most. Connections are not read while the queue is full")
+            ("memory-budget", opts::value<unsigned>(&memoryBudgetSize)->default_value(4096),
+             "Memory in MiB the running jobs are estimated to need at most. Further jobs wait for running ones")
+            ("feature-cache", opts::value<std::string>(&featureCacheDir),
+             "SRC feature cache directory of jobs that don't name one");
+}
+
+void Server::configure(const opts::variables_map &vm) {
+    memoryBudget.reset(new MemoryBudget(static_cast<std::size_t>(memoryBudgetSize) << 20));
+}
+
+void Server::init(int argc, const char **argv) {
+    parseOptions(argc, argv);
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path is too long: " + socketPath);
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    /* A socket left behind by an earlier server would make bind() fail */
+    unlink(socketPath.c_str());
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        listen(listenFd, SOMAXCONN) < 0) {
+        throw std::runtime_error("Could not listen on " + socketPath + ": " + std::strerror(errno));
+    }
+
+    ParallelFullReferenceAlgorithm::useSharedPool(std::make_shared<WorkerPool>(threads));
+    for (unsigned i = 0; i < std::max(jobThreads, 1u); i++) {
+        jobRunners.push_back(std::thread(&Server::runJobs, this));
+    }
+    logger(INFO) << "Listening on " << socketPath << " with " << jobRunners.size() << " job threads and "
+                 << threads << " worker threads";
+}
+
+Server::~Server() {
+    stopJobs();
+}
+
+int Server::run() {
+    for (;;) {
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            logger(ERROR) << "Could not accept connection: " << std::strerror(errno);
+            stopJobs();
+            return 1;
+        }
+        auto connection = std::make_shared<Connection>();
+        connection->fd = fd;
+        std::thread(&Server::serve, this, connection).detach();
+    }
+}
+
+void Server::serve(std::shared_ptr<Connection> connection) {
+    std::string buffer;
+    char chunk[4096];
+    ssize_t received;
+    while ((received = recv(connection->fd, chunk, sizeof(chunk), 0)) > 0 || (received < 0 && errno == EINTR)) {
+        if (received < 0)
+            continue;
+        buffer.append(chunk, static_cast<std::size_t>(received));
+        std::size_t end;
+        while ((end = buffer.find('\n')) != std::string::npos) {
+            std::string request = buffer.substr(0, end);
+            buffer.erase(0, end + 1);
+            if (request.find_first_not_of(" \t\r") != std::string::npos && !enqueue({connection, request})) {
+                connection->send(event("", "error", ", " + Json::string("message") + ": " +
+                                                    Json::string("Server is shutting down")));
+                return;
+            }
+        }
+    }
+    /* Queued jobs keep the connection open and still report until they are done */
+}
+
+bool Server::enqueue(Job job) {
+    std::unique_lock<std::mutex> l(queueMutex);
+    queueChanged.wait(l, [&] { return stopping || queue.size() < std::max(maxQueued, 1u); });
+    if (stopping)
+        return false;
+    queue.push_back(std::move(job));
+    queueChanged.notify_all();
+    return true;
+}
+
+void Server::runJobs() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> l(queueMutex);
+            queueChanged.wait(l, [&] { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;
+            job = std::move(queue.front());
+            queue.pop_front();
+            queueChanged.notify_all();
+        }
+        runJob(job.connection, job.request);
+    }
+}
+
+void Server::stopJobs() {
+    {
+        std::lock_guard<std::mutex> g(queueMutex);
+        stopping = true;
+        queueChanged.notify_all();
+    }
+    for (auto &runner : jobRunners) {
+        runner.join();
+    }
+    jobRunners.clear();
+}
+
+void Server::runJob(std::shared_ptr<Connection> connection, const std::string &request) {
+    std::string id;
+    std::string command;
+    std::vector<std::string> args;
+    try {
+        namespace pt = boost::property_tree;
+        pt::ptree tree;
+        std::istringstream in(request);
+        pt::read_json(in, tree);
+        id = tree.get<std::string>("id", "");
+        command = tree.get<std::string>("command");
+        for (auto &arg : tree.get_child("args", pt::ptree())) {
+            args.push_back(arg.second.get_value<std::string>());
+        }
+    } catch (std::exception &e) {
+        connection->send(event(id, "error", ", " + Json::string("message") + ": " +
+                                            Json::string(std::string("Invalid request: ") + e.what())));
+        return;
+    }
+    runJob(connection, id, command, args);
+}
+
+void Server::runJob(std::shared_ptr<Connection> connection, const std::string &id, const std::string &command,
+                    std::vector<std::string> args) {
+    std::size_t reserved = 0;
+    try {
+        if (command == "serve" || command == "batch" || command == "bench" || command == "generate" ||
+            command == "equivalence") {
+            throw std::runtime_error("Command can't be run as a job: " + command);
+        }
+        std::unique_ptr<Algorithm> algorithm = Metrics::getAlgorithm(command);
+
+        /* Caches are what lets a server skip work earlier jobs have done already */
+        if (!featureCacheDir.empty() && std::find(args.begin(), args.end(), "--feature-cache") == args.end()) {
+            args.insert(args.end(), {"--feature-cache", featureCacheDir});
+        }
+        if (!resultCacheDir.empty() && std::find(args.begin(), args.end(), "--result-cache") == args.end()) {
+            args.insert(args.end(), {"--result-cache", resultCacheDir});
+        }
+        args.insert(args.begin(), "openvq");
+        std::vector<const char *> argv;
+        for (auto &arg : args) {
+            argv.push_back(arg.c_str());
+        }
+
+        algorithm->setResultListener([&](const ResultRecord &record) {
+            std::ostringstream fields;
+            fields << ", " << Json::string("identifier") << ": " << Json::string(record.identifier)
+                   << ", " << Json::string("values") << ": {";
+            for (unsigned i = 0; i < record.values.size(); i++) {
+                fields << (i ? ", " : "")
+                       << Json::string(i < record.names.size() ? record.names[i] : std::to_string(i))
+                       << ": " << Json::number(record.values[i]);
+            }
+            fields << "}";
+            connection->send(event(id, "result", fields.str()));
+        });
+        int lastPercent = -1;
+        Logger::setProgressListener([&](int progress, int length) {
+            int percent = length > 0 ? progress * 100 / length : 100;
+            if (percent != lastPercent) {
+                lastPercent = percent;
+                connection->send(event(id, "progress", ", " + Json::string("percent") + ": " +
+                                                       std::to_string(percent)));
+            }
+        });
+
+        algorithm->init(static_cast<int>(argv.size()), argv.data());
+        reserved = memoryBudget->acquire(algorithm->memoryEstimate());
+        connection->send(event(id, "started"));
+        logger(INFO) << "Job " << id << ": " << boost::algorithm::join(args, " ");
+
+        int ret = algorithm->run();
+        connection->send(event(id, "done", ", " + Json::string("exit") + ": " + std::to_string(ret)));
+    } catch (std::exception &e) {
+        connection->send(event(id, "error", ", " + Json::string("message") + ": " + Json::string(e.what())));
+    }
+    memoryBudget->release(reserved);
+    Logger::setProgressListener(nullptr);
+}
+
+Server::Connection::~Connection() {
+    close(fd);
+}
+
+void Server::Connection::send(const std::string &line) {
+    std::lock_guard<std::mutex> g(sendMutex);
+    std::size_t sent = 0;
+    while (sent < line.size()) {
+        ssize_t n = ::send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return; // The client went away, the job still finishes and fills the caches
+        sent += static_cast<std::size_t>(n);
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the video quality assessment toolkit OpenVQ
+ *
+ * Copyright (C) 2015 Henrik Bjørlo, Kristian Skarseth, Carsten Griwodz
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License version 3
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SERVER_H
+#define __SERVER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <metrics/Algorithm.h>
+#include <metrics/common/pool/MemoryBudget.h>
+
+/*
+ * Long running openvq scoring jobs sent over a Unix socket. Each line a client writes is a JSON request
+ *   {"id": "...", "command": "opvq", "args": ["-s", "src.mp4", "-p", "pvs.mp4"]}
+ * and is answered by JSON event lines carrying the same id: "started", "progress", one "result" per
+ * scored PVS, then "done" with the exit code, or "error". Requests wait in a bounded queue for one of
+ * a fixed number of job threads, and a connection stops being read while the queue is full. Running jobs
+ * share one worker pool and are started once the memory they are estimated to need fits the budget.
+ */
+class Server : public Algorithm {
+public:
+    Server();
+
+    ~Server();
+
+    virtual void init(int argc, const char **argv) override;
+
+    int run() override;
+
+protected:
+    void configure(const opts::variables_map &vm) override;
+
+private:
+    struct Connection {
+        int fd;
+        std::mutex sendMutex;
+
+        ~Connection();
+
+        void send(const std::string &line);
+    };
+
+    struct Job {
+        std::shared_ptr<Connection> connection;
+        std::string request;
+    };
+
+    std::string socketPath;
+    unsigned threads;
+    unsigned jobThreads;
+    unsigned maxQueued;
+    unsigned memoryBudgetSize;
+    std::string featureCacheDir;
+    int listenFd = -1;
+    std::unique_ptr<MemoryBudget> memoryBudget;
+
+    std::vector<std::thread> jobRunners;
+    std::deque<Job> queue;
+    bool stopping = false;
+    std::mutex queueMutex;
+    std::condition_variable queueChanged;
+
+    void serve(std::shared_ptr<Connection> connection);
+
+    /* Blocks while the queue is full, false once the server is stopping */
+    bool enqueue(Job job);
+
+    void runJobs();
+
+    /* Lets the queued jobs finish and joins the job threads */
+    void stopJobs();
+
+    void runJob(std::shared_ptr<Connection> connection, const std::string &request);
+
+    void runJob(std::shared_ptr<Connection> connection, const std::string &id, const std::string &command,
+                std::vector<std::string> args);
+};
+
+#endif //__SERVER_H